@@ -15,11 +15,14 @@
  */
 
 #include <base/Common.h>
+#include <base/DTU.h>
+#include <base/stream/IStringStream.h>
 #include <base/util/Time.h>
 
 #include <m3/com/MemGate.h>
 #include <m3/stream/Standard.h>
 #include <m3/Syscalls.h>
+#include <m3/VPE.h>
 
 using namespace m3;
 
@@ -27,20 +30,56 @@ using namespace m3;
 #define WARMUP  50
 #define COUNT   100
 
-int main() {
+static cycles_t run_noops() {
     cycles_t total = 0;
 
     // do some warmup
     for(int i = 0; i < WARMUP; ++i)
         Syscalls::get().noop();
 
-    cout << "Starting...\n";
     for(int i = 0; i < COUNT; ++i) {
         cycles_t start = Time::start(0);
         Syscalls::get().noop();
         cycles_t end = Time::stop(0);
         total += end - start;
     }
-    cout << "Per syscall: " << (total / COUNT) << "\n";
+    return total / COUNT;
+}
+
+int main(int argc, char **argv) {
+    // optionally, let multiple VPEs issue syscalls concurrently
+    size_t vpes = argc > 1 ? IStringStream::read_from<size_t>(argv[1]) : 1;
+    if(vpes == 0) {
+        cerr << "Usage: " << argv[0] << " [<vpes>]\n";
+        return 1;
+    }
+
+    VPE *childs[vpes - 1];
+    for(size_t i = 0; i < vpes - 1; ++i) {
+        childs[i] = new VPE("syscaller");
+        if(Errors::last != Errors::NONE)
+            exitmsg("Unable to create VPE");
+        Errors::Code res = childs[i]->run([]() {
+            return static_cast<int>(run_noops());
+        });
+        if(res != Errors::NONE)
+            exitmsg("VPE::run failed");
+    }
+
+    cout << "Starting...\n";
+    cycles_t total = run_noops();
+    for(size_t i = 0; i < vpes - 1; ++i) {
+        total += static_cast<cycles_t>(childs[i]->wait());
+        delete childs[i];
+    }
+
+    if(vpes == 1)
+        cout << "Per syscall: " << total << "\n";
+    else
+        cout << "Per syscall (" << vpes << " VPEs): " << (total / vpes) << "\n";
+#if defined(__host__)
+    cout << "Waits: " << DTU::get().spin_hits() << " by spinning, "
+         << DTU::get().sleeps() << " by sleeping\n";
+#endif
     return 0;
 }
@@ -60,7 +60,30 @@ NOINLINE static void write() {
     }, 0x41) << "\n";
 }
 
+NOINLINE static void read_async() {
+    const size_t MAX_DEPTH = 16;
+    static char bufs[MAX_DEPTH][8192];
+
+    MemGate mgate = MemGate::create_global(8192 * MAX_DEPTH, MemGate::R);
+
+    for(size_t depth = 1; depth <= MAX_DEPTH; depth *= 2) {
+        Profile pr(2, 1);
+        cout << "2 MiB with 8K buf, depth " << depth << ": " << pr.run_with_id([&mgate, depth] {
+            MemGate::Ticket tickets[MAX_DEPTH];
+            size_t total = 0;
+            while(total < SIZE) {
+                for(size_t i = 0; i < depth; ++i)
+                    mgate.read_async(bufs[i], sizeof(bufs[i]), i * sizeof(bufs[i]), tickets[i]);
+                if(MemGate::wait_all(tickets, depth) != Errors::NONE)
+                    PANIC("read failed");
+                total += depth * sizeof(bufs[0]);
+            }
+        }, 0x42) << "\n";
+    }
+}
+
 void bmemgate() {
     RUN_BENCH(read);
     RUN_BENCH(write);
+    RUN_BENCH(read_async);
 }
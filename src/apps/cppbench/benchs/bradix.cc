@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/Common.h>
+#include <base/col/RadixTable.h>
+#include <base/col/Treap.h>
+#include <base/util/Profile.h>
+#include <base/Panic.h>
+
+#include <m3/stream/Standard.h>
+
+#include "../cppbench.h"
+
+using namespace m3;
+
+// compares the lookup of capabilities in a treap (as the kernel did before) and a radix table
+
+struct MyRItem : public TreapNode<MyRItem, uint32_t> {
+    explicit MyRItem()
+        : TreapNode(0),
+          val() {
+    }
+
+    uint32_t val;
+};
+
+// large enough for 100k entries
+typedef RadixTable<MyRItem, 9, 8> MyRadix;
+
+static const uint32_t SIZES[] = {10, 1000, 100000};
+static const uint32_t LOOKUPS = 1000;
+
+static MyRItem *items;
+
+static void check(MyRItem *item, uint32_t i) {
+    if(!item || item->val != i)
+        PANIC("Test failed: " << (item ? item->val : 0) << " != " << i);
+}
+
+NOINLINE static void find_treap() {
+    for(uint32_t size : SIZES) {
+        struct TreapFindRunner : public Runner {
+            explicit TreapFindRunner(uint32_t _size) : size(_size), treap() {
+                for(uint32_t i = 0; i < size; ++i)
+                    treap.insert(items + i);
+            }
+            ~TreapFindRunner() {
+                while(treap.remove_root() != nullptr)
+                    ;
+            }
+            void run() override {
+                for(uint32_t i = 0; i < LOOKUPS; ++i) {
+                    uint32_t key = (i * 7919) % size;
+                    check(treap.find(key), key);
+                }
+            }
+
+            uint32_t size;
+            Treap<MyRItem> treap;
+        };
+
+        Profile pr(30);
+        TreapFindRunner runner(size);
+        cout << size << "-elements, " << LOOKUPS << " lookups: "
+             << pr.runner_with_id(runner, 0x10) << "\n";
+    }
+}
+
+NOINLINE static void find_radix() {
+    for(uint32_t size : SIZES) {
+        struct RadixFindRunner : public Runner {
+            explicit RadixFindRunner(uint32_t _size) : size(_size), radix() {
+                for(uint32_t i = 0; i < size; ++i)
+                    radix.insert(i, items + i);
+            }
+            void run() override {
+                for(uint32_t i = 0; i < LOOKUPS; ++i) {
+                    uint32_t key = (i * 7919) % size;
+                    check(radix.find(key), key);
+                }
+            }
+
+            uint32_t size;
+            MyRadix radix;
+        };
+
+        Profile pr(30);
+        RadixFindRunner runner(size);
+        cout << size << "-elements, " << LOOKUPS << " lookups: "
+             << pr.runner_with_id(runner, 0x11) << "\n";
+    }
+}
+
+NOINLINE static void range_treap() {
+    for(uint32_t size : SIZES) {
+        struct TreapRangeRunner : public Runner {
+            explicit TreapRangeRunner(uint32_t _size) : size(_size), treap() {
+                for(uint32_t i = 0; i < size; ++i)
+                    treap.insert(items + i);
+            }
+            ~TreapRangeRunner() {
+                while(treap.remove_root() != nullptr)
+                    ;
+            }
+            void run() override {
+                // like CapTable::range_unused before: one lookup per selector
+                for(uint32_t i = size; i < size + LOOKUPS; ++i) {
+                    if(treap.find(i) != nullptr)
+                        PANIC("Test failed: " << i << " is used");
+                }
+            }
+
+            uint32_t size;
+            Treap<MyRItem> treap;
+        };
+
+        Profile pr(30);
+        TreapRangeRunner runner(size);
+        cout << size << "-elements, " << LOOKUPS << " selectors: "
+             << pr.runner_with_id(runner, 0x12) << "\n";
+    }
+}
+
+NOINLINE static void range_radix() {
+    for(uint32_t size : SIZES) {
+        struct RadixRangeRunner : public Runner {
+            explicit RadixRangeRunner(uint32_t _size) : size(_size), radix() {
+                for(uint32_t i = 0; i < size; ++i)
+                    radix.insert(i, items + i);
+            }
+            void run() override {
+                if(!radix.range_free(size, LOOKUPS))
+                    PANIC("Test failed: range is used");
+            }
+
+            uint32_t size;
+            MyRadix radix;
+        };
+
+        Profile pr(30);
+        RadixRangeRunner runner(size);
+        cout << size << "-elements, " << LOOKUPS << " selectors: "
+             << pr.runner_with_id(runner, 0x13) << "\n";
+    }
+}
+
+void bradix() {
+    items = new MyRItem[SIZES[ARRAY_SIZE(SIZES) - 1]];
+    for(uint32_t i = 0; i < SIZES[ARRAY_SIZE(SIZES) - 1]; ++i) {
+        items[i].key(i);
+        items[i].val = i;
+    }
+
+    RUN_BENCH(find_treap);
+    RUN_BENCH(find_radix);
+    RUN_BENCH(range_treap);
+    RUN_BENCH(range_radix);
+
+    delete[] items;
+}
@@ -37,6 +37,11 @@ NOINLINE static void noop() {
         if(Errors::occurred())
             PANIC("syscall failed");
     }, 0x50) << "\n";
+
+#if defined(__host__)
+    cout << "waits: " << DTU::get().spin_hits() << " by spinning, "
+         << DTU::get().sleeps() << " by sleeping\n";
+#endif
 }
 
 NOINLINE static void activate() {
@@ -243,6 +248,69 @@ NOINLINE static void revoke() {
     cout << pr.runner_with_id(runner, 0x5A) << "\n";
 }
 
+NOINLINE static void batch() {
+    struct SyscallBatchRunner : public Runner {
+        explicit SyscallBatchRunner() : sels(VPE::self().alloc_sels(2)) {
+        }
+        void run() override {
+            Syscalls::Batch b;
+            b.creatergate(sels + 0, 10, 10)
+             .createsgate(sels + 1, sels + 0, 0x1234, 1024);
+            Syscalls::get().batch(b);
+            if(Errors::occurred())
+                PANIC("syscall failed");
+        }
+        void post() override {
+            Syscalls::get().revoke(0, KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sels, 2), true);
+        }
+
+        capsel_t sels;
+    };
+
+    Profile pr;
+    SyscallBatchRunner runner;
+    cout << pr.runner_with_id(runner, 0x5B) << "\n";
+}
+
+template<bool CHAIN>
+struct SyscallRevokeTreeRunner : public Runner {
+    static const size_t CAPS = 64;
+
+    explicit SyscallRevokeTreeRunner() : sels(VPE::self().alloc_sels(CAPS + 1)) {
+    }
+    void pre() override {
+        Syscalls::get().createmgate(sels, static_cast<uintptr_t>(~0), 0x1000, MemGate::RW);
+        // either derive each cap from the previous one or all from the first one
+        for(capsel_t i = 1; i <= CAPS; ++i) {
+            capsel_t parent = CHAIN ? sels + i - 1 : sels;
+            Syscalls::get().derivemem(sels + i, parent, 0, 0x1000, MemGate::RW);
+            if(Errors::occurred())
+                PANIC("syscall failed");
+        }
+    }
+    void run() override {
+        Syscalls::get().revoke(0, KIF::CapRngDesc(KIF::CapRngDesc::OBJ, sels, 1), true);
+        if(Errors::occurred())
+            PANIC("syscall failed");
+    }
+
+    capsel_t sels;
+};
+
+NOINLINE static void revoke_chain() {
+    Profile pr(20, 2);
+    SyscallRevokeTreeRunner<true> runner;
+    Results res = pr.runner_with_id(runner, 0x5C);
+    cout << res << " (" << (res.avg() / (runner.CAPS + 1)) << " cycles/cap)\n";
+}
+
+NOINLINE static void revoke_fan() {
+    Profile pr(20, 2);
+    SyscallRevokeTreeRunner<false> runner;
+    Results res = pr.runner_with_id(runner, 0x5D);
+    cout << res << " (" << (res.avg() / (runner.CAPS + 1)) << " cycles/cap)\n";
+}
+
 void bsyscall() {
     selector = VPE::self().alloc_sel();
 
@@ -257,4 +325,7 @@ void bsyscall() {
     RUN_BENCH(derive_mem);
     RUN_BENCH(exchange);
     RUN_BENCH(revoke);
+    RUN_BENCH(batch);
+    RUN_BENCH(revoke_chain);
+    RUN_BENCH(revoke_fan);
 }
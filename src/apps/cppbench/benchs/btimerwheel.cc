@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/Common.h>
+#include <base/col/SList.h>
+#include <base/col/TimerWheel.h>
+#include <base/util/Profile.h>
+#include <base/Panic.h>
+
+#include <m3/stream/Standard.h>
+
+#include "../cppbench.h"
+
+using namespace m3;
+
+// stresses the kernel's timeout management with many concurrent timeouts: all timeouts are armed,
+// every second one is canceled and the remaining ones are triggered while time advances
+
+static const size_t TIMEOUTS    = 4096;
+static const cycles_t MAX_DELAY = 1000000;
+static const cycles_t STEP      = 10000;
+
+struct MyWItem : public TimerWheelItem<MyWItem> {
+    explicit MyWItem(cycles_t when) : TimerWheelItem(when) {
+    }
+};
+
+struct MySItem : public SListItem {
+    explicit MySItem(cycles_t _when) : SListItem(), when(_when) {
+    }
+
+    cycles_t when;
+};
+
+static cycles_t delay(size_t i) {
+    return (i * 7919) % MAX_DELAY;
+}
+
+NOINLINE static void sorted_list() {
+    struct ListRunner : public Runner {
+        void run() override {
+            // insert in ascending order, like the kernel did before
+            for(size_t i = 0; i < TIMEOUTS; ++i) {
+                items[i] = new MySItem(delay(i));
+                MySItem *prev = nullptr;
+                for(auto it = list.begin(); it != list.end(); ++it) {
+                    if(it->when >= items[i]->when)
+                        break;
+                    prev = &*it;
+                }
+                list.insert(prev, items[i]);
+            }
+
+            for(size_t i = 0; i < TIMEOUTS; i += 2) {
+                list.remove(items[i]);
+                delete items[i];
+            }
+
+            size_t fired = 0;
+            for(cycles_t now = 0; list.length() > 0; now += STEP) {
+                while(list.length() > 0 && list.begin()->when <= now) {
+                    delete list.remove_first();
+                    fired++;
+                }
+            }
+            if(fired != TIMEOUTS / 2)
+                PANIC("Test failed: " << fired << " != " << (TIMEOUTS / 2));
+        }
+
+        MySItem *items[TIMEOUTS];
+        SList<MySItem> list;
+    };
+
+    Profile pr(10, 2);
+    ListRunner *runner = new ListRunner();
+    cout << TIMEOUTS << " timeouts: " << pr.runner_with_id(*runner, 0x20) << "\n";
+    delete runner;
+}
+
+NOINLINE static void timer_wheel() {
+    struct WheelRunner : public Runner {
+        explicit WheelRunner() : base(), wheel() {
+        }
+
+        void run() override {
+            for(size_t i = 0; i < TIMEOUTS; ++i) {
+                items[i] = new MyWItem(base + delay(i));
+                wheel.insert(items[i]);
+            }
+
+            for(size_t i = 0; i < TIMEOUTS; i += 2) {
+                wheel.remove(items[i]);
+                delete items[i];
+            }
+
+            size_t fired = 0;
+            cycles_t now = base;
+            for(; wheel.length() > 0; now += STEP) {
+                MyWItem *item;
+                while((item = wheel.pop_due(now)) != nullptr) {
+                    delete item;
+                    fired++;
+                }
+            }
+            if(fired != TIMEOUTS / 2)
+                PANIC("Test failed: " << fired << " != " << (TIMEOUTS / 2));
+            // the wheel does not support going back in time
+            base = now;
+        }
+
+        cycles_t base;
+        MyWItem *items[TIMEOUTS];
+        TimerWheel<MyWItem> wheel;
+    };
+
+    Profile pr(10, 2);
+    WheelRunner *runner = new WheelRunner();
+    cout << TIMEOUTS << " timeouts: " << pr.runner_with_id(*runner, 0x21) << "\n";
+    delete runner;
+}
+
+void btimerwheel() {
+    RUN_BENCH(sorted_list);
+    RUN_BENCH(timer_wheel);
+}
@@ -22,6 +22,8 @@ int main() {
     RUN_SUITE(bdlist);
     RUN_SUITE(bslist);
     RUN_SUITE(btreap);
+    RUN_SUITE(bradix);
+    RUN_SUITE(btimerwheel);
     RUN_SUITE(bregfile);
     RUN_SUITE(bmemgate);
     RUN_SUITE(bsyscall);
@@ -27,6 +27,8 @@
 void bslist();
 void bdlist();
 void btreap();
+void bradix();
+void btimerwheel();
 void bfsmeta();
 void bregfile();
 void bmemgate();
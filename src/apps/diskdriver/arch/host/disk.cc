@@ -28,7 +28,11 @@
 
 using namespace m3;
 
+// the amount of data that is transferred at once
+static const size_t BUF_SIZE    = 32 * 1024;
+
 static int disk_fd      = -1;
+static char buffer[BUF_SIZE];
 static off_t disk_size  = 0;
 static sPartition parts[PARTITION_COUNT];
 
@@ -76,10 +80,9 @@ void disk_read(size_t dev, MemGate &mem, size_t memoff, size_t offset, size_t co
 
     offset += part->start * 512;
 
-    char buffer[4096];
     SLOG(IDE_ALL, "Reading " << count << " bytes @ " << offset << " from device " << dev);
     while(count > 0) {
-        size_t amount = Math::min(static_cast<size_t>(count), sizeof(buffer));
+        size_t amount = Math::min(count, BUF_SIZE);
         pread(disk_fd, buffer, amount, static_cast<off_t>(offset));
         mem.write(buffer, amount, memoff);
 
@@ -100,10 +103,9 @@ void disk_write(size_t dev, MemGate &mem, size_t memoff, size_t offset, size_t c
 
     offset += part->start * 512;
 
-    char buffer[4096];
     SLOG(IDE_ALL, "Writing " << count << " bytes @ " << offset << " to device " << dev);
     while(count > 0) {
-        size_t amount = Math::min(static_cast<size_t>(count), sizeof(buffer));
+        size_t amount = Math::min(count, BUF_SIZE);
         mem.read(buffer, amount, memoff);
         pwrite(disk_fd, buffer, amount, static_cast<off_t>(offset));
 
@@ -31,6 +31,8 @@
 #include "WorkLoop.h"
 
 #if defined(__host__)
+#   include "arch/host/SyscallWorkers.h"
+
 extern int int_target;
 #endif
 
@@ -38,6 +40,7 @@ namespace kernel {
 
 ulong SyscallHandler::_vpes_per_ep[SyscallHandler::SYSC_REP_COUNT];
 SyscallHandler::handler_func SyscallHandler::_callbacks[m3::KIF::Syscall::COUNT];
+SyscallHandler::BatchCall *SyscallHandler::_batch_calls;
 
 #define LOG_SYS(vpe, sysname, expr)                                                         \
         KLOG(SYSC, (vpe)->id() << ":" << (vpe)->name() << "@" << m3::fmt((vpe)->pe(), "X")  \
@@ -67,7 +70,7 @@ void SyscallHandler::init() {
     // configure both receive buffers (we need to do that manually in the kernel)
     // TODO we also need to make sure that a VPE's syscall slot isn't in use if we suspend it
     for(size_t i = 0; i < SYSC_REP_COUNT; ++i) {
-        int buford = m3::getnextlog2(32) + VPE::SYSC_MSGSIZE_ORD;
+        int buford = m3::getnextlog2(SYSC_REP_SLOTS) + VPE::SYSC_MSGSIZE_ORD;
         size_t bufsize = static_cast<size_t>(1) << buford;
         DTU::get().recv_msgs(ep(i),reinterpret_cast<uintptr_t>(new uint8_t[bufsize]),
             buford, VPE::SYSC_MSGSIZE_ORD);
@@ -106,9 +109,25 @@ void SyscallHandler::init() {
     add_operation(m3::KIF::Syscall::FORWARD_MEM,    &SyscallHandler::forwardmem);
     add_operation(m3::KIF::Syscall::FORWARD_REPLY,  &SyscallHandler::forwardreply);
     add_operation(m3::KIF::Syscall::NOOP,           &SyscallHandler::noop);
+    add_operation(m3::KIF::Syscall::BATCH,          &SyscallHandler::batch);
 }
 
 void SyscallHandler::reply_msg(VPE *vpe, const m3::DTU::Message *msg, const void *reply, size_t size) {
+#if defined(__host__)
+    // the workers leave the replies to the WorkLoop
+    if(SyscallWorkers::capture(msg, reply))
+        return;
+#endif
+
+    // the replies to calls of a BATCH request are collected and sent at once
+    for(BatchCall *call = _batch_calls; call != nullptr; call = call->next) {
+        if(call->msg == msg) {
+            call->res = static_cast<m3::Errors::Code>(
+                static_cast<const m3::KIF::DefaultReply*>(reply)->error);
+            return;
+        }
+    }
+
     while(vpe->state() != VPE::RUNNING) {
         if(!vpe->resume(false))
             return;
@@ -1204,4 +1223,106 @@ void SyscallHandler::noop(VPE *vpe, const m3::DTU::Message *msg) {
     reply_result(vpe, msg, m3::Errors::NONE);
 }
 
+bool SyscallHandler::is_batchable(m3::KIF::Syscall::Operation op) {
+    switch(op) {
+        // all calls that only reply an error code and don't reply asynchronously
+        case m3::KIF::Syscall::CREATE_SRV:
+        case m3::KIF::Syscall::CREATE_SESS:
+        case m3::KIF::Syscall::CREATE_RGATE:
+        case m3::KIF::Syscall::CREATE_SGATE:
+        case m3::KIF::Syscall::CREATE_MGATE:
+        case m3::KIF::Syscall::CREATE_MAP:
+        case m3::KIF::Syscall::CREATE_VPEGRP:
+        case m3::KIF::Syscall::ACTIVATE:
+        case m3::KIF::Syscall::SRV_CTRL:
+        case m3::KIF::Syscall::DERIVE_MEM:
+        case m3::KIF::Syscall::OPEN_SESS:
+        case m3::KIF::Syscall::EXCHANGE:
+        case m3::KIF::Syscall::REVOKE:
+        case m3::KIF::Syscall::NOOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool SyscallHandler::is_parallel(m3::KIF::Syscall::Operation op) {
+    switch(op) {
+        // all calls that only touch the capability table of the calling VPE
+        case m3::KIF::Syscall::CREATE_RGATE:
+        case m3::KIF::Syscall::CREATE_SGATE:
+        case m3::KIF::Syscall::DERIVE_MEM:
+        case m3::KIF::Syscall::NOOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+m3::Errors::Code SyscallHandler::execute_batched(VPE *vpe, const m3::DTU::Message *msg) {
+    // the handler might block, so that other batches can be executed in the meantime
+    BatchCall call = {msg, m3::Errors::NONE, _batch_calls};
+    _batch_calls = &call;
+
+    auto req = get_message<m3::KIF::DefaultRequest>(msg);
+    _callbacks[req->opcode](vpe, msg);
+
+    BatchCall **prev = &_batch_calls;
+    while(*prev != &call)
+        prev = &(*prev)->next;
+    *prev = call.next;
+    return call.res;
+}
+
+void SyscallHandler::batch(VPE *vpe, const m3::DTU::Message *msg) {
+    auto req = get_message<m3::KIF::Syscall::Batch>(msg);
+    size_t count = req->count;
+    bool cont = req->flags & m3::KIF::Syscall::Batch::CONTINUE;
+
+    LOG_SYS(vpe, ": syscall::batch", "(count=" << count << ", flags=" << req->flags << ")");
+
+    if(count > m3::KIF::Syscall::MAX_BATCH)
+        SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Too many calls");
+
+    // the handlers expect a message, so that we build one for each call
+    union {
+        m3::DTU::Header head;
+        uint8_t bytes[sizeof(m3::DTU::Header) + sizeof(req->msgs)];
+    } callmsg;
+    memcpy(&callmsg.head, msg, sizeof(m3::DTU::Header));
+    auto call = reinterpret_cast<m3::DTU::Message*>(&callmsg);
+
+    m3::KIF::Syscall::BatchReply reply;
+    reply.error = m3::Errors::NONE;
+    reply.count = 0;
+
+    size_t off = 0;
+    while(reply.count < count) {
+        size_t size = off < ARRAY_SIZE(req->msgs) ? req->msgs[off] : 0;
+        size_t words = (size + sizeof(xfer_t) - 1) / sizeof(xfer_t);
+        if(size < sizeof(m3::KIF::DefaultRequest) || off + 1 + words > ARRAY_SIZE(req->msgs))
+            SYS_ERROR(vpe, msg, m3::Errors::INV_ARGS, "Invalid call " << reply.count);
+
+        memcpy(call->data, req->msgs + off + 1, size);
+        off += 1 + words;
+
+        auto op = static_cast<m3::KIF::Syscall::Operation>(
+            get_message<m3::KIF::DefaultRequest>(call)->opcode);
+        m3::Errors::Code res = m3::Errors::NOT_SUP;
+        if(static_cast<size_t>(op) < ARRAY_SIZE(_callbacks) && is_batchable(op))
+            res = execute_batched(vpe, call);
+
+        reply.errors[reply.count++] = res;
+        if(res != m3::Errors::NONE) {
+            if(reply.error == m3::Errors::NONE)
+                reply.error = res;
+            if(!cont)
+                break;
+        }
+    }
+
+    size_t unused = m3::KIF::Syscall::MAX_BATCH - reply.count;
+    reply_msg(vpe, msg, &reply, sizeof(reply) - unused * sizeof(xfer_t));
+}
+
 }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <base/Config.h>
 #include <base/KIF.h>
 #include <base/DTU.h>
 
@@ -24,12 +25,22 @@ namespace kernel {
 class VPE;
 
 class SyscallHandler {
+    friend class SyscallWorkers;
+
     SyscallHandler() = delete;
 
     using handler_func = void (*)(VPE *vpe, const m3::DTU::Message *msg);
 
+    // a call of a BATCH request that is currently executed
+    struct BatchCall {
+        const m3::DTU::Message *msg;
+        m3::Errors::Code res;
+        BatchCall *next;
+    };
+
 public:
-    static const size_t SYSC_REP_COUNT = 2;
+    static const size_t SYSC_REP_COUNT = KERNEL_SYSC_REPS;
+    static const size_t SYSC_REP_SLOTS = KERNEL_SYSC_SLOTS;
 
     static void init();
 
@@ -42,13 +53,16 @@ public:
     }
 
     static epid_t alloc_ep() {
-        for(size_t i = 0; i < SYSC_REP_COUNT; ++i) {
-            if(_vpes_per_ep[i] < 32) {
-                _vpes_per_ep[i]++;
-                return ep(i);
-            }
+        // spread the VPEs evenly over all EPs to keep the receive buffers short
+        size_t min = 0;
+        for(size_t i = 1; i < SYSC_REP_COUNT; ++i) {
+            if(_vpes_per_ep[i] < _vpes_per_ep[min])
+                min = i;
         }
-        return EP_COUNT;
+        if(_vpes_per_ep[min] == SYSC_REP_SLOTS)
+            return EP_COUNT;
+        _vpes_per_ep[min]++;
+        return ep(min);
     }
     static void free_ep(epid_t id) {
         _vpes_per_ep[id - ep(0)]--;
@@ -80,6 +94,7 @@ private:
     static void forwardmem(VPE *vpe, const m3::DTU::Message *msg);
     static void forwardreply(VPE *vpe, const m3::DTU::Message *msg);
     static void noop(VPE *vpe, const m3::DTU::Message *msg);
+    static void batch(VPE *vpe, const m3::DTU::Message *msg);
 
     static void add_operation(m3::KIF::Syscall::Operation op, handler_func func) {
         _callbacks[op] = func;
@@ -92,9 +107,13 @@ private:
     static m3::Errors::Code do_exchange(VPE *v1, VPE *v2, const m3::KIF::CapRngDesc &c1,
                                         const m3::KIF::CapRngDesc &c2, bool obtain);
     static void exchange_over_sess(VPE *vpe, const m3::DTU::Message *msg, bool obtain);
+    static bool is_batchable(m3::KIF::Syscall::Operation op);
+    static bool is_parallel(m3::KIF::Syscall::Operation op);
+    static m3::Errors::Code execute_batched(VPE *vpe, const m3::DTU::Message *msg);
 
     static ulong _vpes_per_ep[SYSC_REP_COUNT];
     static handler_func _callbacks[];
+    static BatchCall *_batch_calls;
 };
 
 }
@@ -20,12 +20,14 @@
 
 #include <thread/ThreadManager.h>
 
+#include "mem/SlabCache.h"
 #include "pes/Timeouts.h"
 #include "pes/VPEManager.h"
 #include "SyscallHandler.h"
 #include "WorkLoop.h"
 
 #if defined(__host__)
+#include "arch/host/SyscallWorkers.h"
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/time.h>
@@ -33,12 +35,18 @@
 
 static bool initialized = false;
 static int sigchilds = 0;
+static int sigstats = 0;
 
 static void sigchild(int) {
     sigchilds++;
     signal(SIGCHLD, sigchild);
 }
 
+static void sigusr2(int) {
+    sigstats++;
+    signal(SIGUSR2, sigusr2);
+}
+
 static void check_childs() {
     for(; sigchilds > 0; sigchilds--) {
         int status;
@@ -63,6 +71,9 @@ static void check_childs() {
 
 namespace kernel {
 
+// the maximum number of syscalls that are handled per receive EP and iteration
+static const size_t MAX_SYSC_PER_EP = 8;
+
 void WorkLoop::multithreaded(uint count) {
     for(uint i = 0; i < count; ++i)
         new m3::Thread(thread_startup, nullptr);
@@ -72,14 +83,17 @@ void WorkLoop::run() {
 #if defined(__host__)
     if(!initialized) {
         signal(SIGCHLD, sigchild);
+        // allow to dump the slab statistics on demand
+        signal(SIGUSR2, sigusr2);
         initialized = true;
     }
 #endif
 
     m3::DTU &dtu = m3::DTU::get();
-    static_assert(SyscallHandler::SYSC_REP_COUNT == 2, "Wrong SYSC_REP_COUNT");
-    epid_t sysep0 = SyscallHandler::ep(0);
-    epid_t sysep1 = SyscallHandler::ep(1);
+#if defined(__host__)
+    SyscallWorkers *workers = SyscallWorkers::get();
+#endif
+    static_assert(SyscallHandler::SYSC_REP_COUNT + 2 <= EP_COUNT, "Wrong SYSC_REP_COUNT");
     epid_t srvep = SyscallHandler::srvep();
     const m3::DTU::Message *msg;
     while(has_items()) {
@@ -88,21 +102,29 @@ void WorkLoop::run() {
             m3::DTU::get().try_sleep(false, sleep);
         Timeouts::get().trigger();
 
-        msg = dtu.fetch_msg(sysep0);
-        if(msg) {
-            // we know the subscriber here, so optimize that a bit
-            VPE *vpe = reinterpret_cast<VPE*>(msg->label);
-            SyscallHandler::handle_message(vpe, msg);
-            EVENT_TRACE_FLUSH_LIGHT();
+        for(size_t i = 0; i < SyscallHandler::SYSC_REP_COUNT; ++i) {
+            epid_t sysep = SyscallHandler::ep(i);
+            // handle multiple syscalls at once, but don't let one EP starve the others
+            for(size_t j = 0; j < MAX_SYSC_PER_EP && (msg = dtu.fetch_msg(sysep)); ++j) {
+                // we know the subscriber here, so optimize that a bit
+                VPE *vpe = reinterpret_cast<VPE*>(msg->label);
+#if defined(__host__)
+                if(workers) {
+                    if(workers->submit(vpe, msg))
+                        continue;
+                    // the other syscalls might change any VPE, so finish the submitted ones first
+                    workers->run_all();
+                }
+#endif
+                SyscallHandler::handle_message(vpe, msg);
+                EVENT_TRACE_FLUSH_LIGHT();
+            }
         }
 
-        msg = dtu.fetch_msg(sysep1);
-        if(msg) {
-            // we know the subscriber here, so optimize that a bit
-            VPE *vpe = reinterpret_cast<VPE*>(msg->label);
-            SyscallHandler::handle_message(vpe, msg);
-            EVENT_TRACE_FLUSH_LIGHT();
-        }
+#if defined(__host__)
+        if(workers)
+            workers->run_all();
+#endif
 
         msg = dtu.fetch_msg(srvep);
         if(msg) {
@@ -114,6 +136,10 @@ void WorkLoop::run() {
 
 #if defined(__host__)
         check_childs();
+        if(sigstats > 0) {
+            sigstats = 0;
+            KLOG(INFO, SlabCache::Stats());
+        }
 #endif
     }
 }
@@ -19,6 +19,7 @@
 #include <base/log/Kernel.h>
 
 #include "mem/MainMemory.h"
+#include "mem/SlabCache.h"
 #include "pes/PEManager.h"
 #include "pes/VPEManager.h"
 #include "SyscallHandler.h"
@@ -59,6 +60,7 @@ int main(int argc, char *argv[]) {
     EVENT_TRACE_FLUSH();
 
     KLOG(INFO, "Shutting down");
+    KLOG(SLAB, SlabCache::Stats());
 
     VPEManager::destroy();
 
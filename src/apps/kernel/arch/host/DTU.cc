@@ -87,6 +87,7 @@ void DTU::write_ep_local(epid_t ep) {
     uintptr_t eps = reinterpret_cast<uintptr_t>(m3::DTU::get().ep_regs());
     uintptr_t addr = eps + ep * m3::DTU::EPS_RCNT * sizeof(word_t);
     memcpy(reinterpret_cast<void*>(addr), _state.get_ep(ep), m3::DTU::EPS_RCNT * sizeof(word_t));
+    m3::DTU::get().clear_slots(ep);
 }
 
 void DTU::mark_read_remote(const VPEDesc &, epid_t, goff_t) {
@@ -14,11 +14,10 @@
  * General Public License version 2 for more details.
  */
 
+#include <base/arch/host/SharedMemory.h>
 #include <base/Config.h>
 #include <base/Init.h>
 
-#include <sys/mman.h>
-
 #include "mem/MainMemory.h"
 #include "DTU.h"
 #include "Platform.h"
@@ -38,9 +37,9 @@ Platform::KEnv::KEnv() {
 
     const size_t TOTAL_MEM   = 512 * 1024 * 1024;
 
-    // create memory
-    uintptr_t base = reinterpret_cast<uintptr_t>(
-        mmap(0, TOTAL_MEM, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0));
+    // create memory. it is shared with all PEs so that their DTUs can access it directly
+    static m3::SharedMemory shm("mem", TOTAL_MEM, m3::SharedMemory::CREATE);
+    uintptr_t base = reinterpret_cast<uintptr_t>(shm.addr());
 
     MainMemory &mem = MainMemory::get();
     mem.add(new MemoryModule(false, 0, base, FS_MAX_SIZE));
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#include <base/log/Kernel.h>
+#include <base/Panic.h>
+
+#include "mem/Slab.h"
+#include "pes/VPE.h"
+#include "SyscallHandler.h"
+#include "SyscallWorkers.h"
+
+namespace kernel {
+
+thread_local SyscallWorkers::Job *SyscallWorkers::_cur;
+SyscallWorkers *SyscallWorkers::_inst;
+
+void SyscallWorkers::create(uint count) {
+    _inst = new SyscallWorkers(count);
+}
+
+void SyscallWorkers::destroy() {
+    delete _inst;
+    _inst = nullptr;
+}
+
+SyscallWorkers::SyscallWorkers(uint count)
+    : _run(true),
+      _count(count),
+      _threads(new pthread_t[count]),
+      _mutex(PTHREAD_MUTEX_INITIALIZER),
+      _work(PTHREAD_COND_INITIALIZER),
+      _done(PTHREAD_COND_INITIALIZER),
+      _jobcount(),
+      _published(),
+      _next(),
+      _finished(),
+      _jobs() {
+    for(uint i = 0; i < count; ++i) {
+        if(pthread_create(_threads + i, nullptr, thread, this) != 0)
+            PANIC("Unable to create syscall worker");
+    }
+    KLOG(INFO, "Handling syscalls with " << count << " additional threads");
+}
+
+SyscallWorkers::~SyscallWorkers() {
+    pthread_mutex_lock(&_mutex);
+    _run = false;
+    pthread_cond_broadcast(&_work);
+    pthread_mutex_unlock(&_mutex);
+
+    for(uint i = 0; i < _count; ++i)
+        pthread_join(_threads[i], nullptr);
+    delete[] _threads;
+}
+
+bool SyscallWorkers::submit(VPE *vpe, const m3::DTU::Message *msg) {
+    auto req = reinterpret_cast<const m3::KIF::DefaultRequest*>(msg->data);
+    auto op = static_cast<m3::KIF::Syscall::Operation>(req->opcode);
+    // replying might require to resume the VPE, which has to be done by the WorkLoop
+    if(_jobcount == MAX_JOBS || !SyscallHandler::is_parallel(op) || vpe->state() != VPE::RUNNING)
+        return false;
+
+    Job *job = _jobs + _jobcount++;
+    job->vpe = vpe;
+    job->msg = msg;
+    job->res = m3::Errors::NONE;
+    return true;
+}
+
+void SyscallWorkers::run_all() {
+    if(_jobcount == 0)
+        return;
+
+    // wake up the workers only if there is something to share
+    pthread_mutex_lock(&_mutex);
+    _published = _jobcount;
+    _next = 0;
+    _finished = 0;
+    if(_jobcount > 1)
+        pthread_cond_broadcast(&_work);
+    pthread_mutex_unlock(&_mutex);
+
+    // help the workers and wait until all jobs are finished
+    while(run_one())
+        ;
+    pthread_mutex_lock(&_mutex);
+    while(_finished < _published)
+        pthread_cond_wait(&_done, &_mutex);
+    _published = _next = 0;
+    pthread_mutex_unlock(&_mutex);
+
+    for(size_t i = 0; i < _jobcount; ++i)
+        SyscallHandler::reply_result(_jobs[i].vpe, _jobs[i].msg, _jobs[i].res);
+    _jobcount = 0;
+}
+
+bool SyscallWorkers::capture(const m3::DTU::Message *msg, const void *reply) {
+    if(_cur == nullptr || _cur->msg != msg)
+        return false;
+    _cur->res = static_cast<m3::Errors::Code>(
+        static_cast<const m3::KIF::DefaultReply*>(reply)->error);
+    return true;
+}
+
+bool SyscallWorkers::run_one() {
+    pthread_mutex_lock(&_mutex);
+    if(_next == _published) {
+        pthread_mutex_unlock(&_mutex);
+        return false;
+    }
+    Job *job = _jobs + _next++;
+    pthread_mutex_unlock(&_mutex);
+
+    _cur = job;
+    SyscallHandler::handle_message(job->vpe, job->msg);
+    _cur = nullptr;
+
+    pthread_mutex_lock(&_mutex);
+    if(++_finished == _published)
+        pthread_cond_signal(&_done);
+    pthread_mutex_unlock(&_mutex);
+    return true;
+}
+
+void *SyscallWorkers::thread(void *arg) {
+    SyscallWorkers *w = static_cast<SyscallWorkers*>(arg);
+    while(true) {
+        pthread_mutex_lock(&w->_mutex);
+        while(w->_run && w->_next == w->_published)
+            pthread_cond_wait(&w->_work, &w->_mutex);
+        bool run = w->_run;
+        pthread_mutex_unlock(&w->_mutex);
+        if(!run)
+            break;
+
+        while(w->run_one())
+            ;
+    }
+    Slab::flush_thread();
+    return nullptr;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/Config.h>
+#include <base/DTU.h>
+
+#include <pthread.h>
+
+namespace kernel {
+
+class VPE;
+
+/**
+ * A pool of OS threads that handle syscalls in parallel. The WorkLoop submits the syscalls that
+ * only touch the capability tables of the calling VPE and afterwards runs all of them at once.
+ * Since each VPE can only have one outstanding syscall, the jobs are independent of each other
+ * and the WorkLoop does not run concurrently to them. Only the allocators and the reference
+ * counters are shared and therefore protected.
+ */
+class SyscallWorkers {
+    struct Job {
+        VPE *vpe;
+        const m3::DTU::Message *msg;
+        m3::Errors::Code res;
+    };
+
+    explicit SyscallWorkers(uint count);
+
+public:
+    // each VPE has at most one outstanding syscall
+    static const size_t MAX_JOBS    = KERNEL_SYSC_REPS * KERNEL_SYSC_SLOTS;
+
+    /**
+     * Starts <count> worker threads.
+     */
+    static void create(uint count);
+    static void destroy();
+
+    /**
+     * @return the instance or nullptr if syscalls are handled by the WorkLoop only
+     */
+    static SyscallWorkers *get() {
+        return _inst;
+    }
+
+    /**
+     * Takes over the given syscall, if it can be handled by a worker.
+     *
+     * @return true if it has been taken over
+     */
+    bool submit(VPE *vpe, const m3::DTU::Message *msg);
+
+    /**
+     * Handles all submitted syscalls, waits until they are finished and replies to them.
+     */
+    void run_all();
+
+    /**
+     * Stores the result for the syscall <msg>, if it is handled by the current thread.
+     *
+     * @return true if the result has been stored
+     */
+    static bool capture(const m3::DTU::Message *msg, const void *reply);
+
+private:
+    ~SyscallWorkers();
+
+    bool run_one();
+    static void *thread(void *arg);
+
+    bool _run;
+    uint _count;
+    pthread_t *_threads;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _work;
+    pthread_cond_t _done;
+    size_t _jobcount;
+    size_t _published;
+    size_t _next;
+    size_t _finished;
+    Job _jobs[MAX_JOBS];
+    static thread_local Job *_cur;
+    static SyscallWorkers *_inst;
+};
+
+}
@@ -23,6 +23,7 @@
 #include <cstring>
 #include <cerrno>
 
+#include "mem/MainMemory.h"
 #include "pes/VPEManager.h"
 #include "pes/VPE.h"
 #include "SyscallHandler.h"
@@ -38,6 +39,14 @@ static void write_env_file(epid_t ep, pid_t pid, peid_t pe, label_t label) {
     of << label << "\n";
     of << ep << "\n";
     of << (1 << VPE::SYSC_CREDIT_ORD) << "\n";
+
+    // the memory modules are contiguous in the shared main memory
+    MainMemory &mem = MainMemory::get();
+    size_t mem_size = 0;
+    for(size_t i = 0; i < mem.mod_count(); ++i)
+        mem_size += mem.module(i).size();
+    of << mem.module(0).addr() << "\n";
+    of << mem_size << "\n";
 }
 
 void VPE::init() {
@@ -30,12 +30,14 @@
 #include <dirent.h>
 #include <unistd.h>
 
+#include "mem/SlabCache.h"
 #include "pes/PEManager.h"
 #include "pes/VPEManager.h"
 #include "pes/VPE.h"
 #include "dev/TimerDevice.h"
 #include "dev/VGAConsole.h"
 #include "SyscallHandler.h"
+#include "SyscallWorkers.h"
 
 using namespace kernel;
 
@@ -99,6 +101,7 @@ static void copytofs(MainMemory &mem, const char *file) {
 
 int main(int argc, char *argv[]) {
     const char *fsimg = nullptr;
+    uint workers = 0;
     mkdir("/tmp/m3", 0755);
     signal(SIGINT, sigint);
 
@@ -109,6 +112,8 @@ int main(int argc, char *argv[]) {
             devices.append(new TimerDevice());
         else if(strncmp(argv[i], "fs=", 3) == 0)
             fsimg = argv[i] + 3;
+        else if(strncmp(argv[i], "workers=", 8) == 0)
+            workers = static_cast<uint>(strtoul(argv[i] + 8, nullptr, 0));
     }
 
     int argstart = 0;
@@ -127,6 +132,8 @@ int main(int argc, char *argv[]) {
     if(fsimg)
         copyfromfs(MainMemory::get(), fsimg);
     SyscallHandler::init();
+    if(workers > 0)
+        SyscallWorkers::create(workers);
     PEManager::create();
     VPEManager::create();
     VPEManager::get().init(argc - argstart - 1, argv + argstart + 1);
@@ -137,6 +144,8 @@ int main(int argc, char *argv[]) {
     m3::env()->workloop()->run();
 
     KLOG(INFO, "Shutting down");
+    SyscallWorkers::destroy();
+    KLOG(SLAB, SlabCache::Stats());
     if(fsimg)
         copytofs(MainMemory::get(), fsimg);
     VPEManager::destroy();
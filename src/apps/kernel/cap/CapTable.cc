@@ -20,21 +20,33 @@
 namespace kernel {
 
 void CapTable::revoke_all() {
+    // the radix table is walked in order of the selectors; revoking a cap only removes others
+    capsel_t pos = 0;
     Capability *c;
+    while((c = _radix.next(pos)) != nullptr) {
+        _radix.remove(pos);
+        revoke_one(c);
+    }
+
     // TODO it might be better to do that in a different order, because it is more expensive to
     // remove a node that has two childs (it requires a rotate). Thus, it would be better to start
     // with leaf nodes.
     while((c = static_cast<Capability*>(_caps.remove_root())) != nullptr) {
-        revoke(c, false);
-        // hack for self-referencing VPE capability. we can't dereference it here, because if we
-        // force-destruct a VPE, there might be other references, so that it breaks if we decrease
-        // the counter (the self-reference did not increase it).
-        if(c->sel() == 0)
-            static_cast<VPECapability*>(c)->obj.forget();
-        delete c;
+        _ranges--;
+        revoke_one(c);
     }
 }
 
+void CapTable::revoke_one(Capability *c) {
+    revoke(c, false);
+    // hack for self-referencing VPE capability. we can't dereference it here, because if we
+    // force-destruct a VPE, there might be other references, so that it breaks if we decrease
+    // the counter (the self-reference did not increase it).
+    if(c->sel() == 0)
+        static_cast<VPECapability*>(c)->obj.forget();
+    delete c;
+}
+
 Capability *CapTable::obtain(capsel_t dst, Capability *c) {
     Capability *nc = c;
     if(c) {
@@ -56,18 +68,34 @@ void CapTable::inherit(Capability *parent, Capability *child) {
     parent->_child = child;
 }
 
-void CapTable::revoke_rec(Capability *c, bool revnext) {
-    Capability *child = c->child();
-    Capability *next = c->next();
+void CapTable::revoke_tree(Capability *c, bool revnext) {
+    // on the first level, we don't want to revoke siblings
+    if(!revnext)
+        c->_next = nullptr;
 
-    c->revoke();
-    c->table()->unset(c->sel());
+    // we walk through the tree in pre-order without recursion, so that the kernel stack usage
+    // does not depend on the size of the tree. the work list consists of sibling lists: the first
+    // node of each list is the one to visit next and its _prev link points to the next list.
+    c->_prev = nullptr;
+    Capability *work = c;
+    while(work) {
+        c = work;
+        if(c->_next) {
+            c->_next->_prev = c->_prev;
+            work = c->_next;
+        }
+        else
+            work = c->_prev;
+        if(c->_child) {
+            c->_child->_prev = work;
+            work = c->_child;
+        }
 
-    if(child)
-        revoke_rec(child, true);
-    // on the first level, we don't want to revoke siblings
-    if(revnext && next)
-        revoke_rec(next, true);
+        // the caps have to be removed in this order, because the revoke hooks depend on the
+        // caps that still exist (e.g., the session's refcount)
+        c->revoke();
+        c->table()->unset(c->sel());
+    }
 }
 
 void CapTable::revoke(Capability *c, bool revnext) {
@@ -78,7 +106,7 @@ void CapTable::revoke(Capability *c, bool revnext) {
             c->_prev->_next = c->_next;
         if(c->_parent && c->_parent->_child == c)
             c->_parent->_child = revnext ? nullptr : c->_next;
-        revoke_rec(c, revnext);
+        revoke_tree(c, revnext);
     }
 }
 
@@ -95,6 +123,11 @@ void CapTable::revoke(const m3::KIF::CapRngDesc &crd, bool own) {
 
 m3::OStream &operator<<(m3::OStream &os, const CapTable &ct) {
     os << "CapTable[" << ct.id() << "]:\n";
+    capsel_t pos = 0;
+    for(const Capability *c; (c = ct._radix.next(pos)) != nullptr; ++pos) {
+        c->print(os);
+        os << "\n";
+    }
     ct._caps.print(os, false);
     return os;
 }
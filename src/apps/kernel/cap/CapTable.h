@@ -17,6 +17,7 @@
 #pragma once
 
 #include <base/Common.h>
+#include <base/col/RadixTable.h>
 #include <base/col/Treap.h>
 #include <base/KIF.h>
 
@@ -34,7 +35,9 @@ class CapTable {
 public:
     explicit CapTable(uint id)
         : _id(id),
-          _caps() {
+          _radix(),
+          _caps(),
+          _ranges() {
     }
     CapTable(const CapTable &ct, uint id) = delete;
     ~CapTable() {
@@ -53,6 +56,8 @@ public:
     bool range_unused(const m3::KIF::CapRngDesc &crd) const {
         if(!range_valid(crd))
             return false;
+        if(in_radix(crd))
+            return _radix.range_free(crd.start(), crd.count());
         for(capsel_t i = crd.start(); i < crd.start() + crd.count(); ++i) {
             if(get(i) != nullptr)
                 return false;
@@ -62,6 +67,8 @@ public:
     bool range_used(const m3::KIF::CapRngDesc &crd) const {
         if(!range_valid(crd))
             return false;
+        if(in_radix(crd))
+            return _radix.count_used(crd.start(), crd.count()) == crd.count();
         for(capsel_t i = crd.start(); i < crd.start() + crd.count(); ++i) {
             if(get(i) == nullptr)
                 return false;
@@ -74,10 +81,13 @@ public:
     void revoke(const m3::KIF::CapRngDesc &crd, bool own);
 
     Capability *get(capsel_t i) {
-        return _caps.find(i);
+        Capability *c = _radix.find(i);
+        if(!c && _ranges)
+            c = _caps.find(i);
+        return c;
     }
     const Capability *get(capsel_t i) const {
-        return _caps.find(i);
+        return const_cast<CapTable*>(this)->get(i);
     }
     Capability *get(capsel_t i, unsigned types) {
         Capability *c = get(i);
@@ -91,13 +101,18 @@ public:
         if(c) {
             assert(c->table() == this);
             assert(c->sel() == i);
-            _caps.insert(c);
+            if(radix_cap(c))
+                _radix.insert(i, c);
+            else {
+                _caps.insert(c);
+                _ranges++;
+            }
         }
     }
     void unset(capsel_t i) {
         Capability *c = get(i);
         if(c) {
-            _caps.remove(c);
+            remove(c);
             delete c;
         }
     }
@@ -105,14 +120,35 @@ public:
     void revoke_all();
 
 private:
+    void revoke_one(Capability *c);
     static void revoke(Capability *c, bool revnext);
-    static void revoke_rec(Capability *c, bool revnext);
+    static void revoke_tree(Capability *c, bool revnext);
+    static bool radix_cap(const Capability *c) {
+        return c->length == 1 && m3::RadixTable<Capability>::fits(c->sel());
+    }
+    bool in_radix(const m3::KIF::CapRngDesc &crd) const {
+        // if there are no caps in the treap, all caps in the range are in the radix table
+        return _ranges == 0 && crd.count() > 0 &&
+               m3::RadixTable<Capability>::fits(crd.start() + crd.count() - 1);
+    }
+    void remove(Capability *c) {
+        if(radix_cap(c))
+            _radix.remove(c->sel());
+        else {
+            _caps.remove(c);
+            _ranges--;
+        }
+    }
     bool range_valid(const m3::KIF::CapRngDesc &crd) const {
         return crd.count() == 0 || crd.start() + crd.count() > crd.start();
     }
 
     uint _id;
+    // the caps with a single selector below RadixTable::LIMIT are stored in the radix table for
+    // fast lookups; all others (e.g., mapping caps for multiple pages) in the treap
+    m3::RadixTable<Capability> _radix;
     m3::Treap<Capability> _caps;
+    size_t _ranges;
 };
 
 }
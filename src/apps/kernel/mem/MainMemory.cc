@@ -107,7 +107,13 @@ m3::OStream &operator<<(m3::OStream &os, const MainMemory &mem) {
     for(size_t i = 0; i < mem._count; ++i) {
         os << "  " << (mem._mods[i]->available() ? "free" : "used");
         os << " pe=" << mem._mods[i]->pe() << " addr=" << m3::fmt(mem._mods[i]->addr(), "p");
-        os << " size=" << m3::fmt(mem._mods[i]->size(), "p") << "\n";
+        os << " size=" << m3::fmt(mem._mods[i]->size(), "p");
+        if(mem._mods[i]->available()) {
+            size_t areas;
+            mem._mods[i]->map().get_size(&areas);
+            os << " areas=" << areas << " frag=" << mem._mods[i]->map().fragmentation() << "%";
+        }
+        os << "\n";
     }
     return os;
 }
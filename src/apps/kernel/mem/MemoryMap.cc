@@ -24,14 +24,15 @@
 namespace kernel {
 
 MemoryMap::Area *MemoryMap::freelist = nullptr;
-MemoryMap::Area MemoryMap::areas[MemoryMap::MAX_AREAS];
+alignas(8) char MemoryMap::areas[MemoryMap::MAX_AREAS * sizeof(MemoryMap::Area)];
 
 INIT_PRIO_USER(1) MemoryMap::Init MemoryMap::Init::inst;
 
 MemoryMap::Init::Init() {
     for(size_t i = 0; i < MAX_AREAS; ++i) {
-        areas[i].next = freelist;
-        freelist = areas + i;
+        Area *a = reinterpret_cast<Area*>(areas + i * sizeof(Area));
+        a->nextfree = freelist;
+        freelist = a;
     }
 }
 
@@ -40,57 +41,97 @@ void *MemoryMap::Area::operator new(size_t) {
         PANIC("No free areas");
 
     void *res = freelist;
-    freelist = freelist->next;
+    freelist = freelist->nextfree;
     return res;
 }
 
 void MemoryMap::Area::operator delete(void *ptr) {
     Area *a = static_cast<Area*>(ptr);
-    a->next = freelist;
+    a->nextfree = freelist;
     freelist = a;
 }
 
-MemoryMap::MemoryMap(goff_t addr, size_t size) : list(new Area()) {
-    list->addr = addr;
-    list->size = size;
-    list->next = nullptr;
+MemoryMap::MemoryMap(goff_t addr, size_t size)
+    : _free(),
+      _areas(),
+      _bins(),
+      _starts(),
+      _ends() {
+    Area *a = new Area();
+    a->addr = addr;
+    a->size = size;
+    insert(a);
 }
 
 MemoryMap::~MemoryMap() {
-    for(Area *a = list; a != nullptr;) {
-        Area *n = a->next;
-        delete a;
-        a = n;
+    for(size_t i = 0; i < BINS; ++i) {
+        while(_bins[i].length() > 0) {
+            Area *a = &*_bins[i].begin();
+            remove(a);
+            delete a;
+        }
     }
-    list = nullptr;
 }
 
-goff_t MemoryMap::allocate(size_t size, size_t align) {
-    Area *a;
-    Area *p = nullptr;
-    for(a = list; a != nullptr; p = a, a = a->next) {
-        size_t diff = m3::Math::round_up(a->addr, static_cast<goff_t>(align)) - a->addr;
-        if(a->size > diff && a->size - diff >= size)
+void MemoryMap::insert(Area *a) {
+    a->start.key(a->addr);
+    a->end.key(a->addr + a->size);
+    _starts.insert(&a->start);
+    _ends.insert(&a->end);
+    _bins[bin(a->size)].append(a);
+    _free += a->size;
+    _areas++;
+}
+
+void MemoryMap::remove(Area *a) {
+    _starts.remove(&a->start);
+    _ends.remove(&a->end);
+    _bins[bin(a->size)].remove(a);
+    _free -= a->size;
+    _areas--;
+}
+
+size_t MemoryMap::largest() const {
+    size_t max = 0;
+    for(size_t i = BINS; i-- > 0; ) {
+        for(auto a = _bins[i].cbegin(); a != _bins[i].cend(); ++a)
+            max = m3::Math::max(max, a->size);
+        if(max)
             break;
     }
+    return max;
+}
+
+goff_t MemoryMap::allocate(size_t size, size_t align) {
+    if(size == 0)
+        return static_cast<goff_t>(-1);
+
+    // the areas in the first bin might be too small; in all others, only the alignment matters
+    Area *a = nullptr;
+    size_t diff = 0;
+    for(size_t i = bin(size); !a && i < BINS; ++i) {
+        for(auto it = _bins[i].begin(); it != _bins[i].end(); ++it) {
+            diff = m3::Math::round_up(it->addr, static_cast<goff_t>(align)) - it->addr;
+            if(it->size > diff && it->size - diff >= size) {
+                a = &*it;
+                break;
+            }
+        }
+    }
     if(a == nullptr)
         return static_cast<goff_t>(-1);
 
-    /* if we need to do some alignment, create a new area in front of a */
-    size_t diff = m3::Math::round_up(a->addr, static_cast<goff_t>(align)) - a->addr;
+    remove(a);
+
+    /* if we need to do some alignment, keep the part in front of it */
     if(diff) {
         Area *n = new Area();
         n->addr = a->addr;
         n->size = diff;
-        if(p)
-            p->next = n;
-        else
-            list = n;
-        n->next = a;
+        insert(n);
 
         a->addr += diff;
         a->size -= diff;
-        p = n;
     }
 
     /* take it from the front */
@@ -98,13 +139,11 @@ goff_t MemoryMap::allocate(size_t size, size_t align) {
     a->size -= size;
     a->addr += size;
     /* if the area is empty now, remove it */
-    if(a->size == 0) {
-        if(p)
-            p->next = a->next;
-        else
-            list = a->next;
+    if(a->size == 0)
         delete a;
-    }
+    else
+        insert(a);
+
     KLOG(MEM, "Requested " << (size / 1024) << " KiB of memory @ " << m3::fmt(res, "p"));
     return res;
 }
@@ -112,49 +151,40 @@ goff_t MemoryMap::allocate(size_t size, size_t align) {
 void MemoryMap::free(goff_t addr, size_t size) {
     KLOG(MEM, "Free'd " << (size / 1024) << " KiB of memory @ " << m3::fmt(addr, "p"));
 
-    /* find the area behind ours */
-    Area *n, *p = nullptr;
-    for(n = list; n != nullptr && addr > n->addr; p = n, n = n->next)
-        ;
+    /* find the areas directly in front of and behind ours */
+    EndNode *pn = _ends.find(addr);
+    StartNode *nn = _starts.find(addr + size);
+    Area *p = pn ? pn->area : nullptr;
+    Area *n = nn ? nn->area : nullptr;
 
     /* merge with prev and next */
-    if(p && p->addr + p->size == addr && n && addr + size == n->addr) {
+    if(p && n) {
+        remove(p);
+        remove(n);
         p->size += size + n->size;
-        p->next = n->next;
         delete n;
+        insert(p);
     }
     /* merge with prev */
-    else if(p && p->addr + p->size == addr) {
+    else if(p) {
+        remove(p);
         p->size += size;
+        insert(p);
     }
     /* merge with next */
-    else if(n && addr + size == n->addr) {
+    else if(n) {
+        remove(n);
         n->addr -= size;
         n->size += size;
+        insert(n);
     }
     /* create new area between them */
     else {
         Area *a = new Area();
         a->addr = addr;
         a->size = size;
-        if(p)
-            p->next = a;
-        else
-            list = a;
-        a->next = n;
-    }
-}
-
-size_t MemoryMap::get_size(size_t *areas) const {
-    size_t total = 0;
-    if(areas)
-        *areas = 0;
-    for(Area *a = list; a != nullptr; a = a->next) {
-        total += a->size;
-        if(areas)
-            (*areas)++;
+        insert(a);
     }
-    return total;
 }
 
 }
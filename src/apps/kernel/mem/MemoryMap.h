@@ -17,15 +17,47 @@
 #pragma once
 
 #include <base/Common.h>
+#include <base/col/DList.h>
+#include <base/col/Treap.h>
 #include <base/stream/OStream.h>
 
 namespace kernel {
 
+/**
+ * Manages the free areas of a memory module. The free areas are kept in segregated lists, one per
+ * power of two, so that allocations only look at areas that are (almost) large enough. To merge
+ * areas on free, they are additionally indexed by their start and end address in two treaps.
+ * Thus, allocate and free need O(log n) time, as long as the alignment does not force us to skip
+ * many areas.
+ */
 class MemoryMap {
-    struct Area {
+    struct Area;
+
+    template<class N>
+    struct AddrNode : public m3::TreapNode<N, goff_t> {
+        explicit AddrNode(Area *_area) : m3::TreapNode<N, goff_t>(0), area(_area) {
+        }
+
+        Area *area;
+    };
+    struct StartNode : public AddrNode<StartNode> {
+        explicit StartNode(Area *area) : AddrNode<StartNode>(area) {
+        }
+    };
+    struct EndNode : public AddrNode<EndNode> {
+        explicit EndNode(Area *area) : AddrNode<EndNode>(area) {
+        }
+    };
+
+    struct Area : public m3::DListItem {
+        explicit Area() : m3::DListItem(), addr(), size(), start(this), end(this), nextfree() {
+        }
+
         goff_t addr;
         size_t size;
-        Area *next;
+        StartNode start;
+        EndNode end;
+        Area *nextfree;
 
         static void *operator new(size_t);
         static void operator delete(void *ptr);
@@ -37,6 +69,7 @@ class MemoryMap {
     };
 
     static const size_t MAX_AREAS   = 4096;
+    static const size_t BINS        = sizeof(size_t) * 8;
 
 public:
     /**
@@ -72,26 +105,57 @@ public:
     void free(goff_t addr, size_t size);
 
     /**
-     * Just for debugging/testing: Determines the total number of free bytes in the map
+     * Determines the total number of free bytes in the map
      *
-     * @param map the map
      * @param areas will be set to the number of areas in the map
      * @return the free bytes
      */
-    size_t get_size(size_t *areas = nullptr) const;
+    size_t get_size(size_t *areas = nullptr) const {
+        if(areas)
+            *areas = _areas;
+        return _free;
+    }
+
+    /**
+     * @return the size of the largest free area
+     */
+    size_t largest() const;
+
+    /**
+     * @return the external fragmentation in percent, that is, the amount of free memory that is
+     *  not part of the largest area
+     */
+    uint fragmentation() const {
+        return _free == 0 ? 0 : static_cast<uint>(100 - (largest() * 100) / _free);
+    }
 
     friend m3::OStream &operator<<(m3::OStream &os, const MemoryMap &map) {
-        size_t areas;
-        os << "Total: " << (map.get_size(&areas) / 1024) << " KiB:\n";
-        for(Area *a = map.list; a != nullptr; a = a->next)
-            os << "\t@ " << m3::fmt(a->addr, "p") << ", " << (a->size / 1024) << " KiB\n";
+        os << "Total: " << (map._free / 1024) << " KiB in " << map._areas << " areas"
+           << " (largest: " << (map.largest() / 1024) << " KiB"
+           << ", fragmentation: " << map.fragmentation() << "%):\n";
+        for(size_t i = 0; i < BINS; ++i) {
+            for(auto a = map._bins[i].cbegin(); a != map._bins[i].cend(); ++a)
+                os << "\t@ " << m3::fmt(a->addr, "p") << ", " << (a->size / 1024) << " KiB\n";
+        }
         return os;
     }
 
 private:
-    Area *list;
+    static size_t bin(size_t size) {
+        return sizeof(size_t) * 8 - 1 - static_cast<size_t>(__builtin_clzl(size));
+    }
+
+    void insert(Area *a);
+    void remove(Area *a);
+
+    size_t _free;
+    size_t _areas;
+    m3::DList<Area> _bins[BINS];
+    m3::Treap<StartNode> _starts;
+    m3::Treap<EndNode> _ends;
     static Area *freelist;
-    static Area areas[MAX_AREAS];
+    // raw memory, because the memory modules are created before the static constructors run
+    alignas(8) static char areas[MAX_AREAS * sizeof(Area)];
 };
 
 }
@@ -22,11 +22,24 @@
 namespace kernel {
 
 m3::SList<Slab> Slab::_slabs;
+#if defined(__host__)
+thread_local Slab::Magazine Slab::_mags[Slab::MAX_MAGS];
+#endif
 
 Slab::Pool::Pool(size_t objsize, size_t count)
     : total(count),
       free(count),
+      freelist(),
       mem(m3::Heap::alloc(objsize * count)) {
+    // each object starts with a pointer to its pool, followed by the freelist link
+    void **obj = reinterpret_cast<void**>(mem);
+    void **end = obj + (objsize * count) / sizeof(void*);
+    while(obj < end) {
+        obj[0] = this;
+        obj[1] = freelist;
+        freelist = obj;
+        obj += objsize / sizeof(void*);
+    }
 }
 
 Slab::Pool::~Pool() {
@@ -50,66 +63,92 @@ Slab *Slab::get(size_t objsize) {
     return s;
 }
 
-void *Slab::alloc() {
-    if(EXPECT_FALSE(!_freelist)) {
+Slab::Slab(size_t objsize)
+#if defined(__host__)
+    : _id(_slabs.length()),
+      _objsize(objsize),
+#else
+    : _objsize(objsize),
+#endif
+      _pools(),
+      _empty(),
+      _avail() {
+#if defined(__host__)
+    pthread_mutex_init(&_mutex, nullptr);
+#endif
+}
+
+void Slab::flush_thread() {
+#if defined(__host__)
+    for(auto s = _slabs.begin(); s != _slabs.end(); ++s) {
+        if(s->_id < MAX_MAGS)
+            s->flush(_mags[s->_id], _mags[s->_id].count);
+    }
+#endif
+}
+
+#if defined(__host__)
+void Slab::refill(Magazine &mag) {
+    pthread_mutex_lock(&_mutex);
+    while(mag.count < ARRAY_SIZE(mag.objs) / 2)
+        mag.objs[mag.count++] = do_alloc();
+    pthread_mutex_unlock(&_mutex);
+}
+
+void Slab::flush(Magazine &mag, size_t count) {
+    pthread_mutex_lock(&_mutex);
+    for(; count > 0; --count)
+        do_free(mag.objs[--mag.count]);
+    pthread_mutex_unlock(&_mutex);
+}
+#endif
+
+void *Slab::do_alloc() {
+    if(EXPECT_FALSE(_avail.length() == 0)) {
         KLOG(SLAB, "Extending " << _objsize << "B slab by " << (_objsize * STEP_SIZE) << "B");
 
-        Pool *p = new Pool(_objsize, STEP_SIZE);
-        void **mem = reinterpret_cast<void**>(p->mem);
-        void **end = mem + (_objsize * STEP_SIZE) / sizeof(void*);
-        while(mem < end) {
-            mem[0] = p;
-            mem[1] = _freelist;
-            _freelist = mem;
-            mem += _objsize / sizeof(void*);
-        }
-        _pools.append(p);
+        _avail.append(new Pool(_objsize, STEP_SIZE));
+        _pools++;
+        _empty++;
     }
 
-    void **ptr = _freelist;
-    reinterpret_cast<Pool*>(ptr[0])->free--;
-    _freelist = reinterpret_cast<void**>(_freelist[1]);
+    // prefer the partially used pools, so that the free ones can be reclaimed
+    Pool *p = &*_avail.begin();
+    if(p->free == p->total)
+        _empty--;
+
+    void **ptr = p->freelist;
+    p->freelist = reinterpret_cast<void**>(ptr[1]);
+    if(--p->free == 0)
+        _avail.remove(p);
     return ptr + 1;
 }
 
-void Slab::free(void *addr) {
+void Slab::do_free(void *addr) {
     void **ptr = reinterpret_cast<void**>(addr) - 1;
 
     Pool *p = reinterpret_cast<Pool*>(ptr[0]);
-    p->free++;
 
     // the object should be somewhere in its pool
-    assert(ptr >= p->mem && ptr < (void**)p->mem + (_objsize * STEP_SIZE) / sizeof(void*));
-    assert(p->free <= p->total);
+    assert(ptr >= p->mem && ptr < (void**)p->mem + (_objsize * p->total) / sizeof(void*));
+    assert(p->free < p->total);
+
+    ptr[1] = p->freelist;
+    p->freelist = ptr;
+    if(p->free++ == 0)
+        _avail.prepend(p);
 
-    // don't free pools for now. otherwise we shrink and extend back and forth.
-    // TODO maybe we should do that only on memory pressure or so
-#if 0
     if(EXPECT_FALSE(p->free == p->total)) {
-        KLOG(SLAB, "Shrinking " << _objsize << "B slab by " << (p->total * _objsize) << "B");
-
-        // remove all objects in the pool from the freelist
-        void **obj = _freelist, **prev = nullptr;
-        while(obj != nullptr) {
-            if(obj[0] == p) {
-                if(prev)
-                    prev[1] = obj[1];
-                else
-                    _freelist = reinterpret_cast<void**>(obj[1]);
-            }
-            else
-                prev = obj;
-            obj = reinterpret_cast<void**>(obj[1]);
+        if(_empty < MAX_EMPTY) {
+            _avail.moveToEnd(p);
+            _empty++;
+        }
+        else {
+            KLOG(SLAB, "Shrinking " << _objsize << "B slab by " << (p->total * _objsize) << "B");
+            _avail.remove(p);
+            _pools--;
+            delete p;
         }
-
-        _pools.remove(p);
-        delete p;
-    }
-    else
-#endif
-    {
-        ptr[1] = _freelist;
-        _freelist = ptr;
     }
 }
 
@@ -21,8 +21,20 @@
 #include <base/col/DList.h>
 #include <base/util/Util.h>
 
+#if defined(__host__)
+#   include <pthread.h>
+#endif
+
 namespace kernel {
 
+/**
+ * A slab allocator for objects of one size class. The memory is allocated in pools of STEP_SIZE
+ * objects, each having its own freelist. Pools that become completely free are given back to the
+ * heap, except for one, to not shrink and extend back and forth.
+ *
+ * On host, each thread has a small cache ("magazine") of free objects per slab, so that most
+ * allocations and frees do not need to take the lock.
+ */
 class Slab : public m3::SListItem {
     struct Pool : public m3::DListItem {
         explicit Pool(size_t objsize, size_t count);
@@ -30,30 +42,99 @@ class Slab : public m3::SListItem {
 
         size_t total;
         size_t free;
+        void **freelist;
         void *mem;
     };
 
+#if defined(__host__)
+    struct Magazine {
+        size_t count;
+        void *objs[32];
+    };
+#endif
+
 public:
 #if defined(__t2__)
     static const size_t STEP_SIZE   = 8;
 #else
     static const size_t STEP_SIZE   = 64;
 #endif
+    // the number of completely free pools that are kept
+    static const size_t MAX_EMPTY   = 1;
+#if defined(__host__)
+    // the number of slabs that use magazines
+    static const size_t MAX_MAGS    = 16;
+#endif
 
     static Slab *get(size_t objsize);
 
-    explicit Slab(size_t objsize)
-        : _freelist(),
-          _objsize(objsize) {
+    /**
+     * Gives the objects in the magazines of the current thread back to the slabs. Has to be called
+     * before a thread that used the slabs exits.
+     */
+    static void flush_thread();
+
+    explicit Slab(size_t objsize);
+
+    size_t objsize() const {
+        return _objsize;
+    }
+    size_t pools() const {
+        return _pools;
     }
 
-    void *alloc();
-    void free(void *ptr);
+    void *alloc() {
+#if defined(__host__)
+        if(EXPECT_TRUE(_id < MAX_MAGS)) {
+            Magazine &mag = _mags[_id];
+            if(EXPECT_FALSE(mag.count == 0))
+                refill(mag);
+            return mag.objs[--mag.count];
+        }
+
+        // the syscall workers allocate objects concurrently
+        pthread_mutex_lock(&_mutex);
+        void *res = do_alloc();
+        pthread_mutex_unlock(&_mutex);
+        return res;
+#else
+        return do_alloc();
+#endif
+    }
+    void free(void *ptr) {
+#if defined(__host__)
+        if(EXPECT_TRUE(_id < MAX_MAGS)) {
+            Magazine &mag = _mags[_id];
+            if(EXPECT_FALSE(mag.count == ARRAY_SIZE(mag.objs)))
+                flush(mag, ARRAY_SIZE(mag.objs) / 2);
+            mag.objs[mag.count++] = ptr;
+            return;
+        }
+
+        pthread_mutex_lock(&_mutex);
+        do_free(ptr);
+        pthread_mutex_unlock(&_mutex);
+#else
+        do_free(ptr);
+#endif
+    }
 
 private:
-    void **_freelist;
+    void *do_alloc();
+    void do_free(void *ptr);
+#if defined(__host__)
+    void refill(Magazine &mag);
+    void flush(Magazine &mag, size_t count);
+
+    pthread_mutex_t _mutex;
+    size_t _id;
+    static thread_local Magazine _mags[MAX_MAGS];
+#endif
     size_t _objsize;
-    m3::DList<Pool> _pools;
+    size_t _pools;
+    size_t _empty;
+    // the pools that have free objects
+    m3::DList<Pool> _avail;
     static m3::SList<Slab> _slabs;
 };
 
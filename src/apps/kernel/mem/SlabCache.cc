@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/stream/OStream.h>
+
+#include <string.h>
+
+#include "mem/SlabCache.h"
+
+namespace kernel {
+
+SlabCache *SlabCache::_first;
+
+m3::OStream &operator<<(m3::OStream &os, const SlabCache::Stats &) {
+    os << "Slab statistics:";
+    for(SlabCache *c = SlabCache::_first; c != nullptr; c = c->_next) {
+        // the name looks like "... [with T = kernel::Foo]"
+        const char *name = strstr(c->_name, "T = ");
+        name = name ? name + 4 : c->_name;
+        size_t len = strlen(name);
+        if(len > 0 && name[len - 1] == ']')
+            len--;
+
+        os << "\n  " << m3::fmt(name, "-", 32, len)
+           << " live=" << m3::fmt(c->_live, 6)
+           << " max=" << m3::fmt(c->_max, 6)
+           << " slab=" << m3::fmt(c->_slab->objsize(), 4) << "B"
+           << " pools=" << c->_slab->pools();
+    }
+    return os;
+}
+
+}
@@ -16,24 +16,65 @@
 
 #pragma once
 
+#include <base/stream/OStream.h>
+
 #include "mem/Slab.h"
 
 namespace kernel {
 
+/**
+ * The allocator for one type of kernel objects. It allocates from the slab of the corresponding
+ * size class and keeps statistics about the objects of this type.
+ */
 class SlabCache {
 public:
-    explicit SlabCache(size_t objsize) : _slab(Slab::get(objsize)) {
+    /**
+     * Prints the statistics of all object types when written into an OStream
+     */
+    struct Stats {
+    };
+    friend m3::OStream &operator<<(m3::OStream &os, const Stats &);
+
+    explicit SlabCache(size_t objsize, const char *name)
+        : _slab(Slab::get(objsize)),
+          _name(name),
+          _live(),
+          _max(),
+          _next(_first) {
+        _first = this;
     }
 
     void *alloc() {
+#if defined(__host__)
+        // the syscall workers allocate objects concurrently
+        size_t live = __atomic_add_fetch(&_live, 1, __ATOMIC_RELAXED);
+        size_t max = __atomic_load_n(&_max, __ATOMIC_RELAXED);
+        while(live > max && !__atomic_compare_exchange_n(&_max, &max, live, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+#else
+        if(++_live > _max)
+            _max = _live;
+#endif
         return _slab->alloc();
     }
     void free(void *ptr) {
+#if defined(__host__)
+        __atomic_sub_fetch(&_live, 1, __ATOMIC_RELAXED);
+#else
+        _live--;
+#endif
         _slab->free(ptr);
     }
 
 private:
     Slab *_slab;
+    const char *_name;
+    size_t _live;
+    size_t _max;
+    SlabCache *_next;
+    // no constructor, so that it is initialized before the static SlabCache objects
+    static SlabCache *_first;
 };
 
 template<class T>
@@ -47,10 +88,15 @@ public:
     }
 
 private:
+    static const char *type_name() {
+        // there is no RTTI; SlabCache extracts the type from the signature
+        return __PRETTY_FUNCTION__;
+    }
+
     static SlabCache _cache;
 };
 
 template<typename T>
-SlabCache SlabObject<T>::_cache(sizeof(T));
+SlabCache SlabObject<T>::_cache(sizeof(T), type_name());
 
 }
@@ -31,11 +31,13 @@ cycles_t Timeouts::sleep_time() const {
 
     cycles_t now = DTU::get().get_time();
     // do not sleep if there are timeouts to trigger
-    if(_timeouts.begin()->when <= now)
+    cycles_t next = _timeouts.next_due();
+    if(next <= now)
         return static_cast<cycles_t>(-1);
 
-    // sleep until the next timeout or until we receive a message
-    return _timeouts.begin()->when - now;
+    // sleep until the next timeout or until we receive a message. if the timeout is not in the
+    // lowest wheel yet, we wake up too early, but will sleep again after the cascade.
+    return next - now;
 }
 
 void Timeouts::trigger() {
@@ -45,40 +47,27 @@ void Timeouts::trigger() {
 
     EVENT_TRACER_Kernel_Timeouts();
     cycles_t now = DTU::get().get_time();
-    do {
-        auto &to = *_timeouts.begin();
-        // timeouts are sorted, so stop if we hit a future timeout
-        if(to.when > now)
-            break;
-
-        KLOG(TIMEOUTS, "Triggering timeout " << &to << " (now=" << now << ", due=" << to.when << ")");
-        // remove it first to get into a consistent state; the callback might do a thread switch
-        _timeouts.remove_first();
-        to.callback();
-        delete &to;
+    Timeout *to;
+    // the timeout is removed first to get into a consistent state; the callback might do a
+    // thread switch
+    while((to = _timeouts.pop_due(now)) != nullptr) {
+        KLOG(TIMEOUTS, "Triggering timeout " << to << " (now=" << now << ", due=" << to->when() << ")");
+        to->callback();
+        delete to;
     }
-    while(_timeouts.length() > 0);
 }
 
 Timeout *Timeouts::wait_for(cycles_t cycles, std::function<void()> &&callback) {
     cycles_t when = DTU::get().get_time() + cycles;
 
-    // insert timeouts in ascending order
-    Timeout *prev = nullptr;
-    for(auto it = _timeouts.begin(); it != _timeouts.end(); ++it) {
-        if(it->when >= when)
-            break;
-        prev = &*it;
-    }
-
     Timeout *to = new Timeout(when, m3::Util::move(callback));
-    KLOG(TIMEOUTS, "Inserting timeout " << to << " (due=" << to->when << ")");
-    _timeouts.insert(prev, to);
+    KLOG(TIMEOUTS, "Inserting timeout " << to << " (due=" << to->when() << ")");
+    _timeouts.insert(to);
     return to;
 }
 
 void Timeouts::cancel(Timeout *to) {
-    KLOG(TIMEOUTS, "Canceling timeout " << to << " (due=" << to->when << ")");
+    KLOG(TIMEOUTS, "Canceling timeout " << to << " (due=" << to->when() << ")");
     _timeouts.remove(to);
     delete to;
 }
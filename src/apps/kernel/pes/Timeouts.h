@@ -16,7 +16,7 @@
 
 #pragma once
 
-#include <base/col/SList.h>
+#include <base/col/TimerWheel.h>
 
 #include <functional>
 
@@ -24,14 +24,12 @@
 
 namespace kernel {
 
-struct Timeout : public m3::SListItem, public SlabObject<Timeout> {
+struct Timeout : public m3::TimerWheelItem<Timeout>, public SlabObject<Timeout> {
     explicit Timeout(cycles_t when, std::function<void()> &&callback)
-        : m3::SListItem(),
-          when(when),
+        : m3::TimerWheelItem<Timeout>(when),
           callback(callback) {
     }
 
-    cycles_t when;
     std::function<void ()> callback;
 };
 
@@ -53,7 +51,7 @@ public:
     void cancel(Timeout *to);
 
 private:
-    m3::SList<Timeout> _timeouts;
+    m3::TimerWheel<Timeout> _timeouts;
     static Timeouts _inst;
 };
 
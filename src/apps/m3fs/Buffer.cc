@@ -27,14 +27,18 @@ BufferHead::BufferHead(blockno_t bno, size_t size)
       _size(size),
       locked(true),
       dirty(false),
+      aged(false),
+      queue(),
       unlock(ThreadManager::get().get_wait_event()) {
 }
 
-Buffer::Buffer(size_t blocksize, Backend *backend)
+Buffer::Buffer(size_t blocksize, Backend *backend, Policy *policy)
     : ht(),
-      lru(),
+      policy(policy),
       _blocksize(blocksize),
-      _backend(backend) {
+      _backend(backend),
+      _hits(),
+      _misses() {
 }
 
 void Buffer::mark_dirty(blockno_t bno) {
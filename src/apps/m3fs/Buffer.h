@@ -31,11 +31,13 @@
 #include <thread/ThreadManager.h>
 
 #include "backend/Backend.h"
+#include "policy/Policy.h"
 
 class BufferHead : public m3::TreapNode<BufferHead, m3::blockno_t>, public m3::DListItem {
     friend class Buffer;
     friend class FileBuffer;
     friend class MetaBuffer;
+    friend class TwoQPolicy;
 
 public:
     BufferHead(m3::blockno_t bno, size_t size);
@@ -49,6 +51,10 @@ protected:
     size_t _size;
     bool locked;
     bool dirty;
+    // whether it has been dirty since the last aging round of the Flusher
+    bool aged;
+    // the list of the replacement policy that contains the head
+    uint8_t queue;
     event_t unlock;
 };
 
@@ -57,9 +63,22 @@ public:
     // the PRDT is currently placed behind the data buffer when using DMA
     static constexpr size_t PRDT_SIZE   = 8;
 
-    Buffer(size_t blocksize, Backend *backend);
-    virtual ~Buffer(){};
-    void mark_dirty(m3::blockno_t bno);
+    Buffer(size_t blocksize, Backend *backend, Policy *policy);
+    virtual ~Buffer() {
+        delete policy;
+    }
+
+    size_t hits() const {
+        return _hits;
+    }
+    size_t misses() const {
+        return _misses;
+    }
+    const Policy &replacement() const {
+        return *policy;
+    }
+
+    virtual void mark_dirty(m3::blockno_t bno);
     virtual void flush() = 0;
 
 protected:
@@ -67,8 +86,10 @@ protected:
     virtual void flush_chunk(BufferHead *b) = 0;
 
     m3::Treap<BufferHead> ht;
-    m3::DList<BufferHead> lru;
+    Policy *policy;
 
     size_t _blocksize;
     Backend *_backend;
+    size_t _hits;
+    size_t _misses;
 };
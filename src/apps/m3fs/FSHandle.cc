@@ -35,21 +35,35 @@ bool FSHandle::load_superblock(Backend *backend, SuperBlock *sb, bool clear) {
     SLOG(FS, "  free_blocks=" << sb->free_blocks);
     SLOG(FS, "  first_free_inode=" << sb->first_free_inode);
     SLOG(FS, "  first_free_block=" << sb->first_free_block);
+    SLOG(FS, "  journal_blocks=" << sb->journal_blocks);
     if(sb->checksum != sb->get_checksum())
         PANIC("Superblock checksum is invalid. Terminating.");
     return clear;
 }
 
-FSHandle::FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load)
+FSHandle::FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load,
+                   size_t max_prefetch, size_t dentries, uint dirty_ratio, size_t max_age,
+                   const char *policy)
     : _backend(backend),
       _clear(load_superblock(backend, &_sb, clear)),
       _revoke_first(revoke_first),
       _extend(extend),
-      _filebuffer(_sb.blocksize, backend, max_load),
-      _metabuffer(_sb.blocksize, backend),
+      _journal(_sb, backend, MetaBuffer::META_BUFFER_SIZE),
+      _filebuffer(_sb.blocksize, backend, Policy::create(policy, FileBuffer::FILE_BUFFER_SIZE),
+                  max_load, max_prefetch),
+      _metabuffer(_sb.blocksize, backend, Policy::create(policy, MetaBuffer::META_BUFFER_SIZE),
+                  &_journal),
       _blocks("Blocks", _sb.first_blockbm_block(), &_sb.first_free_block, &_sb.free_blocks,
               _sb.total_blocks, _sb.blockbm_blocks()),
       _inodes("INodes", _sb.first_inodebm_block(), &_sb.first_free_inode, &_sb.free_inodes,
               _sb.total_inodes, _sb.inodebm_blocks()),
-      _files(*this) {
+      _files(*this),
+      _dentries(dentries),
+      _flusher(*this, dirty_ratio, max_age) {
+    // bring the metadata into a consistent state, in case we were not shut down properly
+    _journal.replay();
+
+    Request r(*this);
+    _blocks.build(r);
+    _inodes.build(r);
 }
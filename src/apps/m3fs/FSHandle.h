@@ -16,19 +16,26 @@
 
 #pragma once
 
+#include <base/log/Services.h>
+
 #include <fs/internal.h>
 
 #include <m3/session/Disk.h>
 
 #include "FileBuffer.h"
+#include "Flusher.h"
+#include "Journal.h"
 #include "MetaBuffer.h"
 #include "backend/Backend.h"
 #include "data/Allocator.h"
+#include "data/DentryCache.h"
 #include "sess/OpenFiles.h"
 
 class FSHandle {
 public:
-    explicit FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load);
+    explicit FSHandle(Backend *backend, size_t extend, bool clear, bool revoke_first, size_t max_load,
+                      size_t max_prefetch, size_t dentries, uint dirty_ratio, size_t max_age,
+                      const char *policy);
 
     m3::SuperBlock &sb() {
         return _sb;
@@ -42,6 +49,12 @@ public:
     MetaBuffer &metabuffer() {
         return _metabuffer;
     }
+    Journal &journal() {
+        return _journal;
+    }
+    Flusher &flusher() {
+        return _flusher;
+    }
     Allocator &inodes() {
         return _inodes;
     }
@@ -51,6 +64,9 @@ public:
     OpenFiles &files() {
         return _files;
     }
+    DentryCache &dentries() {
+        return _dentries;
+    }
     bool revoke_first() const {
         return _revoke_first;
     }
@@ -68,6 +84,21 @@ public:
     }
 
     void shutdown() {
+        SLOG(FS, "Dentry cache: " << _dentries.hits() << " hits, "
+                                  << _dentries.misses() << " misses");
+        SLOG(FS, "File buffer: " << _filebuffer.hits() << " hits, "
+                                 << _filebuffer.misses() << " misses with "
+                                 << _filebuffer.replacement().name() << " ("
+                                 << _filebuffer.replacement().ghost_hits() << " ghost hits)");
+        SLOG(FS, "Meta buffer: " << _metabuffer.hits() << " hits, "
+                                 << _metabuffer.misses() << " misses with "
+                                 << _metabuffer.replacement().name() << " ("
+                                 << _metabuffer.replacement().ghost_hits() << " ghost hits)");
+        SLOG(FS, "Prefetching: " << _filebuffer.prefetch_hits() << " of "
+                                 << _filebuffer.prefetches() << " prefetches used");
+        SLOG(FS, "Flusher: " << _flusher.written() << " blocks in " << _flusher.rounds()
+                             << " rounds; stalls: file=" << _filebuffer.stalls()
+                             << ", meta=" << _metabuffer.stalls());
         _backend->shutdown();
     }
 
@@ -79,10 +110,13 @@ private:
     bool _revoke_first;
     size_t _extend;
     m3::SuperBlock _sb;
+    Journal _journal;
     FileBuffer _filebuffer;
     MetaBuffer _metabuffer;
     Allocator _blocks;
     Allocator _inodes;
     OpenFiles _files;
+    DentryCache _dentries;
+    Flusher _flusher;
     void *_parent_sess;
 };
@@ -23,14 +23,91 @@ using namespace m3;
 
 FileBufferHead::FileBufferHead(blockno_t bno, size_t size, size_t blocksize)
     : BufferHead(bno, size),
-      _data(MemGate::create_global(size * blocksize + Buffer::PRDT_SIZE, MemGate::RWX)) {
+      _data(MemGate::create_global(size * blocksize + Buffer::PRDT_SIZE, MemGate::RWX)),
+      _prefetched(false),
+      _ranges(),
+      _range_count() {
     _extents.append(new InodeExt(bno, size));
 }
 
-FileBuffer::FileBuffer(size_t blocksize, Backend *backend, size_t max_load)
-    : Buffer(blocksize, backend),
+size_t FileBufferHead::dirty_blocks() const {
+    size_t blocks = 0;
+    for(size_t i = 0; i < _range_count; ++i)
+        blocks += _ranges[i].count;
+    return blocks;
+}
+
+void FileBufferHead::add_dirty(size_t start, size_t count) {
+    Range res[MAX_RANGES + 1];
+    size_t end = start + count;
+    size_t i = 0, n = 0;
+    // keep the ranges in front, merge the overlapping and adjacent ones and keep the ones behind
+    for(; i < _range_count && _ranges[i].start + _ranges[i].count < start; ++i)
+        res[n++] = _ranges[i];
+    for(; i < _range_count && _ranges[i].start <= end; ++i) {
+        start = Math::min(start, _ranges[i].start);
+        end = Math::max(end, _ranges[i].start + _ranges[i].count);
+    }
+    res[n].start = start;
+    res[n++].count = end - start;
+    for(; i < _range_count; ++i)
+        res[n++] = _ranges[i];
+    set_ranges(res, n);
+}
+
+void FileBufferHead::remove_dirty(size_t start, size_t count) {
+    Range res[MAX_RANGES + 1];
+    size_t end = start + count;
+    size_t n = 0;
+    // at most one range can be split into two
+    for(size_t i = 0; i < _range_count; ++i) {
+        size_t rend = _ranges[i].start + _ranges[i].count;
+        if(_ranges[i].start < start) {
+            res[n].start = _ranges[i].start;
+            res[n++].count = Math::min(rend, start) - _ranges[i].start;
+        }
+        if(rend > end) {
+            size_t rstart = Math::max(_ranges[i].start, end);
+            res[n].start = rstart;
+            res[n++].count = rend - rstart;
+        }
+    }
+    set_ranges(res, n);
+}
+
+void FileBufferHead::set_ranges(Range *ranges, size_t count) {
+    // if there are too many, merge the two closest ones
+    if(count > MAX_RANGES) {
+        size_t min = 0;
+        for(size_t i = 1; i + 1 < count; ++i) {
+            size_t gap = ranges[i + 1].start - (ranges[i].start + ranges[i].count);
+            if(gap < ranges[min + 1].start - (ranges[min].start + ranges[min].count))
+                min = i;
+        }
+        ranges[min].count = ranges[min + 1].start + ranges[min + 1].count - ranges[min].start;
+        for(size_t i = min + 1; i + 1 < count; ++i)
+            ranges[i] = ranges[i + 1];
+        count--;
+    }
+
+    for(size_t i = 0; i < count; ++i)
+        _ranges[i] = ranges[i];
+    _range_count = count;
+    if(!dirty)
+        aged = false;
+    dirty = count > 0;
+}
+
+FileBuffer::FileBuffer(size_t blocksize, Backend *backend, Policy *policy, size_t max_load,
+                       size_t max_prefetch)
+    : Buffer(blocksize, backend, policy),
       _size(),
-      _max_load(max_load) {
+      _max_load(max_load),
+      _max_prefetch(Math::min(max_prefetch, FILE_BUFFER_SIZE / 4)),
+      _prefetches(),
+      _prefetch_hits(),
+      _dirty(),
+      _stalls() {
 }
 
 size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perms, size_t accessed,
@@ -46,8 +123,12 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
             }
             else {
                 // lock?
-                lru.remove(b);
-                lru.append(b);
+                policy->access(b);
+                _hits++;
+                if(b->_prefetched) {
+                    b->_prefetched = false;
+                    _prefetch_hits++;
+                }
                 SLOG(FS, "FileFuffer: Found cached blocks <"
                     << b->key() << "," << b->_size << ">, for block " << bno);
                 size_t len       = Math::min(size, static_cast<size_t>(b->_size - (bno - b->key())));
@@ -56,7 +137,9 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
 
                 if(res != Errors::NONE)
                     return 0;
-                b->dirty |= dirty;
+                // the client can write to all blocks it got access to
+                if(dirty)
+                    change_dirty(b, bno - b->key(), len, true);
                 return len * _blocksize;
             }
         }
@@ -70,35 +153,19 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
     // size_t max_size = Math::min((size_t)FILE_BUFFER_SIZE, _max_load * accessed);
     size_t load_size = Math::min(load ? max_size : FILE_BUFFER_SIZE, size);
 
-    FileBufferHead *b;
-    if((_size + load_size) > FILE_BUFFER_SIZE) {
-        do {
-            b = FileBuffer::get(lru.begin()->key());
-            if(b->locked) {
-                // wait
-                SLOG(FS, "FileBuffer: Waiting for eviction of block <" << b->key() << ">");
-                ThreadManager::get().wait_for(b->unlock);
-            }
-            else {
-                SLOG(FS, "FileBuffer: Evicting block <" << b->key() << ">");
-                lru.removeFirst();
-                ht.remove(b);
-                if(b->dirty)
-                    flush_chunk(b);
-                // revoke all subsets
-                VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, b->_data.sel(), 1));
-                _size -= b->_size;
-                delete b;
-            }
-        }
-        while((_size + load_size) > FILE_BUFFER_SIZE);
-    }
+    make_room(load_size);
+    // don't load blocks again that follow behind, e.g., because they have been prefetched
+    load_size = uncached(bno, load_size);
+    // evicting might have blocked and somebody else might have loaded <bno> meanwhile
+    if(load_size == 0)
+        return get_extent(bno, size, sel, perms, accessed, load, dirty);
 
-    b = new FileBufferHead(bno, load_size, _blocksize);
+    FileBufferHead *b = new FileBufferHead(bno, load_size, _blocksize);
 
     _size += b->_size;
     ht.insert(b);
-    lru.append(b);
+    policy->insert(b);
+    _misses++;
 
     // load from disk
     SLOG(FS, "FileBuffer: Allocating blocks <" << b->key() << "," << b->_size << ">"
@@ -110,10 +177,73 @@ size_t FileBuffer::get_extent(blockno_t bno, size_t size, capsel_t sel, int perm
     Errors::Code res = Syscalls::get().derivemem(sel, b->_data.sel(), 0, load_size * _blocksize, perms);
     if(res != Errors::NONE)
         return 0;
-    b->dirty = dirty;
+    if(dirty)
+        change_dirty(b, 0, load_size, true);
     return load_size * _blocksize;
 }
 
+void FileBuffer::prefetch(blockno_t bno, size_t size) {
+    blockno_t end = bno + Math::min(size, _max_prefetch);
+    // skip the blocks that are already present or on their way
+    FileBufferHead *b;
+    while(bno < end && (b = FileBuffer::get(bno)))
+        bno = b->key() + b->_size;
+    if(bno >= end)
+        return;
+
+    make_room(end - bno);
+    // evicting might have blocked, so that others might have loaded some of the blocks meanwhile
+    size_t load_size = uncached(bno, end - bno);
+    if(load_size == 0)
+        return;
+
+    b = new FileBufferHead(bno, load_size, _blocksize);
+    b->_prefetched = true;
+
+    _size += b->_size;
+    ht.insert(b);
+    policy->insert(b);
+    _prefetches++;
+
+    SLOG(FS, "FileBuffer: Prefetching blocks <" << b->key() << "," << b->_size << ">");
+    _backend->load_data(b->_data, b->key(), b->_size, true, b->unlock);
+
+    b->locked = false;
+}
+
+size_t FileBuffer::uncached(blockno_t bno, size_t size) {
+    for(size_t i = 0; i < size; ++i) {
+        if(FileBuffer::get(bno + i))
+            return i;
+    }
+    return size;
+}
+
+void FileBuffer::make_room(size_t size) {
+    while((_size + size) > FILE_BUFFER_SIZE) {
+        FileBufferHead *b = FileBuffer::get(policy->begin()->key());
+        if(b->locked) {
+            // wait
+            SLOG(FS, "FileBuffer: Waiting for eviction of block <" << b->key() << ">");
+            _stalls++;
+            ThreadManager::get().wait_for(b->unlock);
+        }
+        else {
+            SLOG(FS, "FileBuffer: Evicting block <" << b->key() << ">");
+            policy->remove(b);
+            ht.remove(b);
+            if(b->dirty) {
+                _stalls++;
+                flush_chunk(b);
+            }
+            // revoke all subsets
+            VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, b->_data.sel(), 1));
+            _size -= b->_size;
+            delete b;
+        }
+    }
+}
+
 FileBufferHead *FileBuffer::get(blockno_t bno) {
     FileBufferHead *b = reinterpret_cast<FileBufferHead*>(ht.find(bno));
     if(b)
@@ -121,14 +251,84 @@ FileBufferHead *FileBuffer::get(blockno_t bno) {
     return nullptr;
 }
 
-void FileBuffer::flush_chunk(BufferHead *b) {
+void FileBuffer::discard(blockno_t bno, size_t size) {
+    blockno_t end = bno + size;
+    while(bno < end) {
+        FileBufferHead *b = FileBuffer::get(bno);
+        if(!b) {
+            bno++;
+            continue;
+        }
+
+        blockno_t bend = Math::min(end, static_cast<blockno_t>(b->key() + b->_size));
+        change_dirty(b, bno - b->key(), bend - bno, false);
+        bno = bend;
+    }
+}
+
+void FileBuffer::change_dirty(FileBufferHead *b, size_t start, size_t count, bool dirty) {
+    _dirty -= b->dirty_blocks();
+    if(dirty)
+        b->add_dirty(start, count);
+    else
+        b->remove_dirty(start, count);
+    _dirty += b->dirty_blocks();
+}
+
+size_t FileBuffer::write_back_dirty(size_t limit, bool age) {
+    blockno_t keys[WRITE_BACK_BATCH];
+    size_t count = 0;
+    size_t remaining = _dirty;
+    for(auto it = policy->begin(); it != policy->end(); ++it) {
+        FileBufferHead *b = static_cast<FileBufferHead*>(&*it);
+        if(!b->dirty || b->locked)
+            continue;
+
+        if(count < WRITE_BACK_BATCH && (remaining > limit || (age && b->aged))) {
+            size_t i = count++;
+            for(; i > 0 && keys[i - 1] > b->key(); --i)
+                keys[i] = keys[i - 1];
+            keys[i] = b->key();
+            remaining -= b->dirty_blocks();
+        }
+        else if(age)
+            b->aged = true;
+        else if(count == WRITE_BACK_BATCH)
+            break;
+    }
+
+    size_t written = 0;
+    for(size_t i = 0; i < count; ++i) {
+        // the previous write-backs might have blocked and others might have changed the chunks
+        FileBufferHead *b = FileBuffer::get(keys[i]);
+        if(b && b->key() == keys[i] && b->dirty && !b->locked) {
+            written += b->dirty_blocks();
+            flush_chunk(b);
+        }
+    }
+    return written;
+}
+
+void FileBuffer::flush_chunk(BufferHead *bh) {
+    FileBufferHead *b = static_cast<FileBufferHead*>(bh);
     b->locked = true;
 
-    // TODO track the dirty regions instead of writing back the whole buffer
-    SLOG(FS, "FileBuffer: Write back blocks <" << b->key() << "," << b->_size << ">");
-    _backend->store_data(b->key(), b->_size, b->unlock);
+    // take the ranges, because they might be changed while we are waiting for the disk
+    FileBufferHead::Range ranges[FileBufferHead::MAX_RANGES];
+    size_t count = b->_range_count;
+    for(size_t i = 0; i < count; ++i)
+        ranges[i] = b->_ranges[i];
+    _dirty -= b->dirty_blocks();
+    b->_range_count = 0;
+    b->dirty = false;
+
+    for(size_t i = 0; i < count; ++i) {
+        SLOG(FS, "FileBuffer: Write back blocks <" << (b->key() + ranges[i].start)
+                                                   << "," << ranges[i].count << ">");
+        _backend->store_data(b->key(), b->key() + ranges[i].start, ranges[i].count,
+                             ranges[i].start * _blocksize, b->unlock);
+    }
 
-    b->dirty  = false;
     b->locked = false;
 }
 
@@ -35,29 +35,103 @@ struct InodeExt : public m3::DListItem {
 class FileBufferHead : public BufferHead {
     friend class FileBuffer;
 
+    // the number of dirty ranges that are tracked separately
+    static constexpr size_t MAX_RANGES  = 4;
+
+    struct Range {
+        size_t start;
+        size_t count;
+    };
+
 public:
     explicit FileBufferHead(m3::blockno_t bno, size_t size, size_t blocksize);
 
 private:
+    size_t dirty_blocks() const;
+    void add_dirty(size_t start, size_t count);
+    void remove_dirty(size_t start, size_t count);
+    void set_ranges(Range *ranges, size_t count);
+
     m3::MemGate _data;
     m3::DList<InodeExt> _extents;
+    // loaded by prefetch() and not accessed yet
+    bool _prefetched;
+    // the dirty blocks relative to key(); sorted and neither overlapping nor adjacent
+    Range _ranges[MAX_RANGES];
+    size_t _range_count;
 };
 
 class FileBuffer : public Buffer {
-    static constexpr size_t FILE_BUFFER_SIZE    = 16384; // at least 128
     static constexpr size_t LOAD_LIMIT          = 128;
+    // the maximum number of chunks written back at once by write_back_dirty()
+    static constexpr size_t WRITE_BACK_BATCH    = 64;
 
 public:
-    explicit FileBuffer(size_t blocksize, Backend *backend, size_t max_load);
+    static constexpr size_t FILE_BUFFER_SIZE    = 16384; // at least 128
+
+    explicit FileBuffer(size_t blocksize, Backend *backend, Policy *policy, size_t max_load,
+                        size_t max_prefetch);
+
+    /**
+     * @return the maximum number of blocks to read ahead (0 = disabled)
+     */
+    size_t max_prefetch() const {
+        return _max_prefetch;
+    }
+    size_t prefetches() const {
+        return _prefetches;
+    }
+    size_t prefetch_hits() const {
+        return _prefetch_hits;
+    }
+    size_t dirty_blocks() const {
+        return _dirty;
+    }
+    /**
+     * @return the number of times a request had to wait for a write-back to evict a chunk
+     */
+    size_t stalls() const {
+        return _stalls;
+    }
 
     size_t get_extent(m3::blockno_t bno, size_t size, capsel_t sel, int perms, size_t accessed,
                       bool load = true, bool dirty = false);
+
+    /**
+     * Loads the blocks <bno>..<bno>+<size>-1 into the buffer, if not already present, so that a
+     * following get_extent() finds them. This blocks the calling thread until the blocks are
+     * loaded, but lets others run in the meantime.
+     */
+    void prefetch(m3::blockno_t bno, size_t size);
+
+    /**
+     * Forgets the modifications of the blocks <bno>..<bno>+<size>-1, because they have been freed.
+     */
+    void discard(m3::blockno_t bno, size_t size);
+
+    /**
+     * Writes back the least recently used dirty chunks in the order of their block numbers until at
+     * most <limit> blocks are dirty. If <age> is true, chunks that have been dirty since the last
+     * call with <age> = true are written as well.
+     *
+     * @return the number of written blocks
+     */
+    size_t write_back_dirty(size_t limit, bool age);
+
     void flush() override;
 
 private:
+    void change_dirty(FileBufferHead *b, size_t start, size_t count, bool dirty);
     FileBufferHead *get(m3::blockno_t bno) override;
     void flush_chunk(BufferHead *b) override;
+    size_t uncached(m3::blockno_t bno, size_t size);
+    void make_room(size_t size);
 
     size_t _size;
     size_t _max_load;
+    size_t _max_prefetch;
+    size_t _prefetches;
+    size_t _prefetch_hits;
+    size_t _dirty;
+    size_t _stalls;
 };
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Services.h>
+
+#include "FSHandle.h"
+#include "Flusher.h"
+
+using namespace m3;
+
+Flusher::Flusher(FSHandle &handle, uint dirty_ratio, size_t max_age)
+    : _handle(handle),
+      _ratio(dirty_ratio),
+      _max_age(max_age),
+      _requests(),
+      _age(),
+      _running(),
+      _event(),
+      _thread(),
+      _rounds(),
+      _written() {
+}
+
+bool Flusher::start() {
+    // without other threads, we cannot write back in the background
+    if(_ratio == 0 || ThreadManager::get().sleeping_count() == 0)
+        return false;
+
+    _event = ThreadManager::get().get_wait_event();
+    _thread = new Thread(run, this);
+    SLOG(FS, "Flusher: started with dirty ratio " << _ratio << "% and max age " << _max_age);
+    return true;
+}
+
+void Flusher::request_done() {
+    // the threads are created after the FSHandle, so that we start with the first request
+    if(!_thread && !start())
+        return;
+
+    if(_max_age > 0 && ++_requests >= _max_age) {
+        _requests = 0;
+        _age = true;
+    }
+
+    // if it's running, it checks again when it's done
+    if(!_running && (_age || needed()))
+        ThreadManager::get().notify(_event);
+}
+
+bool Flusher::needed() const {
+    size_t file_dirty = _handle.filebuffer().dirty_blocks();
+    size_t meta_dirty = _handle.metabuffer().dirty_blocks();
+    return file_dirty * 100 > _ratio * FileBuffer::FILE_BUFFER_SIZE ||
+           meta_dirty * 100 > _ratio * MetaBuffer::META_BUFFER_SIZE;
+}
+
+size_t Flusher::write_back() {
+    bool age = _age;
+    _age = false;
+
+    // write back until we are at half of the threshold to not start again right away
+    size_t written = _handle.filebuffer().write_back_dirty(
+        _ratio * FileBuffer::FILE_BUFFER_SIZE / 200, age);
+    written += _handle.metabuffer().write_back_dirty(
+        _ratio * MetaBuffer::META_BUFFER_SIZE / 200, age);
+
+    _rounds++;
+    _written += written;
+    return written;
+}
+
+void Flusher::run(void *arg) {
+    Flusher *f = static_cast<Flusher*>(arg);
+    while(true) {
+        ThreadManager::get().wait_for(f->_event);
+
+        f->_running = true;
+        // stop if there is nothing we can write, because others are using all dirty blocks
+        while(f->write_back() > 0 && (f->_age || f->needed()))
+            ;
+        f->_running = false;
+    }
+}
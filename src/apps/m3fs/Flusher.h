@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+
+#include <thread/ThreadManager.h>
+
+class FSHandle;
+
+/*
+ * writes back dirty blocks of the file and meta buffer in the background to let requests rarely
+ * wait for write-backs when evicting blocks
+ * the flusher is a separate thread that is woken up after a request if the ratio of dirty blocks
+ * in one of the buffers exceeds the threshold or if <max_age> requests have passed since the last
+ * aging round. in an aging round, all blocks are written that have been dirty since the previous
+ * one. the flusher writes the least recently used blocks first, sorted by block number
+ */
+class Flusher {
+public:
+    explicit Flusher(FSHandle &handle, uint dirty_ratio, size_t max_age);
+
+    size_t rounds() const {
+        return _rounds;
+    }
+    size_t written() const {
+        return _written;
+    }
+
+    /**
+     * Notifies the flusher that a request has been finished.
+     */
+    void request_done();
+
+private:
+    static void run(void *arg);
+    bool start();
+    bool needed() const;
+    size_t write_back();
+
+    FSHandle &_handle;
+    uint _ratio;
+    size_t _max_age;
+    size_t _requests;
+    bool _age;
+    bool _running;
+    event_t _event;
+    m3::Thread *_thread;
+    size_t _rounds;
+    size_t _written;
+};
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Services.h>
+
+#include "Journal.h"
+
+using namespace m3;
+
+ssize_t Journal::Slot::find(blockno_t bno) const {
+    if(!pending)
+        return -1;
+    // the blocks are sorted
+    const JournalHeader *hd = header();
+    size_t lo = 0, hi = hd->count;
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(hd->blocks[mid] == bno)
+            return static_cast<ssize_t>(mid);
+        if(hd->blocks[mid] < bno)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return -1;
+}
+
+Journal::Journal(SuperBlock &sb, Backend *backend, size_t max_blocks)
+    : _sb(sb),
+      _backend(backend),
+      _capacity(JournalHeader::capacity(sb)),
+      _hdr_blocks(JournalHeader::header_blocks(sb, _capacity)),
+      _enabled(_capacity > 0 && _capacity >= max_blocks),
+      _seq(1),
+      _cur(0),
+      _slots() {
+    if(_capacity > 0) {
+        for(size_t i = 0; i < 2; ++i) {
+            _slots[i].buf = new char[_sb.journal_slot_blocks() * _sb.blocksize]();
+            _slots[i].home = new bool[_capacity];
+            _slots[i].pending = false;
+        }
+    }
+}
+
+Journal::~Journal() {
+    delete[] _slots[0].buf;
+    delete[] _slots[1].buf;
+    delete[] _slots[0].home;
+    delete[] _slots[1].home;
+}
+
+bool Journal::pending(blockno_t bno) const {
+    for(size_t i = 0; i < 2; ++i) {
+        ssize_t idx = _slots[i].find(bno);
+        if(idx != -1 && !_slots[i].home[idx])
+            return true;
+    }
+    return false;
+}
+
+void Journal::written_back(blockno_t bno) {
+    for(size_t i = 0; i < 2; ++i) {
+        ssize_t idx = _slots[i].find(bno);
+        if(idx != -1)
+            _slots[i].home[idx] = true;
+    }
+}
+
+void Journal::replay() {
+    if(_capacity == 0)
+        return;
+
+    JournalHeader *valid[2] = {nullptr, nullptr};
+    for(size_t i = 0; i < 2; ++i) {
+        _backend->load_journal(_slots[i].buf, slot_start(i), _sb.journal_slot_blocks());
+        JournalHeader *hd = _slots[i].header();
+        if(hd->magic == JournalHeader::MAGIC && hd->count <= _capacity &&
+           hd->checksum == hd->get_checksum(copy(_slots[i], 0), _sb.blocksize))
+            valid[i] = hd;
+    }
+
+    // replay the older transaction first, because the newer one might contain the same blocks
+    size_t first = (valid[0] && valid[1] && valid[1]->seq < valid[0]->seq) ? 1 : 0;
+    for(size_t j = 0; j < 2; ++j) {
+        size_t i = (first + j) % 2;
+        if(!valid[i])
+            continue;
+
+        SLOG(FS, "Journal: replaying transaction " << valid[i]->seq
+                                                  << " with " << valid[i]->count << " blocks");
+        for(uint32_t b = 0; b < valid[i]->count; ++b) {
+            _backend->store_journal(copy(_slots[i], b), valid[i]->blocks[b], 1);
+        }
+        _sb = valid[i]->sb;
+        _seq = valid[i]->seq + 1;
+    }
+
+    // the blocks might be written in place from now on, which a second replay of these
+    // transactions after the next crash would undo. thus, persist the superblock of the
+    // transactions and forget them.
+    if(valid[0] || valid[1]) {
+        _backend->store_sb(_sb);
+        invalidate();
+    }
+
+    _slots[0].header()->count = 0;
+    _slots[1].header()->count = 0;
+
+    if(!_enabled) {
+        SLOG(FS, "Journal: " << _capacity << " blocks per transaction are too few; "
+                             << "writing metadata in place");
+    }
+}
+
+void Journal::add(blockno_t bno, const void *data) {
+    JournalHeader *hd = _slots[_cur].header();
+    assert(hd->count < _capacity);
+    assert(hd->count == 0 || hd->blocks[hd->count - 1] < bno);
+    memcpy(copy(_slots[_cur], hd->count), data, _sb.blocksize);
+    _slots[_cur].home[hd->count] = false;
+    hd->blocks[hd->count++] = bno;
+}
+
+void Journal::commit() {
+    Slot &cur = _slots[_cur];
+    JournalHeader *hd = cur.header();
+    if(hd->count == 0)
+        return;
+
+    // the superblock belongs to the transaction, because it contains the allocation state
+    hd->magic = JournalHeader::MAGIC;
+    hd->seq = _seq++;
+    hd->sb = _sb;
+    hd->sb.checksum = hd->sb.get_checksum();
+    hd->checksum = hd->get_checksum(copy(cur, 0), _sb.blocksize);
+    cur.pending = true;
+
+    SLOG(FS, "Journal: committing transaction " << hd->seq << " with " << hd->count << " blocks");
+    _backend->store_journal(cur.buf, slot_start(_cur), _hdr_blocks + hd->count);
+
+    // the previous transaction is complete on disk now, so that we can free its slot
+    _cur ^= 1;
+    checkpoint(_slots[_cur], &cur);
+}
+
+void Journal::checkpoint(Slot &slot, const Slot *newer) {
+    JournalHeader *hd = slot.header();
+    if(slot.pending) {
+        // skip the block if it has been written back in the meantime or if the newer transaction
+        // contains it as well, because we write it back with that one
+        auto skip = [&slot, hd, newer](uint32_t i) {
+            return slot.home[i] || (newer && newer->contains(hd->blocks[i]));
+        };
+
+        for(uint32_t i = 0; i < hd->count; ) {
+            if(skip(i)) {
+                i++;
+                continue;
+            }
+
+            // the blocks are sorted, so that the copies of adjacent blocks are adjacent in the slot
+            // as well and can be written at once
+            uint32_t end = i + 1;
+            while(end < hd->count && hd->blocks[end] == hd->blocks[end - 1] + 1 && !skip(end))
+                end++;
+            _backend->store_journal(copy(slot, i), hd->blocks[i], end - i);
+            i = end;
+        }
+        slot.pending = false;
+    }
+    hd->count = 0;
+}
+
+void Journal::checkpoint_all() {
+    if(!enabled())
+        return;
+
+    // the current slot is always free; the other one contains the last transaction
+    checkpoint(_slots[_cur ^ 1], nullptr);
+
+    // all blocks are at home now, so that there is nothing to replay
+    invalidate();
+}
+
+void Journal::invalidate() {
+    memset(_slots[_cur].buf, 0, _sb.blocksize);
+    _backend->store_journal(_slots[_cur].buf, slot_start(0), 1);
+    _backend->store_journal(_slots[_cur].buf, slot_start(1), 1);
+}
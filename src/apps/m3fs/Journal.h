@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <fs/internal.h>
+
+#include "backend/Backend.h"
+
+/*
+ * write-ahead journal for the metadata blocks
+ * a transaction is collected in the buffer of the current slot and written with one sequential
+ * write. afterwards, the blocks of the previous transaction in the other slot are written to their
+ * home location, unless the new transaction contains them as well. thus, the other slot is free
+ * for the next transaction and a crash leaves at least one complete transaction behind.
+ * the journal is only used for new transactions if one of them can hold <max_blocks> blocks,
+ * because the user relies on committing all of them atomically. smaller journals are replayed,
+ * though.
+ */
+class Journal {
+    struct Slot {
+        m3::JournalHeader *header() {
+            return reinterpret_cast<m3::JournalHeader*>(buf);
+        }
+        const m3::JournalHeader *header() const {
+            return reinterpret_cast<const m3::JournalHeader*>(buf);
+        }
+        // returns the index of <bno> in the transaction or -1
+        ssize_t find(m3::blockno_t bno) const;
+        bool contains(m3::blockno_t bno) const {
+            return find(bno) != -1;
+        }
+
+        char *buf;
+        // whether the block has been written to its home location after the transaction
+        bool *home;
+        // whether the blocks are not yet at their home location
+        bool pending;
+    };
+
+public:
+    explicit Journal(m3::SuperBlock &sb, Backend *backend, size_t max_blocks);
+    ~Journal();
+
+    bool enabled() const {
+        return _enabled;
+    }
+    size_t capacity() const {
+        return _capacity;
+    }
+    /**
+     * @return true if the block is contained in a committed transaction, but not at home yet
+     */
+    bool pending(m3::blockno_t bno) const;
+    /**
+     * Notes that the current version of the block has been written to its home location, so that
+     * checkpointing the transactions does not need to write it anymore.
+     */
+    void written_back(m3::blockno_t bno);
+
+    void replay();
+    void add(m3::blockno_t bno, const void *data);
+    void commit();
+    void checkpoint_all();
+
+private:
+    m3::blockno_t slot_start(size_t slot) const {
+        return _sb.first_journal_block() + slot * _sb.journal_slot_blocks();
+    }
+    // returns the copy of the <i>th block in <slot>
+    char *copy(const Slot &slot, size_t i) const {
+        return slot.buf + (_hdr_blocks + i) * _sb.blocksize;
+    }
+    void checkpoint(Slot &slot, const Slot *newer);
+    // writes invalid headers to both slots on disk
+    void invalidate();
+
+    m3::SuperBlock &_sb;
+    Backend *_backend;
+    size_t _capacity;
+    size_t _hdr_blocks;
+    bool _enabled;
+    uint32_t _seq;
+    size_t _cur;
+    Slot _slots[2];
+};
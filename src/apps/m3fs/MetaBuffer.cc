@@ -28,11 +28,26 @@ MetaBufferHead::MetaBufferHead(blockno_t bno, size_t size, size_t off, char *dat
       _linkcount(0) {
 }
 
-MetaBuffer::MetaBuffer(size_t blocksize, Backend *backend)
-    : Buffer(blocksize, backend),
-      _blocks(new char[_blocksize * META_BUFFER_SIZE]) {
-    for(size_t i = 0; i < META_BUFFER_SIZE; i++)
-        lru.append(new MetaBufferHead(0, 1, i, _blocks + i * _blocksize));
+MetaBuffer::MetaBuffer(size_t blocksize, Backend *backend, Policy *policy, Journal *journal)
+    : Buffer(blocksize, backend, policy),
+      _blocks(new char[_blocksize * META_BUFFER_SIZE]),
+      _heads(new MetaBufferHead*[META_BUFFER_SIZE]),
+      _journal(journal),
+      _txheads(new MetaBufferHead*[META_BUFFER_SIZE]),
+      _dirty(0),
+      _active(0),
+      _waiting(0),
+      _committing(false),
+      _draining(false),
+      _committed(ThreadManager::get().get_wait_event()),
+      _drained(ThreadManager::get().get_wait_event()),
+      _released(ThreadManager::get().get_wait_event()),
+      _clustering(false),
+      _stalls(0) {
+    for(size_t i = 0; i < META_BUFFER_SIZE; i++) {
+        _heads[i] = new MetaBufferHead(0, 1, i, _blocks + i * _blocksize);
+        policy->insert(_heads[i]);
+    }
 }
 
 void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
@@ -43,43 +58,69 @@ void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
             if(b->locked)
                 ThreadManager::get().wait_for(b->unlock);
             else {
-                lru.moveToEnd(b);
+                bool was_held = held(b);
                 b->_linkcount++;
-                b->dirty |= dirty;
+                if(!was_held)
+                    policy->pin(b);
+                _hits++;
+                if(dirty)
+                    set_dirty(b, true);
                 SLOG(FS, "MetaBuffer: Found cached block <" << b->key() << ">, Links: "
                                                             << b->_linkcount);
                 r.push_meta(b);
                 return b->_data;
             }
+            continue;
         }
-        else
-            break;
-    }
 
-    // find first non-used block
-    for(auto it = lru.begin(); it != lru.end(); ++it) {
-        auto mb = static_cast<MetaBufferHead*>(&*it);
-        if(mb->_linkcount == 0) {
-            b = mb;
+        b = find_victim();
+        if(!_journal->enabled())
             break;
+        // no block must be written in place while a transaction is committed
+        if(b && !b->locked && !(_committing && _journal->pending(b->key())))
+            break;
+
+        // dirty blocks have to be committed before they are written to their home location
+        _stalls++;
+        if(b && b->locked)
+            ThreadManager::get().wait_for(b->unlock);
+        else if(_committing)
+            ThreadManager::get().wait_for(_committed);
+        else {
+            // we can't commit in the middle of a request. thus, wait until the other requests
+            // release blocks and commit as soon as all of them are finished
+            if(_waiting + 1 >= _active)
+                PANIC("MetaBuffer: all blocks are dirty or in use");
+            _draining = true;
+            _waiting++;
+            ThreadManager::get().wait_for(_released);
+            _waiting--;
         }
+        // others might have loaded the block in the meantime, so that we have to start over
     }
+    assert(b != nullptr);
+    policy->remove(b);
 
-    // write-back, if necessary
+    // write-back, if necessary. committed blocks that are not at home yet have to be written as
+    // well, because we would load an outdated version otherwise
     if(b->key()) {
         ht.remove(b);
-        if(b->dirty)
+        if(b->dirty || _journal->pending(b->key())) {
+            _stalls++;
             flush_chunk(b);
+        }
     }
 
     b->key(bno);
     ht.insert(b);
+    policy->insert(b);
+    policy->pin(b);
+    _misses++;
 
     _backend->load_meta(b->_data, b->_off, bno, b->unlock);
 
     b->_linkcount = 1;
-    b->dirty = dirty;
-    lru.moveToEnd(b);
+    set_dirty(b, dirty);
     SLOG(FS, "MetaBuffer: Load new block <" << b->key() << ">, Links: " << b->_linkcount);
     b->locked = false;
 
@@ -87,10 +128,64 @@ void *MetaBuffer::get_block(Request &r, blockno_t bno, bool dirty) {
     return b->_data;
 }
 
+MetaBufferHead *MetaBuffer::find_victim() {
+    // the policy holds only non-used blocks and, with the journal, only clean ones (see held())
+    if(_journal->enabled()) {
+        auto it = policy->begin();
+        return it != policy->end() ? static_cast<MetaBufferHead*>(&*it) : nullptr;
+    }
+
+    // prefer a clean one among the first few, but skip the ones that are currently written back
+    MetaBufferHead *dirty = nullptr;
+    size_t scanned = 0;
+    for(auto it = policy->begin(); it != policy->end() && scanned < VICTIM_SCAN; ++it) {
+        auto mb = static_cast<MetaBufferHead*>(&*it);
+        if(mb->locked)
+            continue;
+        if(!mb->dirty)
+            return mb;
+        if(!dirty)
+            dirty = mb;
+        scanned++;
+    }
+    return dirty;
+}
+
 void MetaBuffer::quit(MetaBufferHead *b) {
     assert(b->_linkcount > 0);
     SLOG(FS, "MetaBuffer: Dereferencing block <" << b->key() << ">, Links: " << b->_linkcount);
-    b->_linkcount--;
+    if(--b->_linkcount == 0 && !held(b))
+        release(b);
+}
+
+void MetaBuffer::release(MetaBufferHead *b) {
+    policy->unpin(b);
+    if(_waiting > 0)
+        ThreadManager::get().notify(_released);
+}
+
+void MetaBuffer::mark_dirty(blockno_t bno) {
+    MetaBufferHead *b = get(bno);
+    if(b)
+        set_dirty(b, true);
+}
+
+void MetaBuffer::set_dirty(MetaBufferHead *b, bool dirty) {
+    if(b->dirty != dirty) {
+        bool was_held = held(b);
+        if(dirty) {
+            _dirty++;
+            b->aged = false;
+        }
+        else
+            _dirty--;
+        b->dirty = dirty;
+
+        if(was_held && !held(b))
+            release(b);
+        else if(!was_held && held(b))
+            policy->pin(b);
+    }
 }
 
 MetaBufferHead *MetaBuffer::get(blockno_t bno) {
@@ -101,26 +196,195 @@ MetaBufferHead *MetaBuffer::get(blockno_t bno) {
 }
 
 void MetaBuffer::flush_chunk(BufferHead *b) {
-    MetaBufferHead *mb = reinterpret_cast<MetaBufferHead*>(b);
-    mb->locked         = true;
+    write_cluster(reinterpret_cast<MetaBufferHead*>(b));
+}
+
+bool MetaBuffer::clusterable(blockno_t bno) {
+    MetaBufferHead *b = get(bno);
+    return b && b->dirty && !b->locked && b->_linkcount == 0;
+}
+
+size_t MetaBuffer::write_cluster(MetaBufferHead *b) {
+    // with the journal, dirty blocks have to be committed before they can be written to their
+    // home location. besides, all clusters share one transfer buffer
+    blockno_t start = b->key();
+    blockno_t end   = start + 1;
+    if(!_journal->enabled() && !_clustering) {
+        while(end - start < MAX_CLUSTER && start > 0 && clusterable(start - 1))
+            start--;
+        while(end - start < MAX_CLUSTER && clusterable(end))
+            end++;
+    }
+
+    if(end - start == 1) {
+        b->locked = true;
+
+        // write_to_disk
+        SLOG(FS, "MetaBuffer: Write back block <" << b->key() << ">");
+        _backend->store_meta(b->_data, b->_off, b->key(), b->unlock);
+
+        _journal->written_back(b->key());
+        set_dirty(b, false);
+        b->locked = false;
+        return 1;
+    }
+
+    // <b> might have been removed from the hashtable already, if it is evicted
+    MetaBufferHead *heads[MAX_CLUSTER];
+    const void *srcs[MAX_CLUSTER];
+    size_t count = end - start;
+    for(size_t i = 0; i < count; ++i) {
+        heads[i] = start + i == b->key() ? b : get(start + i);
+        heads[i]->locked = true;
+        srcs[i] = heads[i]->_data;
+    }
+
+    SLOG(FS, "MetaBuffer: Write back blocks <" << start << "," << count << ">");
+    _clustering = true;
+    _backend->store_meta_blocks(srcs, start, count);
+    _clustering = false;
+
+    for(size_t i = 0; i < count; ++i) {
+        set_dirty(heads[i], false);
+        heads[i]->locked = false;
+        ThreadManager::get().notify(heads[i]->unlock);
+    }
+    return count;
+}
+
+void MetaBuffer::enter() {
+    while(_draining)
+        ThreadManager::get().wait_for(_drained);
+    _active++;
+}
+
+void MetaBuffer::leave() {
+    assert(_active > 0);
+    _active--;
+    if(!_journal->enabled())
+        return;
+
+    // commit only if no request is in progress to not put half-done operations into the journal.
+    // thus, if enough blocks are dirty, let the running requests finish without starting new ones
+    if(_active > 0) {
+        if(_dirty >= COMMIT_THRESHOLD)
+            _draining = true;
+        return;
+    }
 
-    // write_to_disk
-    SLOG(FS, "MetaBuffer: Write back block <" << b->key() << ">");
-    _backend->store_meta(mb->_data, mb->_off, b->key(), mb->unlock);
+    if(_draining) {
+        _draining = false;
+        ThreadManager::get().notify(_drained);
+    }
+    else if(_dirty < COMMIT_THRESHOLD)
+        return;
+    commit();
+}
+
+void MetaBuffer::commit() {
+    if(!_journal->enabled() || _committing || _dirty == 0)
+        return;
+
+    _committing = true;
+
+    // the journal expects the blocks in ascending order
+    size_t count = 0;
+    for(size_t j = 0; j < META_BUFFER_SIZE; ++j) {
+        if(_heads[j]->dirty) {
+            size_t i = count++;
+            for(; i > 0 && _txheads[i - 1]->key() > _heads[j]->key(); --i)
+                _txheads[i] = _txheads[i - 1];
+            _txheads[i] = _heads[j];
+        }
+    }
+
+    // the journal holds all blocks of the buffer, so that they are committed atomically
+    for(size_t i = 0; i < count; ++i) {
+        _journal->add(_txheads[i]->key(), _txheads[i]->_data);
+        set_dirty(_txheads[i], false);
+    }
+    _journal->commit();
 
-    b->dirty   = false;
-    mb->locked = false;
+    _committing = false;
+    ThreadManager::get().notify(_committed);
 }
 
 void MetaBuffer::write_back(blockno_t bno) {
     MetaBufferHead *b = get(bno);
-    if(b) {
-        if(b->dirty)
-            flush_chunk(b);
+    if(!b)
+        return;
+
+    // the block has to be in the journal before we can write it to its home location, but we can't
+    // commit in the middle of a request. thus, commit as soon as the running requests are done
+    if(b->dirty && _journal->enabled())
+        _draining = true;
+    else if(b->dirty || _journal->pending(bno))
+        flush_chunk(b);
+}
+
+size_t MetaBuffer::write_back_dirty(size_t limit, bool age) {
+    if(_journal->enabled()) {
+        if(_committing)
+            return 0;
+
+        bool aged = false;
+        for(size_t i = 0; age && i < META_BUFFER_SIZE; ++i) {
+            if(_heads[i]->dirty) {
+                aged |= _heads[i]->aged;
+                _heads[i]->aged = true;
+            }
+        }
+        if(_dirty <= limit && !aged)
+            return 0;
+
+        // commit only complete operations (see leave())
+        if(_active > 0) {
+            _draining = true;
+            return 0;
+        }
+
+        size_t count = _dirty;
+        commit();
+        return count;
     }
+
+    // blocks in use might be changed at the moment, but these are not in the policy. all others
+    // can be written back any time
+    blockno_t blocks[WRITE_BACK_BATCH];
+    size_t count = 0;
+    size_t remaining = _dirty;
+    for(auto it = policy->begin(); it != policy->end(); ++it) {
+        MetaBufferHead *b = static_cast<MetaBufferHead*>(&*it);
+        if(!b->dirty || b->locked)
+            continue;
+
+        if(count < WRITE_BACK_BATCH && (remaining > limit || (age && b->aged))) {
+            size_t i = count++;
+            for(; i > 0 && blocks[i - 1] > b->key(); --i)
+                blocks[i] = blocks[i - 1];
+            blocks[i] = b->key();
+            remaining--;
+        }
+        else if(age)
+            b->aged = true;
+        else if(count == WRITE_BACK_BATCH)
+            break;
+    }
+
+    size_t written = 0;
+    for(size_t i = 0; i < count; ++i) {
+        // the previous write-backs might have blocked and others might have changed the blocks
+        MetaBufferHead *b = get(blocks[i]);
+        if(b && b->dirty && !b->locked && b->_linkcount == 0)
+            written += write_cluster(b);
+    }
+    return written;
 }
 
 void MetaBuffer::flush() {
+    commit();
+    _journal->checkpoint_all();
+
     while(!ht.empty()) {
         MetaBufferHead *b = reinterpret_cast<MetaBufferHead*>(ht.remove_root());
         if(b->dirty)
@@ -131,6 +395,6 @@ void MetaBuffer::flush() {
 bool MetaBuffer::dirty(blockno_t bno) {
     MetaBufferHead *b = get(bno);
     if(b)
-        return b->dirty;
+        return b->dirty || _journal->pending(bno);
     return false;
 }
@@ -26,6 +26,7 @@
 
 #include "sess/FileSession.h"
 #include "Buffer.h"
+#include "Journal.h"
 
 class MetaBufferHead : public BufferHead {
     friend class MetaBuffer;
@@ -41,24 +42,83 @@ private:
 
 /*
  * stores single blocks
- * lru is the list of free blocks
- * blocks will be freed if no session uses them
+ * the policy holds the blocks that are not used by a session, in the order in which they should be
+ * reused. blocks are taken out of it while they are in use and, with the journal, while they are
+ * dirty. thus, the first block in the policy is the victim
+ * dirty blocks are written back together with adjacent dirty blocks that are not in use, unless
+ * the journal is enabled
+ * if the journal is enabled, all dirty blocks are committed to the journal in one transaction
+ * when no request is in progress, so that the journal only contains complete operations. if
+ * enough blocks are dirty, new requests are held back until the running ones are finished. while
+ * a transaction is committed, blocks that are not at home yet are not evicted
  */
 class MetaBuffer : public Buffer {
+    // the maximum number of blocks written back at once by write_back_dirty()
+    static constexpr size_t WRITE_BACK_BATCH    = 64;
+    // the number of evictable blocks that are considered to find a clean one
+    static constexpr size_t VICTIM_SCAN         = 8;
+    // the number of dirty blocks from which on we commit them to the journal
+    static constexpr size_t COMMIT_THRESHOLD    = 128;
+
 public:
     static constexpr size_t META_BUFFER_SIZE    = 512;
+    // the maximum number of adjacent blocks that are written back with one disk request
+    static constexpr size_t MAX_CLUSTER         = 16;
+
+    explicit MetaBuffer(size_t blocksize, Backend *backend, Policy *policy, Journal *journal);
 
-    explicit MetaBuffer(size_t blocksize, Backend *backend);
+    size_t dirty_blocks() const {
+        return _dirty;
+    }
+    /**
+     * @return the number of times a request had to write back or commit blocks to evict one
+     */
+    size_t stalls() const {
+        return _stalls;
+    }
 
     void *get_block(Request &r, m3::blockno_t bno, bool dirty = false);
     void quit(MetaBufferHead *b);
+    void mark_dirty(m3::blockno_t bno) override;
     void write_back(m3::blockno_t bno);
+    size_t write_back_dirty(size_t limit, bool age);
     void flush() override;
     bool dirty(m3::blockno_t);
 
+    void enter();
+    void leave();
+    void commit();
+
 private:
     MetaBufferHead *get(m3::blockno_t bno) override;
+    // whether the block is not in the eviction order of the policy
+    bool held(const MetaBufferHead *b) const {
+        return b->_linkcount > 0 || (b->dirty && _journal->enabled());
+    }
+    void release(MetaBufferHead *b);
+    MetaBufferHead *find_victim();
+    void set_dirty(MetaBufferHead *b, bool dirty);
     void flush_chunk(BufferHead *b) override;
+    size_t write_cluster(MetaBufferHead *b);
+    bool clusterable(m3::blockno_t bno);
 
     char *_blocks;
+    MetaBufferHead **_heads;
+    Journal *_journal;
+    MetaBufferHead **_txheads;
+    size_t _dirty;
+    size_t _active;
+    // the number of requests that wait for an evictable block
+    size_t _waiting;
+    bool _committing;
+    // whether new requests wait until the running ones are finished
+    bool _draining;
+    // notified when a commit is done
+    event_t _committed;
+    // notified when new requests may start
+    event_t _drained;
+    // notified when a request no longer uses a block
+    event_t _released;
+    bool _clustering;
+    size_t _stalls;
 };
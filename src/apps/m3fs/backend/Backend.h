@@ -20,6 +20,8 @@
 
 #include "../sess/Request.h"
 
+class FSHandle;
+
 class Backend {
 public:
     virtual ~Backend() {
@@ -29,13 +31,24 @@ public:
     virtual void load_data(m3::MemGate &mem, m3::blockno_t bno, size_t blocks, bool init, event_t unlock) = 0;
 
     virtual void store_meta(const void *src, size_t src_off, m3::blockno_t bno, event_t unlock) = 0;
-    virtual void store_data(m3::blockno_t bno, size_t blocks, event_t unlock) = 0;
+    // writes the blocks bno..bno+blocks-1 from <srcs> to disk at once
+    virtual void store_meta_blocks(const void *const *srcs, m3::blockno_t bno, size_t blocks) = 0;
+    // writes the blocks bno..bno+blocks-1 from byte offset <off> of the memory capability for the
+    // chunk that starts at block <cap>
+    virtual void store_data(m3::blockno_t cap, m3::blockno_t bno, size_t blocks, size_t off,
+                            event_t unlock) = 0;
 
     virtual void sync_meta(Request &r, m3::blockno_t bno) = 0;
 
+    virtual void load_journal(void *dst, m3::blockno_t bno, size_t blocks) = 0;
+    virtual void store_journal(const void *src, m3::blockno_t bno, size_t blocks) = 0;
+
     virtual size_t get_filedata(Request &r, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
                                 bool dirty, bool load, size_t accessed) = 0;
 
+    // is called outside of requests, so that it must not access metadata
+    virtual void prefetch_data(FSHandle &hdl, m3::blockno_t bno, size_t blocks) = 0;
+
     virtual void clear_extent(Request &r, m3::Extent *ext, size_t accessed) = 0;
 
     virtual void load_sb(m3::SuperBlock &sb) = 0;
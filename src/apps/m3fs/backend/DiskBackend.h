@@ -30,7 +30,9 @@ public:
     explicit DiskBackend(size_t dev)
         : _blocksize(),
           _disk(new m3::Disk("disk", dev)),
-          _metabuf() {
+          _metabuf(),
+          _journal(),
+          _journal_cap() {
     }
 
     void load_meta(void *dst, size_t dst_off, m3::blockno_t bno, event_t unlock) override {
@@ -52,8 +54,16 @@ public:
         _disk->write(0, bno, 1, _blocksize, off);
         m3::ThreadManager::get().notify(unlock);
     }
-    void store_data(m3::blockno_t bno, size_t blocks, event_t unlock) override {
-        _disk->write(bno, bno, blocks, _blocksize);
+    void store_meta_blocks(const void *const *srcs, m3::blockno_t bno, size_t blocks) override {
+        // the blocks are gathered in the cluster area behind the slots of the meta buffer
+        size_t off = MetaBuffer::META_BUFFER_SIZE * (_blocksize + MetaBuffer::PRDT_SIZE);
+        for(size_t i = 0; i < blocks; ++i)
+            _metabuf->write(srcs[i], _blocksize, off + i * _blocksize);
+        _disk->write(0, bno, blocks, _blocksize, off);
+    }
+    void store_data(m3::blockno_t cap, m3::blockno_t bno, size_t blocks, size_t off,
+                    event_t unlock) override {
+        _disk->write(cap, bno, blocks, _blocksize, off);
         m3::ThreadManager::get().notify(unlock);
     }
 
@@ -72,6 +82,15 @@ public:
             r.hdl().metabuffer().write_back(bno);
     }
 
+    void load_journal(void *dst, m3::blockno_t bno, size_t blocks) override {
+        _disk->read(_journal_cap, bno, blocks, _blocksize);
+        _journal->read(dst, blocks * _blocksize, 0);
+    }
+    void store_journal(const void *src, m3::blockno_t bno, size_t blocks) override {
+        _journal->write(src, blocks * _blocksize, 0);
+        _disk->write(_journal_cap, bno, blocks, _blocksize);
+    }
+
     size_t get_filedata(Request &r, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
                         bool dirty, bool load, size_t accessed) override {
         size_t first_block = extoff / _blocksize;
@@ -80,6 +99,10 @@ public:
                                                sel, perms, accessed, load, dirty);
     }
 
+    void prefetch_data(FSHandle &hdl, m3::blockno_t bno, size_t blocks) override {
+        hdl.filebuffer().prefetch(bno, blocks);
+    }
+
     void clear_extent(Request &r, m3::Extent *ext, size_t accessed) override {
         alignas(64) static char zeros[m3::MAX_BLOCK_SIZE];
         capsel_t sel = m3::VPE::self().alloc_sel();
@@ -106,9 +129,18 @@ public:
         // use separate transfer buffer for each entry to allow parallel disk requests
         _blocksize = sb.blocksize;
         size_t size = (_blocksize + MetaBuffer::PRDT_SIZE) * MetaBuffer::META_BUFFER_SIZE;
+        size += _blocksize * MetaBuffer::MAX_CLUSTER + MetaBuffer::PRDT_SIZE;
         _metabuf = new m3::MemGate(m3::MemGate::create_global(size, m3::MemGate::RW));
         // store the MemCap as blockno 0, bc we won't load the superblock again
         delegate_mem(*_metabuf, 0, 1);
+
+        // the journal is transferred via a separate buffer, which holds one slot
+        if(sb.journal_blocks > 0) {
+            size = _blocksize * sb.journal_slot_blocks() + MetaBuffer::PRDT_SIZE;
+            _journal = new m3::MemGate(m3::MemGate::create_global(size, m3::MemGate::RW));
+            _journal_cap = sb.first_journal_block();
+            delegate_mem(*_journal, _journal_cap, 1);
+        }
     }
 
     void store_sb(m3::SuperBlock &sb) override {
@@ -140,4 +172,6 @@ private:
     size_t _blocksize;
     m3::Disk *_disk;
     m3::MemGate *_metabuf;
+    m3::MemGate *_journal;
+    m3::blockno_t _journal_cap;
 };
@@ -40,7 +40,11 @@ public:
     void store_meta(const void *src, size_t, m3::blockno_t bno, event_t) override {
         _mem.write(src, _blocksize, bno * _blocksize);
     }
-    void store_data(m3::blockno_t, size_t, event_t) override {
+    void store_meta_blocks(const void *const *srcs, m3::blockno_t bno, size_t blocks) override {
+        for(size_t i = 0; i < blocks; ++i)
+            _mem.write(srcs[i], _blocksize, (bno + i) * _blocksize);
+    }
+    void store_data(m3::blockno_t, m3::blockno_t, size_t, size_t, event_t) override {
         // unused
     }
 
@@ -48,6 +52,13 @@ public:
         r.hdl().metabuffer().write_back(bno);
     }
 
+    void load_journal(void *dst, m3::blockno_t bno, size_t blocks) override {
+        _mem.read(dst, blocks * _blocksize, bno * _blocksize);
+    }
+    void store_journal(const void *src, m3::blockno_t bno, size_t blocks) override {
+        _mem.write(src, blocks * _blocksize, bno * _blocksize);
+    }
+
     size_t get_filedata(Request &, m3::Extent *ext, size_t extoff, int perms, capsel_t sel,
                         bool, bool, size_t) override {
         size_t first_block = extoff / _blocksize;
@@ -59,6 +70,10 @@ public:
         return bytes;
     }
 
+    void prefetch_data(FSHandle &, m3::blockno_t, size_t) override {
+        // the data is in memory already
+    }
+
     void clear_extent(Request &, m3::Extent *ext, size_t) override {
         alignas(64) static char zeros[m3::MAX_BLOCK_SIZE];
         for(uint32_t i = 0; i < ext->length; ++i)
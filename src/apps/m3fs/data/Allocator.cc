@@ -27,106 +27,54 @@ Allocator::Allocator(const char *name, uint32_t first, uint32_t *first_free, uin
       _first_free(first_free),
       _free(free),
       _total(total),
-      _blocks(blocks) {
+      _blocks(blocks),
+      _index() {
     static_assert(sizeof(blockno_t) == sizeof(uint32_t), "Wrong type");
     static_assert(sizeof(inodeno_t) == sizeof(uint32_t), "Wrong type");
 }
 
-uint32_t Allocator::alloc(Request &r, size_t *count) {
-    const size_t perblock = r.hdl().sb().blocksize * 8;
-    const uint32_t lastno = _first + _blocks - 1;
-    const size_t icount = *count;
-    uint32_t no = _first + *_first_free / perblock;
-    size_t total = 0;
-    uint32_t i = *_first_free % perblock;
-
-    while(total == 0 && no <= lastno) {
-        auto *bytes = reinterpret_cast<Bitmap::word_t*>(r.hdl().metabuffer().get_block(r, no, true));
-        // take care that total_blocks might not be a multiple of perblock
-        size_t max = perblock;
-        if(no == lastno) {
-            max = _total % perblock;
-            max = max == 0 ? perblock : max;
-        }
-        Bitmap bm(bytes);
-
-        // first, search quickly until we've found a word that has free bits
-        if(i < max && bm.is_word_set(i)) {
-            // within the first word with free bits, the first free bit is not necessarily
-            // i % Bitmap::WORD_BITS. thus, start from 0 within each word
-            i = (i + Bitmap::WORD_BITS) & ~static_cast<uint32_t>(Bitmap::WORD_BITS - 1);
-            for(; i < max && bm.is_word_set(i); i += Bitmap::WORD_BITS)
-                ;
-            if(i < max) {
-                // now walk to the actual first free bit
-                for(; bm.is_set(i); ++i)
-                    ;
-            }
-        }
-
-        // now walk until its aligned (i < max is not required here since a block is always a multiple
-        // of Bitmap::WORD_BITS and we run only until i % Bitmap::WORD_BITS == 0)
-        for(; (i % Bitmap::WORD_BITS) != 0 && total < icount; ++i) {
-            if(!bm.is_set(i)) {
-                bm.set(i);
-                total++;
-            }
-            else if(total > 0)
-                break;
-        }
-
-        // now allocate in words
-        for(; (icount - total) >= Bitmap::WORD_BITS && (max - i) >= Bitmap::WORD_BITS; i += Bitmap::WORD_BITS) {
-            if(bm.is_word_free(i)) {
-                bm.set_word(i);
-                total += Bitmap::WORD_BITS;
-            }
-            else if(total > 0)
-                break;
-        }
-
-        if(total == 0) {
-            for(; i < max && total < icount; ++i) {
-                if(!bm.is_set(i)) {
-                    bm.set(i);
-                    total++;
-                }
-            }
-        }
-        else {
-            // there might be something left
-            for(; i < max && total < icount && !bm.is_set(i); ++i) {
-                bm.set(i);
-                total++;
-            }
-        }
-
+void Allocator::build(Request &r) {
+    const uint32_t perblock = r.hdl().sb().blocksize * 8;
+    for(uint32_t b = 0; b < _blocks; ++b) {
+        void *bytes = r.hdl().metabuffer().get_block(r, _first + b);
+        Bitmap bm(reinterpret_cast<Bitmap::word_t*>(bytes));
+        // take care that total might not be a multiple of perblock. free ranges that span multiple
+        // bitmap blocks are merged by the index
+        uint32_t base = b * perblock;
+        _index.add_free(bm, base, Math::min(perblock, _total - base));
         r.pop_meta();
-        if(total == 0) {
-            no++;
-            i = 0;
-        }
     }
 
-    assert(*_free >= total);
-    *_free -= total;
-    *count = total;
-    if(total == 0)
+    SLOG(FS, _name << ": " << _index.extents() << " free ranges");
+}
+
+uint32_t Allocator::alloc(Request &r, size_t *count) {
+    uint32_t start = _index.take(count);
+    if(*count == 0)
         return 0;
-    uint32_t off = (no - _first) * perblock + i;
-    *_first_free = off;
-    uint32_t start = off - total;
-    SLOG(FS, _name << ": allocated " << start << ".." << (start + total - 1));
+
+    assert(*_free >= *count);
+    *_free -= *count;
+    *_first_free = _index.first(_total);
+    SLOG(FS, _name << ": allocated " << start << ".." << (start + *count - 1));
+
+    mark(r, start, *count, true);
     return start;
 }
 
 void Allocator::free(Request &r, uint32_t start, size_t count) {
-    size_t perblock = r.hdl().sb().blocksize * 8;
-    uint32_t no = _first + start / perblock;
     if(start < *_first_free)
         *_first_free = start;
     *_free += count;
     SLOG(FS, _name << ": free'd " << start << ".." << (start + count - 1));
+
+    _index.add(start, count);
+    mark(r, start, count, false);
+}
+
+void Allocator::mark(Request &r, uint32_t start, size_t count, bool used) {
+    size_t perblock = r.hdl().sb().blocksize * 8;
+    uint32_t no = _first + start / perblock;
     while(count > 0) {
         auto *bytes = reinterpret_cast<Bitmap::word_t*>(r.hdl().metabuffer().get_block(r, no, true));
         Bitmap bm(bytes);
@@ -136,21 +84,33 @@ void Allocator::free(Request &r, uint32_t start, size_t count) {
         uint32_t begin = i;
         uint32_t end = Math::min(static_cast<uint32_t>(i + count), static_cast<uint32_t>(perblock));
         for(; (i % Bitmap::WORD_BITS) != 0 && i < end; ++i) {
-            assert(bm.is_set(i));
-            bm.unset(i);
+            assert(bm.is_set(i) != used);
+            if(used)
+                bm.set(i);
+            else
+                bm.unset(i);
         }
 
-        // now clear in word-steps
+        // now change it in word-steps
         uint32_t wend = end & ~static_cast<uint32_t>(Bitmap::WORD_BITS - 1);
         for(; i < wend; i += Bitmap::WORD_BITS) {
-            assert(bm.is_word_set(i));
-            bm.clear_word(i);
+            if(used) {
+                assert(bm.is_word_free(i));
+                bm.set_word(i);
+            }
+            else {
+                assert(bm.is_word_set(i));
+                bm.clear_word(i);
+            }
         }
 
         // maybe, there is something left
         for(; i < end; ++i) {
-            assert(bm.is_set(i));
-            bm.unset(i);
+            assert(bm.is_set(i) != used);
+            if(used)
+                bm.set(i);
+            else
+                bm.unset(i);
         }
 
         // to next bitmap block
@@ -19,14 +19,32 @@
 #include <fs/internal.h>
 
 #include "../sess/Request.h"
+#include "FreeExtents.h"
 
 class FSHandle;
 
+/**
+ * Allocates ranges of blocks or inodes from a bitmap. The free ranges are additionally kept in an
+ * in-memory index, which is built from the bitmap at mount time, so that the smallest free range
+ * that is large enough can be found without searching the bitmap.
+ */
 class Allocator {
 public:
     explicit Allocator(const char *name, uint32_t first, uint32_t *first_free, uint32_t *free,
                        uint32_t total, uint32_t blocks);
 
+    /**
+     * Builds the index of free ranges from the bitmap
+     */
+    void build(Request &r);
+
+    /**
+     * @return the number of free ranges
+     */
+    size_t extents() const {
+        return _index.extents();
+    }
+
     uint32_t alloc(Request &r) {
         size_t count = 1;
         return alloc(r, &count);
@@ -35,10 +53,13 @@ public:
     void free(Request &r, uint32_t start, size_t count);
 
 private:
+    void mark(Request &r, uint32_t start, size_t count, bool used);
+
     const char *_name;
     uint32_t _first;
     uint32_t *_first_free;
     uint32_t *_free;
     uint32_t _total;
     uint32_t _blocks;
+    FreeExtents _index;
 };
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include "DentryCache.h"
+
+using namespace m3;
+
+DentryCache::DentryCache(size_t capacity)
+    : _capacity(capacity),
+      _mask(),
+      _gen(),
+      _hits(),
+      _misses(),
+      _entries(),
+      _table(),
+      _lru() {
+    if(_capacity > 0) {
+        size_t size = 1;
+        while(size < _capacity)
+            size *= 2;
+        _mask = size - 1;
+        _table = new Entry*[size]();
+        _entries = new Entry[_capacity];
+        for(size_t i = 0; i < _capacity; ++i)
+            _lru.append(_entries + i);
+    }
+}
+
+DentryCache::~DentryCache() {
+    delete[] _table;
+    delete[] _entries;
+}
+
+DentryCache::Entry **DentryCache::bucket(inodeno_t dir, const char *name, size_t namelen) {
+    uint32_t hash = DirIndex::hash(name, namelen) ^ (dir * 0x9E3779B1U);
+    return _table + (hash & _mask);
+}
+
+bool DentryCache::lookup(inodeno_t dir, const char *name, size_t namelen, inodeno_t *ino) {
+    if(_capacity > 0 && namelen <= NAME_LEN) {
+        for(Entry *e = *bucket(dir, name, namelen); e; e = e->hnext) {
+            if(e->matches(dir, name, namelen)) {
+                _lru.moveToEnd(e);
+                *ino = e->ino;
+                _hits++;
+                return true;
+            }
+        }
+    }
+    _misses++;
+    return false;
+}
+
+void DentryCache::set(inodeno_t dir, const char *name, size_t namelen, inodeno_t ino) {
+    if(_capacity == 0 || namelen > NAME_LEN)
+        return;
+
+    Entry **head = bucket(dir, name, namelen);
+    Entry *e;
+    for(e = *head; e; e = e->hnext) {
+        if(e->matches(dir, name, namelen))
+            break;
+    }
+
+    // replace the least recently used entry, if there is none for this name yet
+    if(!e) {
+        e = &*_lru.begin();
+        if(e->used)
+            unlink(e);
+        e->used = true;
+        e->dir = dir;
+        e->namelen = namelen;
+        memcpy(e->name, name, namelen);
+        e->hnext = *head;
+        *head = e;
+    }
+
+    e->ino = ino;
+    _lru.moveToEnd(e);
+}
+
+void DentryCache::remove_dir(inodeno_t dir) {
+    _gen++;
+    for(size_t i = 0; i < _capacity; ++i) {
+        Entry *e = _entries + i;
+        if(e->used && e->dir == dir) {
+            unlink(e);
+            // reuse it first
+            _lru.remove(e);
+            _lru.prepend(e);
+        }
+    }
+}
+
+void DentryCache::unlink(Entry *e) {
+    Entry **prev = bucket(e->dir, e->name, e->namelen);
+    while(*prev != e)
+        prev = &(*prev)->hnext;
+    *prev = e->hnext;
+    e->hnext = nullptr;
+    e->used = false;
+}
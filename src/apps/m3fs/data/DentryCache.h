@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/col/DList.h>
+
+#include <fs/internal.h>
+
+/**
+ * Caches the results of looking up a name in a directory, including the names that do not exist.
+ * The cache has a fixed number of entries, which are replaced in LRU order. Since lookups might
+ * block while loading directory blocks, results are only added if the cache has not been
+ * invalidated in the meantime (see generation()).
+ */
+class DentryCache {
+    static constexpr size_t NAME_LEN    = 32;
+
+    struct Entry : public m3::DListItem {
+        explicit Entry()
+            : DListItem(),
+              hnext(),
+              used(),
+              dir(),
+              ino(),
+              namelen(),
+              name() {
+        }
+
+        bool matches(m3::inodeno_t dir, const char *name, size_t namelen) const {
+            return used && this->dir == dir && this->namelen == namelen &&
+                   strncmp(this->name, name, namelen) == 0;
+        }
+
+        Entry *hnext;
+        bool used;
+        m3::inodeno_t dir;
+        m3::inodeno_t ino;
+        size_t namelen;
+        char name[NAME_LEN];
+    };
+
+public:
+    explicit DentryCache(size_t capacity);
+    ~DentryCache();
+
+    size_t capacity() const {
+        return _capacity;
+    }
+    size_t hits() const {
+        return _hits;
+    }
+    size_t misses() const {
+        return _misses;
+    }
+    /**
+     * @return the number of modifications so far
+     */
+    uint generation() const {
+        return _gen;
+    }
+
+    /**
+     * Looks up <name> in directory <dir>.
+     *
+     * @param ino will be set to the inode or INVALID_INO if the name does not exist
+     * @return true if the result is known
+     */
+    bool lookup(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t *ino);
+
+    /**
+     * Remembers the result of a lookup, unless the cache has been modified since <gen>.
+     */
+    void add(uint gen, m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t ino) {
+        if(gen == _gen)
+            set(dir, name, namelen, ino);
+    }
+
+    /**
+     * Updates the entry for <name> in <dir>, which has been linked to <ino> or has been removed
+     * (ino = INVALID_INO).
+     */
+    void update(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t ino) {
+        _gen++;
+        set(dir, name, namelen, ino);
+    }
+
+    /**
+     * Removes all entries in directory <dir>, because its inode has been freed.
+     */
+    void remove_dir(m3::inodeno_t dir);
+
+private:
+    void set(m3::inodeno_t dir, const char *name, size_t namelen, m3::inodeno_t ino);
+    Entry **bucket(m3::inodeno_t dir, const char *name, size_t namelen);
+    void unlink(Entry *e);
+
+    size_t _capacity;
+    size_t _mask;
+    uint _gen;
+    size_t _hits;
+    size_t _misses;
+    Entry *_entries;
+    Entry **_table;
+    m3::DList<Entry> _lru;
+};
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/log/Services.h>
+
+#include "DirIndexes.h"
+#include "Dirs.h"
+#include "INodes.h"
+#include "Links.h"
+
+using namespace m3;
+
+static bool is_dot(const char *name, size_t namelen) {
+    return (namelen == 1 && name[0] == '.') || (namelen == 2 && name[0] == '.' && name[1] == '.');
+}
+
+DirIndex *DirIndexes::get(Request &r, INode *dir) {
+    if(!(dir->flags & INODE_INDEXED))
+        return nullptr;
+
+    char *first = reinterpret_cast<char*>(r.hdl().metabuffer().get_block(r, dir->direct[0].start));
+    DirIndex *idx = reinterpret_cast<DirIndex*>(first + DirIndex::OFFSET);
+    if(idx->magic != DirIndex::MAGIC) {
+        r.pop_meta();
+        return nullptr;
+    }
+    return idx;
+}
+
+blockno_t DirIndexes::lookup(Request &r, INode *dir, const char *name, size_t namelen) {
+    // "." and ".." are always in the first block
+    if(is_dot(name, namelen))
+        return (dir->flags & INODE_INDEXED) ? dir->direct[0].start : 0;
+
+    DirIndex *idx = get(r, dir);
+    if(!idx)
+        return 0;
+    blockno_t bno = idx->buckets[idx->slot(DirIndex::hash(name, namelen))];
+    r.pop_meta();
+    return bno;
+}
+
+Errors::Code DirIndexes::insert(Request &r, INode *dir, const char *name, size_t namelen,
+                                inodeno_t ino) {
+    uint32_t hash = DirIndex::hash(name, namelen);
+    while(true) {
+        blockno_t bno = lookup(r, dir, name, namelen);
+        if(bno == 0)
+            return Errors::NOT_SUP;
+        if(Links::add_to_block(r, bno, name, namelen, ino))
+            return Errors::NONE;
+
+        Errors::Code res = split(r, dir, hash);
+        if(res != Errors::NONE)
+            return res;
+    }
+}
+
+Errors::Code DirIndexes::split(Request &r, INode *dir, uint32_t hash) {
+    size_t org_used = r.used_meta();
+    DirIndex *idx = get(r, dir);
+    assert(idx != nullptr);
+
+    size_t slot = idx->slot(hash);
+    blockno_t old = idx->buckets[slot];
+    size_t refs = 0;
+    for(size_t i = 0; i < idx->slots(); ++i)
+        refs += idx->buckets[i] == old;
+
+    // if only one slot refers to the bucket, we have to double the number of slots first
+    if(refs == 1) {
+        if(idx->depth == DirIndex::max_depth(r.hdl().sb().blocksize)) {
+            drop(r, dir, idx);
+            r.pop_meta(r.used_meta() - org_used);
+            return Errors::NOT_SUP;
+        }
+        memcpy(idx->buckets + idx->slots(), idx->buckets, idx->slots() * sizeof(blockno_t));
+        idx->depth++;
+        refs = 2;
+    }
+
+    blockno_t bno = Links::append_block(r, dir);
+    if(bno == 0) {
+        r.hdl().metabuffer().mark_dirty(dir->direct[0].start);
+        r.pop_meta(r.used_meta() - org_used);
+        return Errors::NO_SPACE;
+    }
+
+    // the entries of the bucket agree in the lowest <bit> bits; split them on the next one
+    uint32_t bit = idx->depth;
+    for(; refs > 1; refs /= 2)
+        bit--;
+    for(size_t i = 0; i < idx->slots(); ++i) {
+        if(idx->buckets[i] == old && ((i >> bit) & 1))
+            idx->buckets[i] = bno;
+    }
+    r.hdl().metabuffer().mark_dirty(dir->direct[0].start);
+
+    // move the entries to the buckets they belong to now
+    size_t blocksize = r.hdl().sb().blocksize;
+    char *copy = new char[blocksize];
+    memcpy(copy, r.hdl().metabuffer().get_block(r, old), blocksize);
+    r.pop_meta();
+    clear_block(r, old);
+
+    DirEntry *e = reinterpret_cast<DirEntry*>(copy);
+    DirEntry *end = reinterpret_cast<DirEntry*>(copy + blocksize);
+    for(; e < end; e = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(e) + e->next)) {
+        if(e->namelen == 0)
+            continue;
+        uint32_t ehash = DirIndex::hash(e->name, e->namelen);
+        UNUSED bool res = Links::add_to_block(r, ((ehash >> bit) & 1) ? bno : old,
+                                              e->name, e->namelen, e->nodeno);
+        assert(res);
+    }
+
+    delete[] copy;
+    r.pop_meta(r.used_meta() - org_used);
+    return Errors::NONE;
+}
+
+void DirIndexes::drop(Request &r, INode *dir, DirIndex *idx) {
+    SLOG(FS, "Removing index of directory " << dir->inode);
+    // the buckets stay as they are; they are just searched linearly now
+    idx->magic = 0;
+    r.hdl().metabuffer().mark_dirty(dir->direct[0].start);
+    dir->flags &= static_cast<uint8_t>(~INODE_INDEXED);
+    INodes::mark_dirty(r, dir->inode);
+}
+
+void DirIndexes::clear_block(Request &r, blockno_t bno) {
+    DirEntry *e = reinterpret_cast<DirEntry*>(r.hdl().metabuffer().get_block(r, bno, true));
+    e->nodeno = 0;
+    e->namelen = 0;
+    e->next = r.hdl().sb().blocksize;
+    r.pop_meta();
+}
+
+bool DirIndexes::build(Request &r, INode *dir) {
+    size_t blocksize = r.hdl().sb().blocksize;
+    size_t blocks = dir->size / blocksize;
+    uint32_t depth = 0;
+    // start with as many buckets as there are blocks with entries
+    while((static_cast<size_t>(1) << depth) < blocks)
+        depth++;
+    if(depth > DirIndex::max_depth(blocksize))
+        return false;
+
+    size_t org_used = r.used_meta();
+
+    // the first block has to start with "." and "..", because the index is stored behind them
+    DirEntry *dot = reinterpret_cast<DirEntry*>(r.hdl().metabuffer().get_block(r, dir->direct[0].start));
+    DirEntry *dotdot = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(dot) + dot->next);
+    bool dots = dot->namelen == 1 && dot->name[0] == '.' && dot->next == sizeof(DirEntry) + 1 &&
+                dotdot->namelen == 2 && strncmp(dotdot->name, "..", 2) == 0;
+    r.pop_meta();
+    if(!dots)
+        return false;
+
+    // allocate the missing buckets first to leave the directory untouched on failure
+    size_t buckets = static_cast<size_t>(1) << depth;
+    while(blocks - 1 < buckets) {
+        if(Links::append_block(r, dir) == 0)
+            return false;
+        blocks++;
+    }
+
+    SLOG(FS, "Indexing directory " << dir->inode << " with " << buckets << " buckets");
+
+    // copy all entries but "." and "..", because we reuse the blocks
+    char *copy = new char[blocks * blocksize];
+    blockno_t *bnos = new blockno_t[blocks];
+    size_t pos = 0, count = 0;
+    foreach_extent(r, dir, ext) {
+        foreach_block(ext, bno) {
+            bnos[count++] = bno;
+            foreach_direntry(r, bno, e) {
+                if(e->namelen == 0 || is_dot(e->name, e->namelen))
+                    continue;
+                memcpy(copy + pos, e, sizeof(DirEntry) + e->namelen);
+                reinterpret_cast<DirEntry*>(copy + pos)->next = sizeof(DirEntry) + e->namelen;
+                pos += sizeof(DirEntry) + e->namelen;
+            }
+            r.pop_meta();
+        }
+        r.pop_meta(r.used_meta() - org_used);
+    }
+
+    // let ".." span the first block and put the index behind it
+    char *first = reinterpret_cast<char*>(r.hdl().metabuffer().get_block(r, bnos[0], true));
+    dotdot = reinterpret_cast<DirEntry*>(first + sizeof(DirEntry) + 1);
+    dotdot->next = blocksize - (sizeof(DirEntry) + 1);
+    DirIndex *idx = reinterpret_cast<DirIndex*>(first + DirIndex::OFFSET);
+    idx->magic = DirIndex::MAGIC;
+    idx->depth = depth;
+    for(size_t i = 0; i < buckets; ++i)
+        idx->buckets[i] = bnos[i + 1];
+    r.pop_meta();
+    dir->flags |= INODE_INDEXED;
+    INodes::mark_dirty(r, dir->inode);
+
+    // all buckets are empty now
+    for(size_t i = 1; i < count; ++i)
+        clear_block(r, bnos[i]);
+
+    // now insert the entries into the buckets
+    Errors::Code res = Errors::NONE;
+    for(size_t off = 0; off < pos; ) {
+        DirEntry *e = reinterpret_cast<DirEntry*>(copy + off);
+        if(res == Errors::NONE) {
+            res = insert(r, dir, e->name, e->namelen, e->nodeno);
+            // if that failed, remove the index and put the remaining entries anywhere
+            if(res != Errors::NONE) {
+                DirIndex *idx = get(r, dir);
+                if(idx) {
+                    drop(r, dir, idx);
+                    r.pop_meta();
+                }
+            }
+        }
+        if(res != Errors::NONE) {
+            for(size_t i = 1; i < count; ++i) {
+                if(Links::add_to_block(r, bnos[i], e->name, e->namelen, e->nodeno))
+                    break;
+            }
+        }
+        off += e->next;
+    }
+
+    delete[] bnos;
+    delete[] copy;
+    r.pop_meta(r.used_meta() - org_used);
+    return true;
+}
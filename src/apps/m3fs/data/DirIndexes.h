@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <fs/internal.h>
+
+#include "../sess/Request.h"
+
+/**
+ * Maintains the hash index of large directories (see m3::DirIndex)
+ */
+class DirIndexes {
+    DirIndexes() = delete;
+
+public:
+    /**
+     * @return the block that contains the entry with given name, if <dir> is indexed, or 0
+     */
+    static m3::blockno_t lookup(Request &r, m3::INode *dir, const char *name, size_t namelen);
+
+    /**
+     * Inserts the given entry into the bucket of the index and splits it, if necessary. If the
+     * index cannot grow anymore, it is removed and NOT_SUP is returned.
+     */
+    static m3::Errors::Code insert(Request &r, m3::INode *dir, const char *name, size_t namelen,
+                                   m3::inodeno_t ino);
+
+    /**
+     * Creates the index for the linear directory <dir> and moves the entries into the buckets.
+     *
+     * @return true on success
+     */
+    static bool build(Request &r, m3::INode *dir);
+
+private:
+    static m3::DirIndex *get(Request &r, m3::INode *dir);
+    static m3::Errors::Code split(Request &r, m3::INode *dir, uint32_t hash);
+    static void drop(Request &r, m3::INode *dir, m3::DirIndex *idx);
+    static void clear_block(Request &r, m3::blockno_t bno);
+};
@@ -16,6 +16,7 @@
 
 #include <libgen.h>
 
+#include "DirIndexes.h"
 #include "Dirs.h"
 #include "INodes.h"
 #include "Links.h"
@@ -25,6 +26,17 @@ using namespace m3;
 static constexpr size_t BUF_SIZE = 64;
 
 DirEntry *Dirs::find_entry(Request &r, INode *inode, const char *name, size_t namelen) {
+    // in indexed directories, we know the block already
+    blockno_t bucket = DirIndexes::lookup(r, inode, name, namelen);
+    if(bucket) {
+        foreach_direntry(r, bucket, e) {
+            if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0)
+                return e;
+        }
+        r.pop_meta();
+        return nullptr;
+    }
+
     size_t org_used = r.used_meta();
     foreach_extent(r, inode, ext) {
         foreach_block(ext, bno) {
@@ -39,6 +51,23 @@ DirEntry *Dirs::find_entry(Request &r, INode *inode, const char *name, size_t na
     return nullptr;
 }
 
+inodeno_t Dirs::lookup(Request &r, inodeno_t dir, const char *name, size_t namelen) {
+    DentryCache &cache = r.hdl().dentries();
+    inodeno_t ino;
+    if(cache.lookup(dir, name, namelen, &ino))
+        return ino;
+
+    // loading the blocks might block, so that others might change the directory meanwhile
+    uint gen = cache.generation();
+    size_t org_used = r.used_meta();
+    DirEntry *e = find_entry(r, INodes::get(r, dir), name, namelen);
+    ino = e ? e->nodeno : INVALID_INO;
+    r.pop_meta(r.used_meta() - org_used);
+
+    cache.add(gen, dir, name, namelen, ino);
+    return ino;
+}
+
 inodeno_t Dirs::search(Request &r, const char *path, bool create) {
     while(*path == '/')
         path++;
@@ -46,39 +75,30 @@ inodeno_t Dirs::search(Request &r, const char *path, bool create) {
     if(*path == '\0')
         return 0;
 
-    INode *inode;
     const char *end;
     size_t namelen;
     inodeno_t ino = 0;
-    size_t org_used = r.used_meta();
     while(1) {
-        inode = INodes::get(r, ino);
         // find path component end
         end = path;
         while(*end && *end != '/')
             end++;
 
         namelen = static_cast<size_t>(end - path);
-        DirEntry *e = find_entry(r, inode, path, namelen);
+        inodeno_t next = lookup(r, ino, path, namelen);
         // in any case, skip trailing slashes (see if(create) ...)
         while(*end == '/')
             end++;
         // stop if the file doesn't exist
-        if(!e) {
-            r.pop_meta();
+        if(next == INVALID_INO)
             break;
-        }
         // if the path is empty, we're done
-        if(!*end) {
-            r.pop_meta(r.used_meta() - org_used);
-            return e->nodeno;
-        }
+        if(!*end)
+            return next;
 
         // to next layer
-        ino = e->nodeno;
+        ino = next;
         path = end;
-
-        r.pop_meta(r.used_meta() - org_used);
     }
 
     if(create) {
@@ -93,9 +113,9 @@ inodeno_t Dirs::search(Request &r, const char *path, bool create) {
         if(!ninode) {
             return INVALID_INO;
         }
-        Errors::Code res = Links::create(r, inode, path, namelen, ninode);
+        Errors::Code res = Links::create(r, INodes::get(r, ino), path, namelen, ninode);
         if(res != Errors::NONE) {
-            r.hdl().files().delete_file(ninode->inode);
+            r.hdl().files().delete_file(r, ninode->inode);
             return INVALID_INO;
         }
         return ninode->inode;
@@ -151,7 +171,7 @@ errLink2:
 errLink1:
     Links::remove(r, parinode, base, baselen, true);
 errINode:
-    r.hdl().files().delete_file(dirinode->inode);
+    r.hdl().files().delete_file(r, dirinode->inode);
     return res;
 }
 
@@ -170,7 +190,8 @@ Errors::Code Dirs::remove(Request &r, const char *path) {
     foreach_extent(r, inode, ext) {
         foreach_block(ext, bno) {
             foreach_direntry(r, bno, e) {
-                if(!(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
+                if(e->namelen != 0 &&
+                   !(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
                    !(e->namelen == 2 && strncmp(e->name, "..", 2) == 0)) {
                     r.pop_meta(r.used_meta() - org_used);
                     return Errors::DIR_NOT_EMPTY;
@@ -33,6 +33,7 @@ class Dirs {
     Dirs() = delete;
 
     static m3::DirEntry *find_entry(Request &r, m3::INode *inode, const char *name, size_t namelen);
+    static m3::inodeno_t lookup(Request &r, m3::inodeno_t dir, const char *name, size_t namelen);
 
 public:
     static m3::inodeno_t search(Request &r, const char *path, bool create = false);
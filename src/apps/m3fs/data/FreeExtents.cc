@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include "FreeExtents.h"
+
+FreeExtents::~FreeExtents() {
+    while(!_by_addr.empty()) {
+        Extent *e = _by_addr.remove_root();
+        delete e;
+    }
+}
+
+uint32_t FreeExtents::first(uint32_t none) const {
+    Extent *e = _by_addr.find_next(0);
+    return e ? e->key() : none;
+}
+
+void FreeExtents::add(uint32_t start, size_t count) {
+    uint32_t end = start + static_cast<uint32_t>(count);
+
+    Extent *prev = start > 0 ? _by_addr.find(start - 1) : nullptr;
+    if(prev) {
+        assert(prev->key() + prev->count == start);
+        remove(prev);
+        start = prev->key();
+        delete prev;
+    }
+
+    Extent *next = _by_addr.find(end);
+    if(next) {
+        assert(next->key() == end);
+        remove(next);
+        end += next->count;
+        delete next;
+    }
+
+    insert(new Extent(start, end - start));
+}
+
+void FreeExtents::add_free(const m3::Bitmap &bm, uint32_t base, uint32_t max) {
+    for(uint32_t i = bm.find(0, max, false); i < max; ) {
+        uint32_t used = bm.find(i, max, true);
+        add(base + i, used - i);
+        i = bm.find(used, max, false);
+    }
+}
+
+uint32_t FreeExtents::take(size_t *count) {
+    SizeNode *n = _by_size.find_next(size_key(0, static_cast<uint32_t>(*count)));
+    if(!n)
+        n = _by_size.last();
+    if(!n) {
+        *count = 0;
+        return 0;
+    }
+
+    Extent *e = n->ext;
+    uint32_t start = e->key();
+    remove(e);
+    if(e->count > *count) {
+        e->key(start + static_cast<uint32_t>(*count));
+        e->count -= static_cast<uint32_t>(*count);
+        insert(e);
+    }
+    else {
+        *count = e->count;
+        delete e;
+    }
+    return start;
+}
+
+void FreeExtents::insert(Extent *e) {
+    e->by_size.key(size_key(e->key(), e->count));
+    _by_addr.insert(e);
+    _by_size.insert(&e->by_size);
+    _extents++;
+}
+
+void FreeExtents::remove(Extent *e) {
+    _by_addr.remove(e);
+    _by_size.remove(&e->by_size);
+    _extents--;
+}
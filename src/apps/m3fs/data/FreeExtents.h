@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/col/Treap.h>
+
+#include <fs/internal.h>
+
+/**
+ * An in-memory index of the free ranges in an allocation bitmap. The ranges are kept in two trees,
+ * one ordered by address to merge adjacent ranges and one ordered by size to find the smallest
+ * range that is large enough in O(log n).
+ */
+class FreeExtents {
+    struct Extent;
+
+    struct SizeNode : public m3::TreapNode<SizeNode, uint64_t> {
+        explicit SizeNode(Extent *ext)
+            : TreapNode(0),
+              ext(ext) {
+        }
+
+        Extent *ext;
+    };
+
+    struct Extent : public m3::TreapNode<Extent, uint32_t> {
+        explicit Extent(uint32_t start, uint32_t count)
+            : TreapNode(start),
+              count(count),
+              by_size(this) {
+        }
+
+        bool matches(uint32_t no) {
+            return (key() <= no) && (no < key() + count);
+        }
+
+        uint32_t count;
+        SizeNode by_size;
+    };
+
+public:
+    explicit FreeExtents()
+        : _by_addr(),
+          _by_size(),
+          _extents() {
+    }
+    ~FreeExtents();
+
+    /**
+     * @return the number of free ranges
+     */
+    size_t extents() const {
+        return _extents;
+    }
+
+    /**
+     * @param none the value to return if nothing is free
+     * @return the first free number
+     */
+    uint32_t first(uint32_t none) const;
+
+    /**
+     * Adds the free range <start>..<start>+<count>-1, which is merged with adjacent ranges.
+     */
+    void add(uint32_t start, size_t count);
+
+    /**
+     * Adds the unset bits 0..<max>-1 of <bm> as the free numbers <base>..<base>+<max>-1. Ranges
+     * that continue in the next part of the bitmap are merged when that part is added.
+     */
+    void add_free(const m3::Bitmap &bm, uint32_t base, uint32_t max);
+
+    /**
+     * Removes <count> numbers from the smallest range that has at least <count> numbers. If there
+     * is no such range, the largest range is used.
+     *
+     * @param count the number of numbers; will be set to the number of removed numbers
+     * @return the first removed number
+     */
+    uint32_t take(size_t *count);
+
+private:
+    void insert(Extent *e);
+    void remove(Extent *e);
+
+    static uint64_t size_key(uint32_t start, uint32_t count) {
+        // the start makes the keys unique
+        return (static_cast<uint64_t>(count) << 32) | start;
+    }
+
+    m3::Treap<Extent> _by_addr;
+    m3::Treap<SizeNode> _by_size;
+    size_t _extents;
+};
@@ -42,6 +42,8 @@ INode *INodes::create(Request &r, mode_t mode) {
 void INodes::free(Request &r, inodeno_t ino) {
     INode *inode = get(r, ino);
     if(inode) {
+        // forget the cached lookups in this inode; the number might be reused for a directory
+        r.hdl().dentries().remove_dir(ino);
         truncate(r, inode, 0, 0);
         r.hdl().inodes().free(r, inode->inode, 1);
     }
@@ -360,6 +362,7 @@ void INodes::truncate(Request &r, INode *inode, size_t extent, size_t extoff) {
         for(size_t i = inode->extents - 1; i > extent; --i) {
             Extent *ext = change_extent(r, inode, i, &indir, true);
             assert(ext && ext->length > 0);
+            r.hdl().filebuffer().discard(ext->start, ext->length);
             r.hdl().blocks().free(r, ext->start, ext->length);
             inode->extents--;
             inode->size -= ext->length * blocksize;
@@ -380,8 +383,10 @@ void INodes::truncate(Request &r, INode *inode, size_t extent, size_t extoff) {
                 size_t diff = curlen - extoff;
                 size_t bdiff = extoff == 0 ? Math::round_up<size_t>(diff, blocksize) : diff;
                 size_t blocks = bdiff / blocksize;
-                if(blocks > 0)
+                if(blocks > 0) {
+                    r.hdl().filebuffer().discard(ext->start + ext->length - blocks, blocks);
                     r.hdl().blocks().free(r, ext->start + ext->length - blocks, blocks);
+                }
                 inode->size -= diff;
                 ext->length -= blocks;
                 if(ext->length == 0) {
@@ -14,104 +14,176 @@
  * General Public License version 2 for more details.
  */
 
+#include "DirIndexes.h"
 #include "Dirs.h"
 #include "INodes.h"
 #include "Links.h"
 
 using namespace m3;
 
-Errors::Code Links::create(Request &r, INode *dir, const char *name, size_t namelen, INode *inode) {
-    size_t rem;
-    DirEntry *e;
+static void write_entry(DirEntry *e, const char *name, size_t namelen, inodeno_t ino, size_t next) {
+    e->namelen = namelen;
+    e->nodeno = ino;
+    e->next = next;
+    strncpy(e->name, name, namelen);
+}
 
+bool Links::add_to_block(Request &r, blockno_t bno, const char *name, size_t namelen, inodeno_t ino) {
     size_t org_used = r.used_meta();
-    foreach_extent(r, dir, ext) {
-        foreach_block(ext, bno) {
-            foreach_direntry(r, bno, de) {
-                rem = de->next - (sizeof(DirEntry) + de->namelen);
-                if(rem >= sizeof(DirEntry) + namelen) {
-                    // change previous entry
-                    de->next = de->namelen + sizeof(DirEntry);
-                    // get pointer to new one
-                    e = reinterpret_cast<DirEntry*>(reinterpret_cast<uintptr_t>(de) + de->next);
-                    r.hdl().metabuffer().mark_dirty(bno);
+    foreach_direntry(r, bno, de) {
+        // the block is empty; reuse its entry
+        if(de->namelen == 0 && de->next >= sizeof(DirEntry) + namelen) {
+            write_entry(de, name, namelen, ino, de->next);
+            r.hdl().metabuffer().mark_dirty(bno);
+            r.pop_meta(r.used_meta() - org_used);
+            return true;
+        }
+
+        size_t rem = de->next - (sizeof(DirEntry) + de->namelen);
+        if(rem >= sizeof(DirEntry) + namelen) {
+            // change previous entry
+            de->next = de->namelen + sizeof(DirEntry);
+            // put the new one behind it
+            DirEntry *e = reinterpret_cast<DirEntry*>(reinterpret_cast<uintptr_t>(de) + de->next);
+            write_entry(e, name, namelen, ino, rem);
+            r.hdl().metabuffer().mark_dirty(bno);
+            r.pop_meta(r.used_meta() - org_used);
+            return true;
+        }
+    }
+    r.pop_meta(r.used_meta() - org_used);
+    return false;
+}
+
+blockno_t Links::append_block(Request &r, INode *dir) {
+    size_t org_used = r.used_meta();
+    Extent *indir = nullptr;
+    Extent *ext = INodes::get_extent(r, dir, dir->extents, &indir, true);
+    if(!ext) {
+        r.pop_meta(r.used_meta() - org_used);
+        return 0;
+    }
+
+    // insert one block in extent
+    INodes::fill_extent(r, dir, ext, 1, 1);
+    blockno_t bno = ext->start;
+    if(ext->length == 0) {
+        r.pop_meta(r.used_meta() - org_used);
+        return 0;
+    }
+
+    // the block starts with an empty entry that spans the whole block
+    DirEntry *e = reinterpret_cast<DirEntry*>(r.hdl().metabuffer().get_block(r, bno, true));
+    write_entry(e, "", 0, 0, r.hdl().sb().blocksize);
+    r.pop_meta(r.used_meta() - org_used);
+    return bno;
+}
+
+Errors::Code Links::create(Request &r, INode *dir, const char *name, size_t namelen, INode *inode) {
+    if(dir->flags & INODE_INDEXED) {
+        Errors::Code res = DirIndexes::insert(r, dir, name, namelen, inode->inode);
+        // if the index is exhausted, it has been removed and we continue without it
+        if(res == Errors::NONE)
+            goto found;
+        if(res != Errors::NOT_SUP)
+            return res;
+    }
+
+    {
+        size_t org_used = r.used_meta();
+        foreach_extent(r, dir, ext) {
+            foreach_block(ext, bno) {
+                if(add_to_block(r, bno, name, namelen, inode->inode)) {
                     r.pop_meta(r.used_meta() - org_used);
                     goto found;
                 }
             }
-            r.pop_meta();
+            r.pop_meta(r.used_meta() - org_used);
         }
-        r.pop_meta(r.used_meta() - org_used);
     }
 
-    // no suitable space found; extend directory
-    {
-        Extent *indir = nullptr;
-        Extent *ext = INodes::get_extent(r, dir, dir->extents, &indir, true);
-        if(!ext)
-            return Errors::NO_SPACE;
+    // no suitable space found; index the directory if it became too large
+    if(!(dir->flags & INODE_INDEXED) && dir->size / r.hdl().sb().blocksize >= DirIndex::MIN_BLOCKS &&
+       DirIndexes::build(r, dir)) {
+        return create(r, dir, name, namelen, inode);
+    }
 
-        // insert one block in extent
-        INodes::fill_extent(r, dir, ext, 1, 1);
-        if(ext->length == 0)
+    // extend directory
+    {
+        blockno_t bno = append_block(r, dir);
+        if(bno == 0)
             return Errors::NO_SPACE;
-
-        // put entry at the beginning of the block
-        e = reinterpret_cast<DirEntry*>(r.hdl().metabuffer().get_block(r, ext->start, true));
-        rem = r.hdl().sb().blocksize;
+        add_to_block(r, bno, name, namelen, inode->inode);
     }
 
 found:
-    // write entry
-    e->namelen = namelen;
-    e->nodeno = inode->inode;
-    e->next = rem;
-    strncpy(e->name, name, namelen);
-
+    r.hdl().dentries().update(dir->inode, name, namelen, inode->inode);
     inode->links++;
     INodes::mark_dirty(r, inode->inode);
     return Errors::NONE;
 }
 
+Errors::Code Links::remove_from_block(Request &r, inodeno_t dir, blockno_t bno, const char *name,
+                                      size_t namelen, bool isdir) {
+    size_t org_used = r.used_meta();
+    DirEntry *prev = nullptr;
+    foreach_direntry(r, bno, e) {
+        if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0) {
+            // if we're not removing a dir, we're coming from unlink(). in this case, directories
+            // are not allowed
+            INode *inode = INodes::get(r, e->nodeno);
+            if(!isdir && M3FS_ISDIR(inode->mode)) {
+                r.pop_meta(r.used_meta() - org_used);
+                return Errors::IS_DIR;
+            }
+
+            // remove entry by skipping over it
+            if(prev)
+                prev->next += e->next;
+            // copy the next entry back, if there is any
+            else {
+                DirEntry *next = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(e) + e->next);
+                if(next < __eend) {
+                    // the entries might overlap
+                    size_t dist = e->next + next->next;
+                    memmove(e, next, sizeof(DirEntry) + next->namelen);
+                    e->next = dist;
+                }
+                // otherwise, the block is empty now
+                else {
+                    e->namelen = 0;
+                    e->nodeno = 0;
+                }
+            }
+            r.hdl().metabuffer().mark_dirty(bno);
+            r.hdl().dentries().update(dir, name, namelen, INVALID_INO);
+
+            // reduce links and free, if necessary
+            if(--inode->links == 0)
+                r.hdl().files().delete_file(r, inode->inode);
+            r.pop_meta(r.used_meta() - org_used);
+            return Errors::NONE;
+        }
+
+        prev = e;
+    }
+    r.pop_meta(r.used_meta() - org_used);
+    return Errors::NO_SUCH_FILE;
+}
+
 Errors::Code Links::remove(Request &r, INode *dir, const char *name, size_t namelen, bool isdir) {
+    blockno_t bucket = DirIndexes::lookup(r, dir, name, namelen);
+    if(bucket)
+        return remove_from_block(r, dir->inode, bucket, name, namelen, isdir);
+
     size_t org_used = r.used_meta();
     foreach_extent(r, dir, ext) {
         foreach_block(ext, bno) {
-            DirEntry *prev = nullptr;
-            foreach_direntry(r, bno, e) {
-                if(e->namelen == namelen && strncmp(e->name, name, namelen) == 0) {
-                    // if we're not removing a dir, we're coming from unlink(). in this case, directories
-                    // are not allowed
-                    INode *inode = INodes::get(r, e->nodeno);
-                    if(!isdir && M3FS_ISDIR(inode->mode)) {
-                        r.pop_meta(r.used_meta() - org_used);
-                        return Errors::IS_DIR;
-                    }
-
-                    // remove entry by skipping over it
-                    if(prev)
-                        prev->next += e->next;
-                    // copy the next entry back, if there is any
-                    else {
-                        DirEntry *next = reinterpret_cast<DirEntry*>(reinterpret_cast<char*>(e) + e->next);
-                        if(next < __eend) {
-                            size_t dist = e->next;
-                            memcpy(e, next, sizeof(DirEntry) + next->namelen);
-                            e->next = dist + next->next;
-                        }
-                    }
-                    r.hdl().metabuffer().mark_dirty(bno);
-
-                    // reduce links and free, if necessary
-                    if(--inode->links == 0)
-                        r.hdl().files().delete_file(inode->inode);
-                    r.pop_meta(r.used_meta() - org_used);
-                    return Errors::NONE;
-                }
-
-                prev = e;
+            Errors::Code res = remove_from_block(r, dir->inode, bno, name, namelen, isdir);
+            if(res != Errors::NO_SUCH_FILE) {
+                r.pop_meta(r.used_meta() - org_used);
+                return res;
             }
-            r.pop_meta();
         }
         r.pop_meta(r.used_meta() - org_used);
     }
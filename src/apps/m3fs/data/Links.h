@@ -26,4 +26,12 @@ public:
                                    m3::INode *inode);
     static m3::Errors::Code remove(Request &r, m3::INode *dir, const char *name, size_t namelen,
                                    bool isdir);
+
+    static bool add_to_block(Request &r, m3::blockno_t bno, const char *name, size_t namelen,
+                             m3::inodeno_t ino);
+    static m3::blockno_t append_block(Request &r, m3::INode *dir);
+
+private:
+    static m3::Errors::Code remove_from_block(Request &r, m3::inodeno_t dir, m3::blockno_t bno,
+                                              const char *name, size_t namelen, bool isdir);
 };
@@ -52,11 +52,14 @@ static Server<M3FSRequestHandler> *srv;
 class M3FSRequestHandler : public base_class {
 public:
     explicit M3FSRequestHandler(Backend *backend, size_t extend, bool clear,
-                                bool revoke_first, size_t max_load)
+                                bool revoke_first, size_t max_load, size_t max_prefetch,
+                                size_t dentries, uint dirty_ratio, size_t max_age,
+                                const char *policy)
         : base_class(),
           _rgate(RecvGate::create(nextlog2<32 * M3FSSession::MSG_SIZE>::val,
                                   nextlog2<M3FSSession::MSG_SIZE>::val)),
-          _handle(backend, extend, clear, revoke_first, max_load) {
+          _handle(backend, extend, clear, revoke_first, max_load, max_prefetch, dentries,
+                  dirty_ratio, max_age, policy) {
         add_operation(M3FS::OPEN_PRIV, &M3FSRequestHandler::open_private_file);
         add_operation(M3FS::CLOSE_PRIV, &M3FSRequestHandler::close_private_file);
         add_operation(M3FS::NEXT_IN, &M3FSRequestHandler::next_in);
@@ -195,7 +198,9 @@ private:
 NORETURN static void usage(const char *name) {
     cerr << "Usage: " << name
          << " [-n <name>] [-s <sel>] [-e <blocks>] [-c] [-r] [-b <blocks>]\n"
-         << " [-o <offset>] (disk <dev>|mem <fssize>)\n";
+         << " [-o <offset>] [-p <blocks>] [-d <entries>] [-w <percent>] [-a <requests>]\n"
+         << " [-l <policy>]"
+         << " (disk <dev>|mem <fssize>)\n";
     cerr << "  -n: the name of the service (m3fs by default)\n";
     cerr << "  -s: don't create service, use selectors <sel>..<sel+1>\n";
     cerr << "  -e: the number of blocks to extend files when appending\n";
@@ -203,6 +208,11 @@ NORETURN static void usage(const char *name) {
     cerr << "  -r: revoke first, reply afterwards\n";
     cerr << "  -b: the maximum number of blocks loaded from the disk\n";
     cerr << "  -o: the file system offset in DRAM\n";
+    cerr << "  -p: the maximum number of blocks to read ahead (0 = disabled)\n";
+    cerr << "  -d: the number of entries in the path lookup cache (0 = disabled)\n";
+    cerr << "  -w: write back in the background above <percent> dirty blocks (0 = disabled)\n";
+    cerr << "  -a: write back blocks that are dirty for <requests> requests (0 = disabled)\n";
+    cerr << "  -l: the replacement policy of the buffers (lru or 2q; lru by default)\n";
     exit(1);
 }
 
@@ -210,6 +220,11 @@ int main(int argc, char *argv[]) {
     const char *name  = "m3fs";
     size_t extend     = 128;
     size_t max_load   = 128;
+    size_t max_prefetch = 256;
+    size_t dentries   = 256;
+    uint dirty_ratio  = 20;
+    size_t max_age    = 1000;
+    const char *policy = "lru";
     bool clear        = false;
     bool revoke_first = false;
     capsel_t sels     = ObjCap::INVALID;
@@ -217,7 +232,7 @@ int main(int argc, char *argv[]) {
     goff_t fs_offset  = FS_IMG_OFFSET;
 
     int opt;
-    while((opt = CmdArgs::get(argc, argv, "n:s:e:crb:o:")) != -1) {
+    while((opt = CmdArgs::get(argc, argv, "n:s:e:crb:o:p:d:w:a:l:")) != -1) {
         switch(opt) {
             case 'n': name = CmdArgs::arg; break;
             case 's': {
@@ -231,10 +246,15 @@ int main(int argc, char *argv[]) {
             case 'r': revoke_first = true; break;
             case 'b': max_load = IStringStream::read_from<size_t>(CmdArgs::arg); break;
             case 'o': fs_offset = IStringStream::read_from<goff_t>(CmdArgs::arg); break;
+            case 'p': max_prefetch = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'd': dentries = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'w': dirty_ratio = IStringStream::read_from<uint>(CmdArgs::arg); break;
+            case 'a': max_age = IStringStream::read_from<size_t>(CmdArgs::arg); break;
+            case 'l': policy = CmdArgs::arg; break;
             default: usage(argv[0]);
         }
     }
-    if(CmdArgs::ind + 1 >= argc)
+    if(CmdArgs::ind + 1 >= argc || !Policy::exists(policy))
         usage(argv[0]);
 
     // create backend
@@ -251,7 +271,8 @@ int main(int argc, char *argv[]) {
     else
         usage(argv[0]);
 
-    auto hdl    = new M3FSRequestHandler(backend, extend, clear, revoke_first, max_load);
+    auto hdl    = new M3FSRequestHandler(backend, extend, clear, revoke_first, max_load, max_prefetch,
+                                         dentries, dirty_ratio, max_age, policy);
     if(sels != ObjCap::INVALID)
         srv = new Server<M3FSRequestHandler>(sels, ep, hdl);
     else
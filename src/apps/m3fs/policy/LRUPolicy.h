@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include "Policy.h"
+#include "../Buffer.h"
+
+/**
+ * Evicts the least recently used head first.
+ */
+class LRUPolicy : public Policy {
+public:
+    explicit LRUPolicy()
+        : _lru() {
+    }
+
+    const char *name() const override {
+        return "lru";
+    }
+
+    void insert(BufferHead *b) override {
+        _lru.append(b);
+    }
+    void access(BufferHead *b) override {
+        _lru.moveToEnd(b);
+    }
+    void remove(BufferHead *b) override {
+        _lru.remove(b);
+    }
+    void pin(BufferHead *b) override {
+        _lru.remove(b);
+    }
+    void unpin(BufferHead *b) override {
+        _lru.append(b);
+    }
+
+protected:
+    size_t lists() const override {
+        return 1;
+    }
+    m3::DList<BufferHead> &list(size_t) override {
+        return _lru;
+    }
+
+private:
+    m3::DList<BufferHead> _lru;
+};
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#include <base/util/String.h>
+
+#include "LRUPolicy.h"
+#include "Policy.h"
+#include "TwoQPolicy.h"
+
+Policy *Policy::create(const char *name, size_t capacity) {
+    if(strcmp(name, "lru") == 0)
+        return new LRUPolicy();
+    if(strcmp(name, "2q") == 0)
+        return new TwoQPolicy(capacity);
+    return nullptr;
+}
+
+bool Policy::exists(const char *name) {
+    return strcmp(name, "lru") == 0 || strcmp(name, "2q") == 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include <base/col/DList.h>
+
+class BufferHead;
+
+/**
+ * The replacement policy of a buffer, which decides in which order the heads are evicted. The
+ * buffer informs the policy about loaded, accessed and evicted heads and iterates over the heads in
+ * the order in which they should be evicted.
+ */
+class Policy {
+public:
+    class iterator {
+        friend class Policy;
+
+        explicit iterator(Policy *policy, size_t list)
+            : _policy(policy),
+              _list(list),
+              _it() {
+            if(_list < _policy->lists()) {
+                _it = _policy->list(_list).begin();
+                skip();
+            }
+        }
+
+    public:
+        BufferHead &operator*() const {
+            return *_it;
+        }
+        BufferHead *operator->() const {
+            return &*_it;
+        }
+        iterator &operator++() {
+            ++_it;
+            skip();
+            return *this;
+        }
+        bool operator!=(const iterator &rhs) const {
+            return _list != rhs._list || _it != rhs._it;
+        }
+
+    private:
+        void skip() {
+            while(true) {
+                if(_it == _policy->list(_list).end()) {
+                    if(++_list == _policy->lists()) {
+                        _it = m3::DList<BufferHead>::iterator();
+                        break;
+                    }
+                    _it = _policy->list(_list).begin();
+                }
+                else if(_policy->pinned(*_it))
+                    ++_it;
+                else
+                    break;
+            }
+        }
+
+        Policy *_policy;
+        size_t _list;
+        m3::DList<BufferHead>::iterator _it;
+    };
+
+    /**
+     * Creates the policy with given name for a buffer of <capacity> blocks.
+     *
+     * @return the policy or nullptr if there is no policy with that name
+     */
+    static Policy *create(const char *name, size_t capacity);
+
+    /**
+     * @return true if there is a policy with given name
+     */
+    static bool exists(const char *name);
+
+    virtual ~Policy() {
+    }
+
+    /**
+     * @return the name of the policy, as given to create()
+     */
+    virtual const char *name() const = 0;
+    /**
+     * @return the number of loaded heads that were recognized as evicted shortly before (only
+     *         tracked by policies that remember evicted heads)
+     */
+    virtual size_t ghost_hits() const {
+        return 0;
+    }
+
+    /**
+     * @return the heads in the order in which they should be evicted
+     */
+    iterator begin() {
+        return iterator(this, 0);
+    }
+    iterator end() {
+        return iterator(this, lists());
+    }
+
+    /**
+     * Adds <b>, which has just been loaded
+     */
+    virtual void insert(BufferHead *b) = 0;
+    /**
+     * Notifies the policy that <b> has been accessed
+     */
+    virtual void access(BufferHead *b) = 0;
+    /**
+     * Removes <b>, because it is evicted
+     */
+    virtual void remove(BufferHead *b) = 0;
+    /**
+     * Takes <b> out of the eviction order while it is in use
+     */
+    virtual void pin(BufferHead *b) = 0;
+    /**
+     * Puts <b> back into the eviction order after it has been in use
+     */
+    virtual void unpin(BufferHead *b) = 0;
+
+protected:
+    virtual size_t lists() const = 0;
+    virtual m3::DList<BufferHead> &list(size_t i) = 0;
+    /**
+     * @return true if <b> is pinned, but kept in its list to keep its position
+     */
+    virtual bool pinned(const BufferHead &) const {
+        return false;
+    }
+};
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+
+#pragma once
+
+#include <base/util/Math.h>
+
+#include "Policy.h"
+#include "../Buffer.h"
+
+/**
+ * The 2Q policy (Johnson and Shasha, VLDB '94), which protects the frequently used heads against
+ * sequential scans. Loaded heads are put into the FIFO queue A1in first. Heads that are accessed
+ * again after they have been evicted from A1in, which is detected by remembering them in A1out, are
+ * put into the LRU list Am. Heads from A1in are evicted first as long as it holds more than a
+ * quarter of the blocks. A1out is a ring of the most recently evicted heads, which is indexed by
+ * a hash table over their first block.
+ */
+class TwoQPolicy : public Policy {
+    static constexpr size_t MAX_GHOSTS  = 256;
+    // a power of two
+    static constexpr size_t BUCKETS     = MAX_GHOSTS * 2;
+    static constexpr size_t NO_GHOST    = static_cast<size_t>(-1);
+
+    enum {
+        A1IN,
+        // in A1in, but in use. it keeps its position, because A1in is a FIFO queue
+        A1IN_PINNED,
+        AM,
+    };
+
+    struct Ghost {
+        m3::blockno_t start;
+        size_t count;
+        // the next ghost in the same bucket
+        size_t next;
+    };
+
+public:
+    explicit TwoQPolicy(size_t capacity)
+        : _in(),
+          _am(),
+          _in_max(capacity / 4),
+          _in_size(),
+          _ghost_max(m3::Math::max<size_t>(1, m3::Math::min(capacity / 2, MAX_GHOSTS))),
+          _ghost_next(),
+          _ghosts(new Ghost[_ghost_max]()),
+          _buckets(),
+          _ghost_hits() {
+        for(size_t i = 0; i < BUCKETS; ++i)
+            _buckets[i] = NO_GHOST;
+    }
+    ~TwoQPolicy() {
+        delete[] _ghosts;
+    }
+
+    const char *name() const override {
+        return "2q";
+    }
+    size_t ghost_hits() const override {
+        return _ghost_hits;
+    }
+
+    void insert(BufferHead *b) override {
+        if(b->key() != 0 && forget(b->key())) {
+            _ghost_hits++;
+            b->queue = AM;
+            _am.append(b);
+        }
+        else {
+            b->queue = A1IN;
+            _in.append(b);
+            _in_size += b->_size;
+        }
+    }
+    void access(BufferHead *b) override {
+        // accesses shortly after loading don't count (they are often caused by the same operation)
+        if(b->queue == AM)
+            _am.moveToEnd(b);
+    }
+    void remove(BufferHead *b) override {
+        if(b->queue == AM)
+            _am.remove(b);
+        else {
+            _in.remove(b);
+            _in_size -= b->_size;
+            if(b->key() != 0)
+                remember(b->key(), b->_size);
+        }
+    }
+    void pin(BufferHead *b) override {
+        // heads in A1in stay in place (and count for A1in), but are skipped meanwhile
+        if(b->queue == AM)
+            _am.remove(b);
+        else
+            b->queue = A1IN_PINNED;
+    }
+    void unpin(BufferHead *b) override {
+        // Am is an LRU list, so that the head is the most recently used one afterwards
+        if(b->queue == AM)
+            _am.append(b);
+        else
+            b->queue = A1IN;
+    }
+
+protected:
+    size_t lists() const override {
+        return 2;
+    }
+    m3::DList<BufferHead> &list(size_t i) override {
+        bool in_first = _in_size > _in_max || _am.length() == 0;
+        return (i == 0) == in_first ? _in : _am;
+    }
+    bool pinned(const BufferHead &b) const override {
+        return b.queue == A1IN_PINNED;
+    }
+
+private:
+    size_t &bucket(m3::blockno_t start) {
+        return _buckets[start & (BUCKETS - 1)];
+    }
+    void unlink(size_t idx) {
+        size_t *prev = &bucket(_ghosts[idx].start);
+        while(*prev != idx)
+            prev = &_ghosts[*prev].next;
+        *prev = _ghosts[idx].next;
+        _ghosts[idx].count = 0;
+    }
+
+    void remember(m3::blockno_t start, size_t count) {
+        // replace the oldest ghost
+        size_t idx = _ghost_next;
+        if(_ghosts[idx].count > 0)
+            unlink(idx);
+        _ghosts[idx].start = start;
+        _ghosts[idx].count = count;
+        _ghosts[idx].next = bucket(start);
+        bucket(start) = idx;
+        _ghost_next = (_ghost_next + 1) % _ghost_max;
+    }
+    bool forget(m3::blockno_t start) {
+        // heads are usually loaded again at the same block, so that we only look for that one
+        for(size_t idx = bucket(start); idx != NO_GHOST; idx = _ghosts[idx].next) {
+            if(_ghosts[idx].start == start) {
+                unlink(idx);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    m3::DList<BufferHead> _in;
+    m3::DList<BufferHead> _am;
+    size_t _in_max;
+    size_t _in_size;
+    size_t _ghost_max;
+    size_t _ghost_next;
+    Ghost *_ghosts;
+    size_t _buckets[BUCKETS];
+    size_t _ghost_hits;
+};
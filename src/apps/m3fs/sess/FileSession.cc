@@ -40,6 +40,10 @@ M3FSFileSession::M3FSFileSession(FSHandle &handle, capsel_t srv_sel, M3FSMetaSes
       _lastbytes(),
       _accessed(),
       _moved_forward(false),
+      _ra_next(),
+      _ra_blocks(),
+      _ra_ranges(),
+      _ra_count(),
       _appending(),
       _append_ext(),
       _last(ObjCap::INVALID),
@@ -64,11 +68,12 @@ M3FSFileSession::~M3FSFileSession() {
     delete _sgate;
 
     if(_append_ext) {
+        hdl().filebuffer().discard(_append_ext->start, _append_ext->length);
         hdl().blocks().free(r, _append_ext->start, _append_ext->length);
         delete _append_ext;
     }
 
-    hdl().files().rem_sess(this);
+    hdl().files().rem_sess(r, this);
     _meta->remove_file(this);
 
     if(_last != ObjCap::INVALID)
@@ -137,6 +142,7 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
                               << "file[path=" << _filename << ", fileoff=" << _fileoff << ", ext=" << _extent
                               << ", extoff=" << _extoff << "]");
 
+    _ra_count = 0;
     if((out && !(_oflags & FILE_W)) || (!out && !(_oflags & FILE_R))) {
         reply_error(is, Errors::NO_PERM);
         return;
@@ -162,6 +168,7 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
     capsel_t sel = VPE::self().alloc_sel();
     size_t len;
     size_t extlen = 0;
+    bool sequential = _fileoff == _ra_next;
 
     // do we need to append to the file?
     if(out && _fileoff == inode->size) {
@@ -228,6 +235,7 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
             _moved_forward = false;
         }
         _fileoff += len - capoff;
+        _ra_next = _fileoff;
     }
     else {
         capoff = _lastoff = 0;
@@ -252,10 +260,62 @@ void M3FSFileSession::next_in_out(GateIStream &is, bool out) {
             VPE::self().revoke(KIF::CapRngDesc(KIF::CapRngDesc::OBJ, _last, 1));
         _last = sel;
     }
+
+    if(!out && len > 0)
+        plan_readahead(r, inode, sequential, len);
+}
+
+void M3FSFileSession::plan_readahead(Request &r, INode *inode, bool sequential, size_t len) {
+    size_t max = hdl().filebuffer().max_prefetch();
+    if(!sequential || max == 0) {
+        _ra_blocks = 0;
+        return;
+    }
+
+    // start with the amount the client has just received and double it for every sequential read
+    uint32_t blocksize = hdl().sb().blocksize;
+    if(_ra_blocks == 0)
+        _ra_blocks = Math::min(max, (len + blocksize - 1) / blocksize);
+    else
+        _ra_blocks = Math::min(max, _ra_blocks * 2);
+
+    // collect the blocks of the next few extents now, because prefetching blocks this thread and
+    // the extents might change meanwhile
+    size_t blocks = _ra_blocks;
+    size_t off = _extoff / blocksize;
+    size_t org_used = r.used_meta();
+    for(size_t i = _extent; _ra_count < ARRAY_SIZE(_ra_ranges) && blocks > 0 &&
+                            i < inode->extents; ++i) {
+        Extent *indir = nullptr;
+        Extent *ext = INodes::get_extent(r, inode, i, &indir, false);
+        if(ext == nullptr || ext->length <= off)
+            break;
+        _ra_ranges[_ra_count].start = ext->start + off;
+        _ra_ranges[_ra_count].count = Math::min(blocks, ext->length - off);
+        blocks -= _ra_ranges[_ra_count++].count;
+        off = 0;
+    }
+    r.pop_meta(r.used_meta() - org_used);
+}
+
+void M3FSFileSession::readahead() {
+    // the next request of the client might plan the next read-ahead while we prefetch
+    Range ranges[ARRAY_SIZE(_ra_ranges)];
+    size_t num = _ra_count;
+    for(size_t i = 0; i < num; ++i)
+        ranges[i] = _ra_ranges[i];
+    _ra_count = 0;
+
+    Backend *backend = hdl().backend();
+    for(size_t i = 0; i < num; ++i)
+        backend->prefetch_data(hdl(), ranges[i].start, ranges[i].count);
 }
 
 void M3FSFileSession::next_in(GateIStream &is) {
     next_in_out(is, false);
+    // the client is busy with the data now, so that we can load the following blocks meanwhile.
+    // the request is done at this point to not hold back commits of the metadata (see MetaBuffer)
+    readahead();
 }
 
 void M3FSFileSession::next_out(GateIStream &is) {
@@ -357,9 +417,11 @@ Errors::Code M3FSFileSession::commit(Request &r, INode *inode, size_t submit) {
         if(res != Errors::NONE)
             return res;
 
-        // free superfluous blocks
-        if(old_len > blocks)
+        // free superfluous blocks; the client did not write them, so don't write them back
+        if(old_len > blocks) {
+            r.hdl().filebuffer().discard(_append_ext->start + blocks, old_len - blocks);
             r.hdl().blocks().free(r, _append_ext->start + blocks, old_len - blocks);
+        }
 
         _extlen = blocks * blocksize;
         // have we appended the new extent to the previous extent?
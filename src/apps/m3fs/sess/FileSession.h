@@ -90,7 +90,14 @@ public:
     m3::Errors::Code get_mem(m3::KIF::Service::ExchangeData &data);
 
 private:
+    struct Range {
+        m3::blockno_t start;
+        size_t count;
+    };
+
     void next_in_out(m3::GateIStream &is, bool out);
+    void plan_readahead(Request &r, m3::INode *inode, bool sequential, size_t len);
+    void readahead();
     m3::Errors::Code commit(Request &r, m3::INode *inode, size_t submit);
 
     size_t _extent;
@@ -102,6 +109,13 @@ private:
     size_t _accessed;
     bool _moved_forward;
 
+    // the file offset at which a sequential read continues and the current read-ahead window
+    size_t _ra_next;
+    size_t _ra_blocks;
+    // the blocks to prefetch after the current request
+    Range _ra_ranges[4];
+    size_t _ra_count;
+
     bool _appending;
     m3::Extent *_append_ext;
 
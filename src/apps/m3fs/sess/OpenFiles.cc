@@ -18,8 +18,7 @@
 
 #include "../data/INodes.h"
 
-void OpenFiles::delete_file(m3::inodeno_t ino) {
-    Request r(_hdl);
+void OpenFiles::delete_file(Request &r, m3::inodeno_t ino) {
     OpenFile *file = get_file(ino);
     if(file)
         file->deleted = true;
@@ -37,7 +36,7 @@ void OpenFiles::add_sess(M3FSFileSession *sess) {
     file->sessions.append(sess);
 }
 
-void OpenFiles::rem_sess(M3FSFileSession *sess) {
+void OpenFiles::rem_sess(Request &r, M3FSFileSession *sess) {
     OpenFile *file = get_file(sess->ino());
     assert(file != nullptr);
 
@@ -45,10 +44,8 @@ void OpenFiles::rem_sess(M3FSFileSession *sess) {
 
     if(file->sessions.length() == 0) {
         _files.remove(file);
-        if(file->deleted) {
-            Request r(_hdl);
+        if(file->deleted)
             INodes::free(r, sess->ino());
-        }
         delete file;
     }
 }
@@ -48,10 +48,10 @@ public:
         return _files.find(ino);
     }
 
-    void delete_file(m3::inodeno_t ino);
+    void delete_file(Request &r, m3::inodeno_t ino);
 
     void add_sess(M3FSFileSession *sess);
-    void rem_sess(M3FSFileSession *sess);
+    void rem_sess(Request &r, M3FSFileSession *sess);
 
 private:
     FSHandle &_hdl;
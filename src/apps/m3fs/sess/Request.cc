@@ -18,9 +18,17 @@
 #include "../FSHandle.h"
 #include "Request.h"
 
+Request::Request(FSHandle &handle)
+    : _handle(handle),
+      _used(0) {
+    _handle.metabuffer().enter();
+}
+
 Request::~Request() {
     for(size_t i = 0; i < _used; i++)
         _handle.metabuffer().quit(_blocks[i]);
+    _handle.metabuffer().leave();
+    _handle.flusher().request_done();
 }
 
 void Request::push_meta(MetaBufferHead *b) {
@@ -24,10 +24,7 @@ class Request {
     static constexpr size_t MAX_USED_BLOCKS = 16;
 
 public:
-    explicit Request(FSHandle &handle)
-        : _handle(handle),
-          _used(0) {
-    }
+    explicit Request(FSHandle &handle);
     ~Request();
 
     FSHandle &hdl() {
@@ -165,6 +165,35 @@ static void mem_sync() {
     }
 }
 
+static void mem_async() {
+    static xfer_t data[4];
+
+    MemGate mem = m3::MemGate::create_global(0x4000, m3::MemGate::RWX);
+    MemGate gate = MemGate::bind(mem.sel());
+    write_vmsg(gate, 0, 1, 2, 3, 4);
+
+    cout << "-- Test read async --\n";
+    {
+        MemGate::Ticket ticket;
+        assert_int(gate.read_async(data, sizeof(data), 0, ticket), Errors::NONE);
+        assert_int(MemGate::wait(ticket), Errors::NONE);
+        assert_xfer(data[0], 1);
+        assert_xfer(data[3], 4);
+    }
+
+    cout << "-- Test read async errors --\n";
+    {
+        MemGate::Ticket tickets[3];
+        MemGate wronly = gate.derive(0, sizeof(data), MemGate::W);
+        gate.read_async(data, sizeof(data), 0, tickets[0]);
+        // not permitted and out of bounds
+        wronly.read_async(data, sizeof(data), 0, tickets[1]);
+        gate.read_async(data, sizeof(data), 0x4000 - sizeof(xfer_t), tickets[2]);
+        assert_int(MemGate::wait(tickets[1]), Errors::INV_ARGS);
+        assert_int(MemGate::wait_all(tickets, ARRAY_SIZE(tickets)), Errors::INV_ARGS);
+    }
+}
+
 static void mem_derive() {
     static xfer_t test[6] = {0};
 
@@ -208,6 +237,7 @@ void tdtu() {
     RUN_TEST(cmds_read);
     RUN_TEST(cmds_write);
     RUN_TEST(mem_sync);
+    RUN_TEST(mem_async);
     RUN_TEST(mem_derive);
 }
 
@@ -371,6 +371,51 @@ static void write_file_and_read_again() {
     file->write(content, contentsz);
 }
 
+static void write_middle_block_and_read_again() {
+    const char *filename = "/middle.bin";
+    const size_t BLOCK_SIZE = 4096;
+    alignas(DTU_PKG_SIZE) static uint8_t buf[BLOCK_SIZE];
+
+    {
+        FileRef file(filename, FILE_W | FILE_CREATE);
+        if(Errors::occurred())
+            exitmsg("open of " << filename << " failed");
+
+        for(size_t i = 0; i < 3; ++i) {
+            memset(buf, 'a' + static_cast<int>(i), sizeof(buf));
+            assert_int(file->write_all(buf, sizeof(buf)), Errors::NONE);
+        }
+    }
+
+    // only the middle block of the chunk is dirty afterwards, so that it is written back separately
+    {
+        FileRef file(filename, FILE_W);
+        if(Errors::occurred())
+            exitmsg("open of " << filename << " failed");
+
+        assert_ssize(file->seek(BLOCK_SIZE, M3FS_SEEK_SET), static_cast<ssize_t>(BLOCK_SIZE));
+        memset(buf, 'x', sizeof(buf));
+        assert_int(file->write_all(buf, sizeof(buf)), Errors::NONE);
+        assert_ssize(file->flush(), Errors::NONE);
+    }
+
+    {
+        FileRef file(filename, FILE_R);
+        if(Errors::occurred())
+            exitmsg("open of " << filename << " failed");
+
+        const uint8_t exp[] = {'a', 'x', 'c'};
+        for(size_t i = 0; i < 3; ++i) {
+            assert_ssize(file->read(buf, sizeof(buf)), static_cast<ssize_t>(sizeof(buf)));
+            for(size_t j = 0; j < sizeof(buf); ++j)
+                assert_int(buf[j], exp[i]);
+        }
+        assert_ssize(file->read(buf, sizeof(buf)), 0);
+    }
+
+    assert_int(VFS::unlink(filename), Errors::NONE);
+}
+
 static void transactions() {
     char content1[] = "Text1";
     char content2[] = "Text2";
@@ -569,6 +614,7 @@ void tfs() {
     RUN_TEST(read_file_in_64b_steps);
     RUN_TEST(read_file_in_large_steps);
     RUN_TEST(write_file_and_read_again);
+    RUN_TEST(write_middle_block_and_read_again);
     RUN_TEST(transactions);
     RUN_TEST(buffered_read_until_end);
     RUN_TEST(buffered_read_with_seek);
@@ -257,6 +257,33 @@ static void reallocate() {
     check_heap_after();
 }
 
+static void reallocate_in_place() {
+    HeapStats before, after;
+    check_heap_before();
+    Heap::stats(&before);
+
+    uint *ptr = static_cast<uint*>(Heap::alloc(100 * sizeof(uint)));
+    for(size_t i = 0; i < 100; i++)
+        ptr[i] = 1;
+
+    // shrinking gives the rest back, which we can use to grow again afterwards
+    assert_true(Heap::realloc(ptr, 10 * sizeof(uint)) == ptr);
+    assert_true(Heap::realloc(ptr, 100 * sizeof(uint)) == ptr);
+    assert_true(test_check_content(ptr, 10, 1));
+
+    Heap::stats(&after);
+    assert_size(after.allocs, before.allocs + 1);
+    assert_size(after.grown, before.grown + 1);
+
+    Heap::free(ptr);
+
+    Heap::stats(&after);
+    assert_size(after.frees, before.frees + 1);
+    assert_size(after.used, before.used);
+
+    check_heap_after();
+}
+
 static void allocate_all_and_free_it_again() {
     check_heap_before();
 
@@ -299,5 +326,6 @@ void theap() {
     RUN_TEST(allocate_single_bytes);
     RUN_TEST(allocate_3_region);
     RUN_TEST(reallocate);
+    RUN_TEST(reallocate_in_place);
     RUN_TEST(allocate_all_and_free_it_again);
 }
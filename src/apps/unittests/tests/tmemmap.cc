@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#if defined(__host__)
+
+#include <base/Common.h>
+#include <base/util/Profile.h>
+
+#include <m3/stream/Standard.h>
+
+#include <cstdlib>
+
+#include "mem/MemoryMap.h"
+#include "../unittests.h"
+
+using namespace m3;
+
+static const goff_t BASE            = 0x100000;
+static const size_t SIZE            = 64 * 1024 * 1024;
+static const size_t MAX_ALLOCS      = 256;
+
+struct Alloc {
+    goff_t addr;
+    size_t size;
+};
+
+static Alloc allocs[MAX_ALLOCS];
+
+static void basics() {
+    kernel::MemoryMap map(BASE, SIZE);
+
+    goff_t a = map.allocate(0x1000, 1);
+    goff_t b = map.allocate(0x3000, 0x4000);
+    goff_t c = map.allocate(0x1000, 1);
+    assert_word(a, BASE);
+    assert_word(b, BASE + 0x4000);
+    // the gap in front of b is used first
+    assert_word(c, BASE + 0x1000);
+    assert_word(map.allocate(SIZE, 1), static_cast<goff_t>(-1));
+
+    size_t areas;
+    assert_size(map.get_size(&areas), SIZE - 0x5000);
+    assert_size(areas, 2);
+
+    // merge with prev, with next and with both
+    map.free(c, 0x1000);
+    map.free(b, 0x3000);
+    assert_size(map.get_size(&areas), SIZE - 0x1000);
+    assert_size(areas, 2);
+    map.free(a, 0x1000);
+    assert_size(map.get_size(&areas), SIZE);
+    assert_size(areas, 1);
+    assert_size(map.largest(), SIZE);
+    assert_uint(map.fragmentation(), 0);
+}
+
+static bool overlaps(size_t count, goff_t addr, size_t size) {
+    for(size_t i = 0; i < count; ++i) {
+        if(addr < allocs[i].addr + allocs[i].size && allocs[i].addr < addr + size)
+            return true;
+    }
+    return false;
+}
+
+static void fuzz() {
+    kernel::MemoryMap map(BASE, SIZE);
+    srand(0x1234);
+
+    size_t count = 0, used = 0, errors = 0;
+    for(int i = 0; i < 20000; ++i) {
+        if(count < MAX_ALLOCS && (count == 0 || (rand() % 3) != 0)) {
+            size_t size = (1 + static_cast<size_t>(rand()) % 256) * 0x1000;
+            size_t align = static_cast<size_t>(1) << (static_cast<size_t>(rand()) % 20);
+            goff_t addr = map.allocate(size, align);
+            if(addr == static_cast<goff_t>(-1))
+                continue;
+
+            // it has to be aligned, within the map and not overlap with others
+            if((addr & (align - 1)) != 0 || addr < BASE || addr + size > BASE + SIZE ||
+                overlaps(count, addr, size))
+                errors++;
+            allocs[count].addr = addr;
+            allocs[count].size = size;
+            count++;
+            used += size;
+        }
+        else {
+            size_t idx = static_cast<size_t>(rand()) % count;
+            map.free(allocs[idx].addr, allocs[idx].size);
+            used -= allocs[idx].size;
+            allocs[idx] = allocs[--count];
+        }
+
+        if(map.get_size() != SIZE - used)
+            errors++;
+    }
+    assert_size(errors, 0);
+
+    while(count > 0) {
+        count--;
+        map.free(allocs[count].addr, allocs[count].size);
+    }
+
+    size_t areas;
+    assert_size(map.get_size(&areas), SIZE);
+    assert_size(areas, 1);
+}
+
+static void bench() {
+    struct MapRunner : public Runner {
+        explicit MapRunner() : map(BASE, SIZE) {
+        }
+
+        void run() override {
+            // allocate with different sizes and free every second one to fragment the map
+            for(size_t i = 0; i < MAX_ALLOCS; ++i) {
+                allocs[i].size = ((i * 7) % 64 + 1) * 0x1000;
+                allocs[i].addr = map.allocate(allocs[i].size, 0x1000);
+            }
+            for(size_t i = 0; i < MAX_ALLOCS; i += 2)
+                map.free(allocs[i].addr, allocs[i].size);
+            for(size_t i = 1; i < MAX_ALLOCS; i += 2)
+                map.free(allocs[i].addr, allocs[i].size);
+        }
+
+        kernel::MemoryMap map;
+    };
+
+    Profile pr(20, 2);
+    MapRunner runner;
+    cout << "  " << MAX_ALLOCS << " allocs+frees: " << pr.runner_with_id(runner, 0x30) << "\n";
+}
+
+void tmemmap() {
+    RUN_TEST(basics);
+    RUN_TEST(fuzz);
+    RUN_TEST(bench);
+}
+
+#endif
@@ -35,6 +35,7 @@ int main() {
 
 #if defined(__host__)
     RUN_SUITE(tdtu);
+    RUN_SUITE(tmemmap);
 #endif
     RUN_SUITE(tfsmeta);
     RUN_SUITE(tfs);
@@ -33,6 +33,7 @@ static inline void check_equal(const T &expected, const T &actual, const char *f
 
 #if defined(__host__)
 void tdtu();
+void tmemmap();
 #endif
 void tfsmeta();
 void tfs();
@@ -16,6 +16,22 @@
 
 #pragma once
 
+#include <base/Common.h>
+
+namespace m3 {
+
+/**
+ * Describes one part of a vectored memory transfer: <len> bytes between the local buffer <data>
+ * and the remote memory at <offset>.
+ */
+struct IOVec {
+    void *data;
+    size_t len;
+    goff_t offset;
+};
+
+}
+
 #if defined(__host__)
 #   include <base/arch/host/DTU.h>
 #elif defined(__t2__)
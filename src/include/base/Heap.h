@@ -125,6 +125,15 @@ public:
         return heap_free_memory();
     }
 
+    /**
+     * Retrieves the allocation statistics of the heap.
+     *
+     * @param stats the statistics to fill
+     */
+    static void stats(HeapStats *stats) {
+        heap_stats(stats);
+    }
+
     /**
      * @return the end of the heap that is used.
      */
@@ -152,6 +161,13 @@ public:
      */
     static void print(OStream &os);
 
+    /**
+     * Prints the allocation statistics and the fragmentation of the heap
+     *
+     * @param os the OStream to print to
+     */
+    static void print_stats(OStream &os);
+
 private:
     static bool is_used(HeapArea *a) {
         return a->next & HEAP_USED_BITS;
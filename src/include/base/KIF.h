@@ -161,10 +161,14 @@ struct KIF {
 
             // misc
             NOOP,
+            BATCH,
 
             COUNT
         };
 
+        // the maximum number of system calls in a BATCH request
+        static const size_t MAX_BATCH   = 16;
+
         enum VPEOp {
             VCTRL_INIT,
             VCTRL_START,
@@ -346,6 +350,23 @@ struct KIF {
 
         struct Noop : public DefaultRequest {
         } PACKED;
+
+        struct Batch : public DefaultRequest {
+            enum Flags {
+                // execute the remaining calls if one fails
+                CONTINUE    = 1,
+            };
+
+            xfer_t flags;
+            xfer_t count;
+            // each call is stored as its size in bytes, followed by the request padded to xfer_t
+            xfer_t msgs[MAX_MSG_SIZE / sizeof(xfer_t)];
+        } PACKED;
+
+        struct BatchReply : public DefaultReply {
+            xfer_t count;
+            xfer_t errors[MAX_BATCH];
+        } PACKED;
     };
 
     /**
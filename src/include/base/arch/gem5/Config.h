@@ -43,6 +43,10 @@
 
 #define MAX_RB_SIZE         32
 
+// the number of syscall receive EPs in the kernel and the number of VPEs per EP
+#define KERNEL_SYSC_REPS    4
+#define KERNEL_SYSC_SLOTS   MAX_RB_SIZE
+
 #define RECVBUF_SPACE       0x3FC00000
 #define RECVBUF_SIZE        (4U * PAGE_SIZE)
 #define RECVBUF_SIZE_SPM    16384U
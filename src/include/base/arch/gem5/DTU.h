@@ -53,6 +53,9 @@ class DTU {
 public:
     typedef uint64_t reg_t;
 
+    // asynchronous reads are executed synchronously, so that they never occupy a command slot
+    static const size_t NO_SLOT             = static_cast<size_t>(-1);
+
 private:
     static const uintptr_t BASE_ADDR        = 0xF0000000;
     static const size_t DTU_REGS            = 10;
@@ -32,7 +32,12 @@
 #define RECVBUF_SIZE        16384U
 #define RECVBUF_SIZE_SPM    16384U
 
-#define MAX_RB_SIZE         32
+// the DTU keeps the slot bitmaps outside of the EP registers
+#define MAX_RB_SIZE         4096
+
+// the number of syscall receive EPs in the kernel and the number of VPEs per EP
+#define KERNEL_SYSC_REPS    8
+#define KERNEL_SYSC_SLOTS   128
 
 #define RCTMUX_ENTRY        0   // unused
 #define RCTMUX_YIELD        0   // unused
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <base/Common.h>
+#include <base/Config.h>
 #include <base/util/String.h>
 #include <base/util/Util.h>
 #include <base/Errors.h>
@@ -37,11 +38,13 @@ namespace m3 {
 
 class Gate;
 class DTUBackend;
+class SharedMemory;
 
 class DTU {
     friend class Gate;
     friend class MsgBackend;
     friend class SocketBackend;
+    friend class ShmBackend;
 
     static constexpr size_t MAX_DATA_SIZE   = HEAP_SIZE;
 public:
@@ -76,7 +79,7 @@ public:
     static constexpr size_t HEADER_SIZE         = sizeof(Buffer) - MAX_DATA_SIZE;
     static const size_t HEADER_COUNT            = std::numeric_limits<size_t>::max();
 
-    static constexpr size_t MAX_MSGS            = sizeof(word_t) * 8;
+    static constexpr size_t MAX_MSGS            = MAX_RB_SIZE;
 
     // command registers
     static constexpr size_t CMD_ADDR            = 0;
@@ -87,9 +90,11 @@ public:
     static constexpr size_t CMD_REPLYLBL        = 5;
     static constexpr size_t CMD_REPLY_EPID      = 6;
     static constexpr size_t CMD_LENGTH          = 7;
+    // the error code of the last command, if the message could not be delivered
+    static constexpr size_t CMD_ERROR           = 8;
 
     // register starts and counts (cont.)
-    static constexpr size_t CMDS_RCNT           = 1 + CMD_LENGTH;
+    static constexpr size_t CMDS_RCNT           = 1 + CMD_ERROR;
 
     // receive buffer registers
     static constexpr size_t EP_BUF_ADDR         = 0;
@@ -99,6 +104,7 @@ public:
     static constexpr size_t EP_BUF_WOFF         = 4;
     static constexpr size_t EP_BUF_MSGCNT       = 5;
     static constexpr size_t EP_BUF_MSGQID       = 6;
+    // unused; the bitmaps are kept in the DTU to support more than 64 slots
     static constexpr size_t EP_BUF_UNREAD       = 7;
     static constexpr size_t EP_BUF_OCCUPIED     = 8;
 
@@ -116,6 +122,10 @@ public:
 
     static constexpr size_t OPCODE_SHIFT        = 3;
 
+    // the number of command slots for asynchronous reads
+    static constexpr size_t CMD_SLOTS           = 16;
+    static constexpr size_t NO_SLOT             = static_cast<size_t>(-1);
+
     // register counts (cont.)
     static constexpr size_t EPS_RCNT            = 1 + EP_MSGORDER;
 
@@ -131,6 +141,9 @@ public:
         RESP                                    = 5,
         FETCHMSG                                = 6,
         ACKMSG                                  = 7,
+        // only used between CU and DTU; the DTU sends READ and WRITE messages for them
+        READV                                   = 8,
+        WRITEV                                  = 9,
     };
 
     static const epid_t SYSC_SEP                = 0;
@@ -193,19 +206,57 @@ public:
         return exec_command();
     }
     Errors::Code reply(epid_t ep, const void *msg, size_t size, size_t msgidx) {
+        // the DTU acks the message as part of the reply
         setup_command(ep, REPLY, msg, size, msgidx, 0, label_t(), 0);
-        Errors::Code res = exec_command();
-        mark_read(ep, msgidx);
-        return res;
+        return exec_command();
     }
     Errors::Code read(epid_t ep, void *msg, size_t size, size_t off, uint) {
+        if(access_mem(ep, READ, msg, size, off))
+            return Errors::NONE;
         setup_command(ep, READ, msg, size, off, size, label_t(), 0);
         return exec_command();
     }
     Errors::Code write(epid_t ep, const void *msg, size_t size, size_t off, uint) {
+        if(access_mem(ep, WRITE, const_cast<void*>(msg), size, off))
+            return Errors::NONE;
         setup_command(ep, WRITE, msg, size, off, size, label_t(), 0);
         return exec_command();
     }
+    Errors::Code readv(epid_t ep, const IOVec *vecs, size_t count, uint) {
+        if(access_memv(ep, READ, vecs, count))
+            return Errors::NONE;
+        setup_command(ep, READV, vecs, count, 0, 0, label_t(), 0);
+        return exec_command();
+    }
+    Errors::Code writev(epid_t ep, const IOVec *vecs, size_t count, uint) {
+        if(access_memv(ep, WRITE, vecs, count))
+            return Errors::NONE;
+        setup_command(ep, WRITEV, vecs, count, 0, 0, label_t(), 0);
+        return exec_command();
+    }
+
+    /**
+     * Starts a read without waiting for the data. The read is executed synchronously, if the
+     * memory can be accessed directly or if all command slots are in use.
+     *
+     * @param slot is set to the command slot that has to be passed to wait_for, or NO_SLOT if
+     *     the read is done
+     * @return the error of the synchronous read, if any
+     */
+    Errors::Code read_async(epid_t ep, void *msg, size_t size, size_t off, uint flags,
+                            size_t *slot);
+    /**
+     * @return true if the read in command slot <slot> is finished
+     */
+    bool is_done(size_t slot) const {
+        return __atomic_load_n(&_slots[slot], __ATOMIC_ACQUIRE) == SLOT_DONE;
+    }
+    /**
+     * Waits until the read in command slot <slot> is finished and frees the slot afterwards
+     *
+     * @return the error of the read, if it failed
+     */
+    Errors::Code wait_for(size_t slot);
 
     bool is_valid(epid_t) const {
         // TODO not supported
@@ -216,6 +267,19 @@ public:
         return false;
     }
 
+    /**
+     * @return the number of messages that have been dropped at <ep>, because no slot was free
+     */
+    word_t dropped_msgs(epid_t ep) const {
+        return _drops[ep];
+    }
+
+    /**
+     * Marks all slots of the receive buffer at <ep> as free. This is required whenever the
+     * registers of <ep> are changed without configure_recv.
+     */
+    void clear_slots(epid_t ep);
+
     Message *fetch_msg(epid_t ep) {
         if(get_ep(ep, EP_BUF_MSGCNT) == 0)
             return nullptr;
@@ -265,6 +329,32 @@ public:
     }
     void try_sleep(bool report = true, uint64_t cycles = 0) const;
 
+    /**
+     * @return the number of waits of the CU that have been finished by spinning (for benchmarking)
+     */
+    uint64_t spin_hits() const {
+        return _spin_hits;
+    }
+    /**
+     * @return the number of waits of the CU that went to sleep after spinning (for benchmarking)
+     */
+    uint64_t sleeps() const {
+        return _sleeps;
+    }
+
+    /**
+     * @return the number of times the DTU thread has been woken up (for benchmarking)
+     */
+    uint64_t wakeups() const {
+        return _wakeups;
+    }
+    /**
+     * @return the number of messages the DTU thread has received (for benchmarking)
+     */
+    uint64_t received_msgs() const {
+        return _recv_msgs;
+    }
+
     void drop_msgs(epid_t ep, label_t label) {
         // we assume that the one that used the label can no longer send messages. thus, if there are
         // no messages yet, we are done.
@@ -272,13 +362,12 @@ public:
             return;
 
         goff_t base = get_ep(ep, m3::DTU::EP_BUF_ADDR);
-        int order = static_cast<int>(get_ep(ep, m3::DTU::EP_BUF_ORDER));
-        int msgorder = static_cast<int>(get_ep(ep, m3::DTU::EP_BUF_MSGORDER));
-        word_t unread = get_ep(ep, m3::DTU::EP_BUF_UNREAD);
-        int max = 1 << (order - msgorder);
-        for(int i = 0; i < max; ++i) {
-            if(unread & (1UL << i)) {
-                Message *msg = reinterpret_cast<Message*>(base + (static_cast<size_t>(i) << msgorder));
+        size_t order = get_ep(ep, m3::DTU::EP_BUF_ORDER);
+        size_t msgorder = get_ep(ep, m3::DTU::EP_BUF_MSGORDER);
+        size_t max = 1UL << (order - msgorder);
+        for(size_t i = 0; i < max; ++i) {
+            if(is_unread(ep, i)) {
+                Message *msg = reinterpret_cast<Message*>(base + (i << msgorder));
                 if(msg->label == label)
                     mark_read(ep, reinterpret_cast<size_t>(msg));
             }
@@ -286,25 +375,51 @@ public:
     }
 
 private:
-    bool is_unread(word_t unread, size_t idx) const {
-        return unread & (static_cast<word_t>(1) << idx);
+    // the default for the maximum number of spin iterations, if M3_DTU_SPIN is not set
+    static constexpr uint64_t DEF_SPIN          = 1024;
+    // the adaptive spin budget is not reduced below that
+    static constexpr uint64_t MIN_SPIN          = 16;
+
+    enum SlotState {
+        SLOT_FREE,
+        SLOT_BUSY,
+        SLOT_DONE,
+    };
+
+    static bool get_bit(const volatile word_t *bitmap, size_t idx) {
+        return bitmap[idx / WORD_BITS] & (static_cast<word_t>(1) << (idx % WORD_BITS));
     }
-    void set_unread(word_t &unread, size_t idx, bool unr) {
-        if(unr)
-            unread |= static_cast<word_t>(1) << idx;
+    static void set_bit(volatile word_t *bitmap, size_t idx, bool val) {
+        if(val)
+            bitmap[idx / WORD_BITS] |= static_cast<word_t>(1) << (idx % WORD_BITS);
         else
-            unread &= ~(static_cast<word_t>(1) << idx);
+            bitmap[idx / WORD_BITS] &= ~(static_cast<word_t>(1) << (idx % WORD_BITS));
     }
+    static size_t find_bit(const volatile word_t *bitmap, size_t count, size_t start, bool val);
 
-    bool is_occupied(word_t occupied, size_t idx) const {
-        return occupied & (static_cast<word_t>(1) << idx);
+    bool is_unread(epid_t ep, size_t idx) const {
+        return get_bit(_unread[ep], idx);
     }
-    void set_occupied(word_t &occupied, size_t idx, bool occ) {
-        if(occ)
-            occupied |= static_cast<word_t>(1) << idx;
-        else
-            occupied &= ~(static_cast<word_t>(1) << idx);
+    void set_unread(epid_t ep, size_t idx, bool unr) {
+        set_bit(_unread[ep], idx, unr);
+    }
+
+    bool is_occupied(epid_t ep, size_t idx) const {
+        return get_bit(_occupied[ep], idx);
     }
+    void set_occupied(epid_t ep, size_t idx, bool occ) {
+        set_bit(_occupied[ep], idx, occ);
+    }
+
+    template<typename F>
+    bool spin(F done) const;
+    template<typename F>
+    void wait_resp(F done);
+    void notify_resp();
+
+    char *local_mem(epid_t ep, int op, size_t size, size_t off);
+    bool access_mem(epid_t ep, int op, void *data, size_t size, size_t off);
+    bool access_memv(epid_t ep, int op, const IOVec *vecs, size_t count);
 
     word_t prepare_reply(epid_t ep, peid_t &dstpe, epid_t &dstep);
     word_t prepare_send(epid_t ep, peid_t &dstpe, epid_t &dstep);
@@ -312,14 +427,17 @@ private:
     word_t prepare_write(epid_t ep, peid_t &dstpe, epid_t &dstep);
     word_t prepare_fetchmsg(epid_t ep);
     word_t prepare_ackmsg(epid_t ep);
+    word_t prepare_vec(peid_t pe, epid_t ep, int op, word_t ctrl);
+    void prepare_header(peid_t pe, epid_t ep, int op, word_t ctrl);
 
-    void send_msg(epid_t ep, peid_t dstpe, epid_t dstep, bool isreply);
+    Errors::Code send_msg(epid_t ep, peid_t dstpe, epid_t dstep, bool isreply);
     void handle_read_cmd(epid_t ep);
     void handle_write_cmd(epid_t ep);
     void handle_resp_cmd();
+    void finish_slot(label_t slot, Errors::Code res);
     void handle_command(peid_t pe);
     void handle_msg(size_t len, epid_t ep);
-    void handle_receive(epid_t ep);
+    bool handle_receive(epid_t ep);
 
     static word_t check_cmd(epid_t ep, int op, word_t addr, word_t credits, size_t offset, size_t length);
     static void *thread(void *arg);
@@ -328,7 +446,30 @@ private:
     volatile word_t _cmdregs[CMDS_RCNT];
     // have to be aligned by 8 because it shouldn't collide with MemGate::RWX bits
     alignas(8) volatile word_t _epregs[EPS_RCNT * EP_COUNT];
+    // the slot bitmaps of the receive buffers
+    static constexpr size_t WORD_BITS           = sizeof(word_t) * 8;
+    volatile word_t _unread[EP_COUNT][(MAX_MSGS + WORD_BITS - 1) / WORD_BITS];
+    volatile word_t _occupied[EP_COUNT][(MAX_MSGS + WORD_BITS - 1) / WORD_BITS];
+    volatile word_t _drops[EP_COUNT];
+    // the state of the command slots; set to busy by the CU and to done by the DTU thread
+    volatile word_t _slots[CMD_SLOTS];
+    // the result of the read in the command slots; written before the slot is set to done
+    Errors::Code _slot_errors[CMD_SLOTS];
+    // the number of responses the command register waits for
+    size_t _resps;
+    // the CU spins up to _spin_cur iterations before sleeping. the budget is doubled (up to
+    // _spin_max) if spinning succeeded and halved otherwise.
+    uint64_t _spin_max;
+    mutable uint64_t _spin_cur;
+    mutable uint64_t _spin_hits;
+    mutable uint64_t _sleeps;
+    // set while the CU sleeps for RESP; the DTU thread only notifies the CU in this case
+    volatile word_t _cu_sleeping;
+    volatile uint64_t _wakeups;
+    volatile uint64_t _recv_msgs;
     DTUBackend *_backend;
+    // the shared main memory, if available
+    SharedMemory *_mem;
     pthread_t _tid;
     static Buffer _buf;
     static DTU inst;
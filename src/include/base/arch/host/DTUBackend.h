@@ -16,14 +16,20 @@
 
 #pragma once
 
+#include <base/col/SList.h>
 #include <base/Config.h>
 #include <base/DTU.h>
 
 #include <sys/un.h>
-#include <poll.h>
 
 namespace m3 {
 
+class SharedMemory;
+
+/**
+ * The DTU backend transports messages and notifications between the DTU threads of all PEs and
+ * between the DTU thread and the CU thread of one PE.
+ */
 class DTUBackend {
 public:
     enum class Event {
@@ -32,31 +38,166 @@ public:
         MSG     = 2,
     };
 
-    explicit DTUBackend();
-    ~DTUBackend();
+    /**
+     * Creates the backend that has been selected via the environment variable M3_DTU_BACKEND
+     * ("socket" or "shm"). The default is the socket backend.
+     */
+    static DTUBackend *create_backend();
 
-    void create() {
+    virtual ~DTUBackend() {
     }
-    void destroy() {
+
+    virtual void create() {
+    }
+    virtual void destroy() {
     }
 
-    bool has_command();
-    epid_t has_msg();
+    /**
+     * Blocks the DTU thread until there is a command or message to handle, or until it is
+     * interrupted. Called once per wakeup; has_command and has_msg don't block.
+     */
+    virtual void wait_for_work() = 0;
+    /**
+     * Wakes up the DTU thread to let it stop. Afterwards, wait_for_work does not block anymore.
+     */
+    virtual void wakeup() = 0;
+    virtual bool has_command() = 0;
+    virtual epid_t has_msg() = 0;
 
-    void notify(Event ev);
-    bool wait(Event ev);
-    void send(peid_t pe, epid_t ep, const DTU::Buffer *buf);
-    ssize_t recv(epid_t ep, DTU::Buffer *buf);
+    virtual void notify(Event ev) = 0;
+    virtual bool wait(Event ev) = 0;
+    /**
+     * Sends the message in <buf> to <pe>:<ep>. The backend must not block until the receiver has
+     * made room, because the DTU thread of the receiver might wait for us at the same time.
+     *
+     * @return the error, if the message cannot be delivered
+     */
+    virtual Errors::Code send(peid_t pe, epid_t ep, const DTU::Buffer *buf) = 0;
+    virtual ssize_t recv(epid_t ep, DTU::Buffer *buf) = 0;
+};
 
-private:
-    void poll();
+/**
+ * Uses one abstract unix datagram socket per endpoint and PE. The DTU thread waits for all of its
+ * sockets at once via epoll and remembers the ready ones in a bitmap, so that all pending messages
+ * can be received with a single wakeup.
+ */
+class SocketBackend : public DTUBackend {
+public:
+    explicit SocketBackend();
+    ~SocketBackend();
+
+    void wait_for_work() override;
+    void wakeup() override;
+    bool has_command() override;
+    epid_t has_msg() override;
 
+    void notify(Event ev) override;
+    bool wait(Event ev) override;
+    Errors::Code send(peid_t pe, epid_t ep, const DTU::Buffer *buf) override;
+    ssize_t recv(epid_t ep, DTU::Buffer *buf) override;
+
+private:
     int _sock;
-    int _pending;
+    int _epfd;
+    // bit i is set if _localsocks[i] might have data (the endpoints and REQ)
+    word_t _ready;
+    // the endpoint to start the search for messages at (for fairness)
+    epid_t _next;
     // the last three are used for DTU-CU notifications
     int _localsocks[EP_COUNT + 3];
-    struct pollfd _fds[EP_COUNT + 1];
     sockaddr_un _endpoints[PE_COUNT * (EP_COUNT + 3)];
 };
 
+/**
+ * Uses a lock-free single-producer-single-consumer ring in shared memory for every pair of
+ * sending and receiving PE. Since only the DTU thread sends and receives messages, each ring has
+ * exactly one producer and one consumer. Waiting is done via futexes: one doorbell per PE in
+ * shared memory for the DTU thread and process-local event counters for the CU thread. Messages
+ * that don't fit into the ring of the receiver are kept locally until it has made room.
+ */
+class ShmBackend : public DTUBackend {
+public:
+    // has to be large enough for the largest message (e.g., read responses)
+    static const size_t RING_SIZE   = 256 * 1024;
+
+    struct Ring {
+        // the total number of bytes written (only modified by the producer)
+        alignas(64) uint64_t head;
+        // the total number of bytes read (only modified by the consumer)
+        alignas(64) uint64_t tail;
+        // set by the producer while messages wait for room; the consumer rings its doorbell then
+        alignas(64) uint32_t blocked;
+        alignas(64) char data[RING_SIZE];
+    };
+
+    struct Doorbell {
+        // incremented whenever something arrives for the DTU thread of this PE
+        alignas(64) uint32_t seq;
+        // the number of threads waiting for <seq> to change
+        uint32_t waiters;
+    };
+
+    struct Region {
+        Doorbell bells[PE_COUNT];
+        // indexed by [dstpe][srcpe]
+        Ring rings[PE_COUNT][PE_COUNT];
+    };
+
+    explicit ShmBackend();
+    ~ShmBackend();
+
+    void create() override;
+    void destroy() override;
+
+    void wait_for_work() override;
+    void wakeup() override;
+    bool has_command() override;
+    epid_t has_msg() override;
+
+    void notify(Event ev) override;
+    bool wait(Event ev) override;
+    Errors::Code send(peid_t pe, epid_t ep, const DTU::Buffer *buf) override;
+    ssize_t recv(epid_t ep, DTU::Buffer *buf) override;
+
+private:
+    struct RecordHeader {
+        uint32_t size;
+        uint32_t ep;
+    };
+
+    // a record that is waiting for room in the ring of the receiver. the record follows the struct
+    // in the same mapping (the heap can't be used by the DTU thread)
+    struct Pending : public SListItem {
+        size_t size;
+        size_t total;
+
+        char *record() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    void init_region(SharedMemory *shm);
+    Ring &ring(peid_t dst, peid_t src) {
+        return _region->rings[dst][src];
+    }
+    static size_t space(const Ring &r);
+    void ring_doorbell(peid_t pe);
+    void wait_doorbell();
+    void send_pending();
+    static void copy_in(Ring &r, uint64_t pos, const void *src, size_t len);
+    static void copy_out(const Ring &r, uint64_t pos, void *dst, size_t len);
+
+    SharedMemory *_shm;
+    Region *_region;
+    // the ring from which the next message is received
+    peid_t _cur;
+    // the PE to start the search for messages at (for fairness)
+    peid_t _next;
+    uint32_t _reqs;
+    bool _stop;
+    uint32_t _events[3];
+    SList<Pending> _pending[PE_COUNT];
+    size_t _pending_count;
+};
+
 }
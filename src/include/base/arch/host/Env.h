@@ -108,6 +108,20 @@ public:
         _sysc_credits = sysc_credits;
     }
 
+    /**
+     * The main memory is shared with all PEs. <base> is its address in the kernel's address space.
+     */
+    goff_t mem_base() const {
+        return _mem_base;
+    }
+    size_t mem_size() const {
+        return _mem_size;
+    }
+    void set_mem(goff_t base, size_t size) {
+        _mem_base = base;
+        _mem_size = size;
+    }
+
     void exit(int code) NORETURN {
         ::exit(code);
     }
@@ -131,6 +145,8 @@ private:
     label_t _sysc_label;
     epid_t _sysc_epid;
     word_t _sysc_credits;
+    goff_t _mem_base;
+    size_t _mem_size;
     pthread_mutex_t _log_mutex;
 
     static const char *_exec_short_ptr;
@@ -65,6 +65,8 @@ public:
 
     static const size_t HEADER_SIZE         = sizeof(Header);
     static const size_t PACKET_SIZE         = 8;
+    // asynchronous reads are executed synchronously, so that they never occupy a command slot
+    static const size_t NO_SLOT             = static_cast<size_t>(-1);
 
     static const epid_t SYSC_EP             = 0;
     static const epid_t DEF_RECVEP          = 1;
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <assert.h>
+
+namespace m3 {
+
+/**
+ * A two-level radix table that maps the keys 0 .. LIMIT-1 to pointers, similar to a page table.
+ * The directory and the leaves are allocated on demand. Thus, lookups need two memory accesses
+ * and ranges of consecutive keys are stored in contiguous memory.
+ */
+template<typename T, uint LEAF_BITS = 8, uint DIR_BITS = 8>
+class RadixTable {
+public:
+    typedef uint key_t;
+
+    static const size_t LEAF_SIZE   = 1UL << LEAF_BITS;
+    static const size_t DIR_SIZE    = 1UL << DIR_BITS;
+    static const key_t LIMIT        = static_cast<key_t>(LEAF_SIZE * DIR_SIZE);
+
+    explicit RadixTable()
+        : _dir() {
+    }
+    ~RadixTable() {
+        clear();
+    }
+
+    /**
+     * @return true if the given key can be stored in this table
+     */
+    static bool fits(key_t key) {
+        return key < LIMIT;
+    }
+
+    /**
+     * @param key the key
+     * @return the element for <key> or nullptr
+     */
+    T *find(key_t key) const {
+        if(!_dir || !fits(key))
+            return nullptr;
+        T **leaf = _dir[key >> LEAF_BITS];
+        return leaf ? leaf[key & (LEAF_SIZE - 1)] : nullptr;
+    }
+
+    /**
+     * @param start the first key
+     * @param count the number of keys (start + count has to be <= LIMIT)
+     * @return true if there is no element in the range start .. start+count-1
+     */
+    bool range_free(key_t start, key_t count) const {
+        return count_used(start, count) == 0;
+    }
+
+    /**
+     * @param start the first key
+     * @param count the number of keys (start + count has to be <= LIMIT)
+     * @return the number of elements in the range start .. start+count-1
+     */
+    size_t count_used(key_t start, key_t count) const {
+        assert(start + count <= LIMIT);
+        size_t used = 0;
+        for(key_t k = start, end = start + count; k < end; ) {
+            T **leaf = _dir ? _dir[k >> LEAF_BITS] : nullptr;
+            key_t leafend = (k | (LEAF_SIZE - 1)) + 1;
+            key_t last = leafend < end ? leafend : end;
+            if(leaf) {
+                for(; k < last; ++k)
+                    used += leaf[k & (LEAF_SIZE - 1)] != nullptr;
+            }
+            k = last;
+        }
+        return used;
+    }
+
+    /**
+     * Searches for the first element with a key >= <pos>, starting at <pos>. Empty leaves are
+     * skipped without looking at them.
+     *
+     * @param pos the key to start at; will be set to the key of the found element
+     * @return the element or nullptr
+     */
+    T *next(key_t &pos) const {
+        if(!_dir)
+            return nullptr;
+        for(size_t d = pos >> LEAF_BITS; d < DIR_SIZE; ++d) {
+            T **leaf = _dir[d];
+            if(leaf) {
+                size_t i = d == (pos >> LEAF_BITS) ? (pos & (LEAF_SIZE - 1)) : 0;
+                for(; i < LEAF_SIZE; ++i) {
+                    if(leaf[i]) {
+                        pos = static_cast<key_t>((d << LEAF_BITS) | i);
+                        return leaf[i];
+                    }
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Stores <elem> for <key>, which has to be free.
+     *
+     * @param key the key
+     * @param elem the element
+     */
+    void insert(key_t key, T *elem) {
+        assert(fits(key));
+        if(!_dir)
+            _dir = new T**[DIR_SIZE]();
+        T **&leaf = _dir[key >> LEAF_BITS];
+        if(!leaf)
+            leaf = new T*[LEAF_SIZE]();
+        assert(leaf[key & (LEAF_SIZE - 1)] == nullptr);
+        leaf[key & (LEAF_SIZE - 1)] = elem;
+    }
+
+    /**
+     * Removes the element for <key>, if any.
+     *
+     * @param key the key
+     * @return the removed element or nullptr
+     */
+    T *remove(key_t key) {
+        if(!_dir || !fits(key))
+            return nullptr;
+        T **leaf = _dir[key >> LEAF_BITS];
+        if(!leaf)
+            return nullptr;
+        T *res = leaf[key & (LEAF_SIZE - 1)];
+        leaf[key & (LEAF_SIZE - 1)] = nullptr;
+        return res;
+    }
+
+    /**
+     * Frees the directory and all leaves. The elements are not touched.
+     */
+    void clear() {
+        if(_dir) {
+            for(size_t d = 0; d < DIR_SIZE; ++d)
+                delete[] _dir[d];
+            delete[] _dir;
+            _dir = nullptr;
+        }
+    }
+
+private:
+    RadixTable(const RadixTable&);
+    RadixTable& operator=(const RadixTable&);
+
+    T ***_dir;
+};
+
+}
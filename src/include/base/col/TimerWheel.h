@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#pragma once
+
+#include <base/Common.h>
+#include <base/col/DList.h>
+#include <assert.h>
+
+namespace m3 {
+
+template<class T, uint TICK_BITS = 10, uint LEVELS = 4>
+class TimerWheel;
+
+/**
+ * An item in the timer wheel. You should inherit from this class to add data to the item.
+ */
+template<class T>
+class TimerWheelItem : public DListItem {
+    template<class, uint, uint>
+    friend class TimerWheel;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param when the point in time at which the item is due
+     */
+    explicit TimerWheelItem(cycles_t when)
+        : DListItem(),
+          _when(when),
+          _list() {
+    }
+
+    /**
+     * @return the point in time at which the item is due
+     */
+    cycles_t when() const {
+        return _when;
+    }
+
+private:
+    cycles_t _when;
+    DList<T> *_list;
+};
+
+/**
+ * A hierarchical timer wheel. Time is divided into ticks of 2^TICK_BITS cycles and the items are
+ * put into the slots of LEVELS wheels with 64 slots each, depending on how far in the future they
+ * are due. Items that are due beyond the last wheel are kept in a separate list. Inserting and
+ * removing an item is O(1). When time advances, the slots of the upper wheels are cascaded down
+ * as soon as they are reached, whereas empty slots are skipped via a bitmap per wheel.
+ */
+template<class T, uint TICK_BITS, uint LEVELS>
+class TimerWheel {
+    static const uint SLOT_BITS     = 6;
+    static const size_t SLOTS       = 1 << SLOT_BITS;
+    static const uint64_t MASK      = SLOTS - 1;
+    static const uint64_t NONE      = static_cast<uint64_t>(-1);
+
+public:
+    explicit TimerWheel()
+        : _tick(),
+          _count(),
+          _used(),
+          _slots(),
+          _far() {
+    }
+
+    /**
+     * @return the number of items
+     */
+    size_t length() const {
+        return _count;
+    }
+
+    /**
+     * @return a lower bound for the point in time at which the next item is due, which is exact
+     *  if the item is in the lowest wheel. If there is no item, -1 is returned.
+     */
+    cycles_t next_due() const {
+        uint level;
+        uint64_t tick = next_tick(&level);
+        if(tick == NONE)
+            return static_cast<cycles_t>(-1);
+        if(level > 0)
+            return static_cast<cycles_t>(tick << TICK_BITS);
+
+        cycles_t min = static_cast<cycles_t>(-1);
+        const DList<T> &slot = _slots[0][tick & MASK];
+        for(auto it = slot.cbegin(); it != slot.cend(); ++it)
+            min = it->_when < min ? it->_when : min;
+        return min;
+    }
+
+    /**
+     * Inserts the given item
+     *
+     * @param item the item
+     */
+    void insert(T *item) {
+        place(item);
+        _count++;
+    }
+
+    /**
+     * Removes the given item
+     *
+     * @param item the item
+     */
+    void remove(T *item) {
+        unlink(item);
+        _count--;
+    }
+
+    /**
+     * Advances the time to <now> and removes one item that is due at or before <now>.
+     *
+     * @param now the current time
+     * @return the item or nullptr if no item is due
+     */
+    T *pop_due(cycles_t now) {
+        uint64_t target = now >> TICK_BITS;
+        while(true) {
+            uint level;
+            uint64_t tick = next_tick(&level);
+            if(tick == NONE || tick > target) {
+                // there is nothing in between, so that we can skip all ticks up to <target>
+                if(_tick < target)
+                    _tick = target;
+                return nullptr;
+            }
+
+            advance(tick);
+
+            DList<T> &slot = _slots[0][tick & MASK];
+            for(auto it = slot.begin(); it != slot.end(); ++it) {
+                if(it->_when <= now) {
+                    T *item = &*it;
+                    remove(item);
+                    return item;
+                }
+            }
+
+            // if the slot is for the current tick, it might contain items that are not due yet
+            if(tick == target)
+                return nullptr;
+        }
+    }
+
+private:
+    static uint digit(uint64_t tick, uint level) {
+        return static_cast<uint>((tick >> (level * SLOT_BITS)) & MASK);
+    }
+
+    uint64_t next_tick(uint *level) const {
+        if(_count == 0)
+            return NONE;
+
+        // the current slot of the lowest wheel is still pending, but not the ones of the upper
+        // wheels, because they are cascaded as soon as we reach them
+        for(uint l = 0; l < LEVELS; ++l) {
+            uint first = digit(_tick, l) + (l > 0 ? 1 : 0);
+            if(first >= SLOTS)
+                continue;
+            uint64_t used = _used[l] & (~static_cast<uint64_t>(0) << first);
+            if(used) {
+                uint shift = (l + 1) * SLOT_BITS;
+                uint64_t base = (_tick >> shift) << shift;
+                *level = l;
+                return base | (static_cast<uint64_t>(__builtin_ctzll(used)) << (l * SLOT_BITS));
+            }
+        }
+
+        // the far list is redistributed whenever we enter the next range of the upper wheel
+        *level = LEVELS;
+        uint shift = LEVELS * SLOT_BITS;
+        return ((_tick >> shift) + 1) << shift;
+    }
+
+    void advance(uint64_t tick) {
+        uint64_t old = _tick;
+        _tick = tick;
+
+        if((tick >> (LEVELS * SLOT_BITS)) != (old >> (LEVELS * SLOT_BITS)))
+            cascade(&_far);
+
+        // cascade from top to bottom, because the items might fall into the next lower slot
+        // that we reached as well
+        for(uint l = LEVELS - 1; l > 0; --l) {
+            if((tick >> (l * SLOT_BITS)) != (old >> (l * SLOT_BITS)))
+                cascade(&_slots[l][digit(tick, l)]);
+        }
+    }
+
+    void cascade(DList<T> *list) {
+        DList<T> items;
+        while(list->length() > 0) {
+            T *item = &*list->begin();
+            unlink(item);
+            items.append(item);
+        }
+        while(items.length() > 0) {
+            T *item = items.removeFirst();
+            place(item);
+        }
+    }
+
+    void place(T *item) {
+        uint64_t tick = item->_when >> TICK_BITS;
+        uint level = 0;
+        uint slot = digit(_tick, 0);
+        if(tick > _tick) {
+            // the level is determined by the highest digit that differs from the current tick
+            uint64_t diff = tick ^ _tick;
+            level = static_cast<uint>(63 - __builtin_clzll(diff)) / SLOT_BITS;
+            slot = digit(tick, level);
+        }
+
+        if(level >= LEVELS)
+            item->_list = &_far;
+        else {
+            item->_list = &_slots[level][slot];
+            _used[level] |= static_cast<uint64_t>(1) << slot;
+        }
+        item->_list->append(item);
+    }
+
+    void unlink(T *item) {
+        DList<T> *list = item->_list;
+        list->remove(item);
+        if(list != &_far && list->length() == 0) {
+            size_t idx = static_cast<size_t>(list - &_slots[0][0]);
+            _used[idx / SLOTS] &= ~(static_cast<uint64_t>(1) << (idx % SLOTS));
+        }
+        item->_list = nullptr;
+    }
+
+    uint64_t _tick;
+    size_t _count;
+    uint64_t _used[LEVELS];
+    DList<T> _slots[LEVELS][SLOTS];
+    DList<T> _far;
+};
+
+}
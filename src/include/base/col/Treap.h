@@ -137,6 +137,35 @@ public:
         return nullptr;
     }
 
+    /**
+     * Finds the node with the smallest key that is greater than or equal to <key>
+     *
+     * @param key the key
+     * @return the node or nullptr if there is none
+     */
+    T *find_next(typename T::key_t key) const {
+        T *res = nullptr;
+        for(T *p = _root; p != nullptr; ) {
+            if(key <= p->key()) {
+                res = p;
+                p = p->_left;
+            }
+            else
+                p = p->_right;
+        }
+        return res;
+    }
+
+    /**
+     * @return the node with the largest key or nullptr if the tree is empty
+     */
+    T *last() const {
+        T *p = _root;
+        while(p && p->_right)
+            p = p->_right;
+        return p;
+    }
+
     /**
      * Inserts the given node in the tree. Note that it is expected, that the key of the node is
      * already set.
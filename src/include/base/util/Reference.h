@@ -29,10 +29,19 @@ public:
         return _refs;
     }
     void add_ref() const {
+#if defined(__host__)
+        // the kernel shares objects between threads on host
+        __atomic_add_fetch(&_refs, 1, __ATOMIC_RELAXED);
+#else
         _refs++;
+#endif
     }
     bool rem_ref() const {
+#if defined(__host__)
+        return __atomic_sub_fetch(&_refs, 1, __ATOMIC_ACQ_REL) == 0;
+#else
         return --_refs == 0;
+#endif
     }
 
 private:
@@ -70,6 +70,11 @@ enum {
     MAX_BLOCK_SIZE      = 4096,
 };
 
+enum {
+    // the directory has a hash index (see DirIndex)
+    INODE_INDEXED       = 1,
+};
+
 constexpr inodeno_t INVALID_INO = static_cast<inodeno_t>(-1);
 
 #define M3FS_SEEK_SET 0
@@ -115,7 +120,7 @@ struct FileInfo {
 struct alignas(DTU_PKG_SIZE) INode {
     dev_t devno;
     uint16_t links;
-    uint8_t : 8;
+    uint8_t flags;
     inodeno_t inode;
     mode_t mode;
     uint64_t size;
@@ -134,6 +139,48 @@ struct DirEntry {
     char name[];
 } PACKED;
 
+/**
+ * The hash index of large directories. It is stored in the first block of the directory behind the
+ * entries "." and "..", whereas ".." spans the rest of the block so that readers skip the index. All
+ * other blocks of the directory are buckets: the lowest <depth> bits of the hash of a name select
+ * the slot that holds the block containing the entry (extendible hashing). If 2^n slots refer to the
+ * same block, its entries agree in the lowest depth-n bits of their hash. An entry without name
+ * marks an empty block.
+ */
+struct DirIndex {
+    static const uint32_t MAGIC         = 0x58444D33;
+    // directories with more blocks are indexed
+    static const size_t MIN_BLOCKS      = 4;
+    static const size_t OFFSET          = 32;
+
+    static uint32_t max_depth(size_t blocksize) {
+        size_t slots = (blocksize - OFFSET - sizeof(DirIndex)) / sizeof(blockno_t);
+        uint32_t depth = 0;
+        while((static_cast<size_t>(2) << depth) <= slots)
+            depth++;
+        return depth;
+    }
+
+    static uint32_t hash(const char *name, size_t namelen) {
+        // FNV-1a
+        uint32_t hash = 2166136261U;
+        for(size_t i = 0; i < namelen; ++i)
+            hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619U;
+        return hash;
+    }
+
+    size_t slots() const {
+        return static_cast<size_t>(1) << depth;
+    }
+    size_t slot(uint32_t hash) const {
+        return hash & (slots() - 1);
+    }
+
+    uint32_t magic;
+    uint32_t depth;
+    blockno_t buckets[];
+} PACKED;
+
 struct alignas(DTU_PKG_SIZE) SuperBlock {
     blockno_t first_inodebm_block() const {
         return 1;
@@ -153,9 +200,15 @@ struct alignas(DTU_PKG_SIZE) SuperBlock {
     blockno_t inode_blocks() const {
         return (total_inodes * sizeof(INode) + blocksize  - 1) / blocksize;
     }
-    blockno_t first_data_block() const {
+    blockno_t first_journal_block() const {
         return first_inode_block() + inode_blocks();
     }
+    blockno_t first_data_block() const {
+        return first_journal_block() + journal_blocks;
+    }
+    blockno_t journal_slot_blocks() const {
+        return journal_blocks / 2;
+    }
     uint extents_per_block() const {
         return blocksize / sizeof(Extent);
     }
@@ -165,7 +218,7 @@ struct alignas(DTU_PKG_SIZE) SuperBlock {
     uint32_t get_checksum() const {
         return 1 + blocksize * 2 + total_inodes * 3 +
             total_blocks * 5 + free_inodes * 7 + free_blocks * 11 +
-            first_free_inode * 13 + first_free_block * 17;
+            first_free_inode * 13 + first_free_block * 17 + journal_blocks * 19;
     }
 
     uint32_t blocksize;
@@ -175,9 +228,56 @@ struct alignas(DTU_PKG_SIZE) SuperBlock {
     uint32_t free_blocks;
     uint32_t first_free_inode;
     uint32_t first_free_block;
+    uint32_t journal_blocks;
     uint32_t checksum;
 } PACKED;
 
+/**
+ * The metadata journal consists of two slots with journal_slot_blocks() blocks each, which are
+ * used alternately. Each slot starts with this header, which spans header_blocks() blocks,
+ * followed by the copies of the blocks. A transaction is valid if the magic and the checksum,
+ * which covers the header and all copies, are correct. Valid transactions are replayed in the
+ * order of their sequence numbers.
+ */
+struct alignas(DTU_PKG_SIZE) JournalHeader {
+    static const uint32_t MAGIC = 0x4A334D33;
+
+    static size_t header_blocks(const SuperBlock &sb, size_t count) {
+        size_t bytes = sizeof(JournalHeader) + count * sizeof(blockno_t);
+        return (bytes + sb.blocksize - 1) / sb.blocksize;
+    }
+    static size_t capacity(const SuperBlock &sb) {
+        // each block needs a copy and an entry in the header
+        size_t slot = sb.journal_slot_blocks();
+        size_t count = slot * sb.blocksize / (sb.blocksize + sizeof(blockno_t));
+        while(count > 0 && header_blocks(sb, count) + count > slot)
+            count--;
+        return count;
+    }
+
+    uint32_t get_checksum(const void *blocks, size_t blocksize) const {
+        // FNV-1a over the header (without the checksum) and the block copies
+        uint32_t hash = 2166136261U;
+        hash = fnv(hash, &magic, sizeof(magic) + sizeof(seq) + sizeof(count));
+        hash = fnv(hash, &sb, sizeof(sb) + count * sizeof(blockno_t));
+        return fnv(hash, blocks, count * blocksize);
+    }
+
+    static uint32_t fnv(uint32_t hash, const void *data, size_t len) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < len; ++i)
+            hash = (hash ^ bytes[i]) * 16777619U;
+        return hash;
+    }
+
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t count;
+    uint32_t checksum;
+    SuperBlock sb;
+    blockno_t blocks[];
+} PACKED;
+
 class Bitmap {
 public:
     typedef uint32_t word_t;
@@ -224,6 +324,26 @@ public:
         _words[idx(bit)] &= ~bitpos(bit);
     }
 
+    /**
+     * Searches word-wise for the first bit in <bit>..<end>-1 that is set (if <set> is true) or
+     * free (otherwise).
+     *
+     * @return the bit or <end> if there is none
+     */
+    uint find(uint bit, uint end, bool set) const {
+        while(bit < end) {
+            word_t w = set ? _words[idx(bit)] : static_cast<word_t>(~_words[idx(bit)]);
+            w &= static_cast<word_t>(-1) << (bit % WORD_BITS);
+            uint base = bit & ~static_cast<uint>(WORD_BITS - 1);
+            if(w) {
+                uint res = base + static_cast<uint>(__builtin_ctz(w));
+                return res < end ? res : end;
+            }
+            bit = base + WORD_BITS;
+        }
+        return end;
+    }
+
 private:
     static size_t idx(uint bit) {
         return bit / WORD_BITS;
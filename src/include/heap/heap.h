@@ -28,12 +28,27 @@ typedef void (*heap_dblfree_func)(void *p);
 typedef struct HeapArea {
     word_t next;    /* HEAP_USED_BITS set = used */
     word_t prev;
-    uint8_t _pad[64 - sizeof(word_t) * 2];
+    /* the links in the free list of the size class; only valid if the area is free */
+    struct HeapArea *fnext;
+    struct HeapArea *fprev;
+    uint8_t _pad[64 - sizeof(word_t) * 2 - sizeof(void*) * 2];
 } PACKED HeapArea;
 
+typedef struct HeapStats {
+    size_t allocs;      /* number of allocations so far */
+    size_t frees;       /* number of frees so far */
+    size_t grown;       /* number of reallocs that have been done in place */
+    size_t used;        /* bytes in used areas, including the headers */
+    size_t free;        /* bytes in free areas, including the headers */
+    size_t free_areas;  /* number of free areas */
+    size_t largest;     /* size of the largest free area, including the header */
+} HeapStats;
+
 extern HeapArea *heap_begin;
 extern HeapArea *heap_end;
 
+EXTERN_C void heap_init(uintptr_t begin, uintptr_t end);
+
 EXTERN_C void heap_set_alloc_callback(heap_alloc_func callback);
 EXTERN_C void heap_set_free_callback(heap_free_func callback);
 EXTERN_C void heap_set_oom_callback(heap_oom_func callback);
@@ -48,3 +63,4 @@ EXTERN_C void heap_append(size_t pages);
 
 EXTERN_C size_t heap_free_memory();
 EXTERN_C uintptr_t heap_used_end();
+EXTERN_C void heap_stats(HeapStats *stats);
@@ -33,6 +33,65 @@ class Syscalls {
     friend class Env;
 
 public:
+    /**
+     * Collects multiple system calls to execute them with a single message to the kernel (see
+     * Syscalls::batch). Only system calls that reply nothing but an error code are supported.
+     */
+    class Batch {
+        friend class Syscalls;
+
+    public:
+        explicit Batch()
+            : _size(),
+              _count(),
+              _overflow(),
+              _executed(),
+              _msgs(),
+              _errors() {
+        }
+
+        /**
+         * @return the number of collected calls
+         */
+        size_t count() const {
+            return _count;
+        }
+        /**
+         * @return the number of calls that have been executed by the kernel
+         */
+        size_t executed() const {
+            return _executed;
+        }
+        /**
+         * @return the result of the call with given index
+         */
+        Errors::Code error(size_t idx) const {
+            return static_cast<Errors::Code>(_errors[idx]);
+        }
+
+        Batch &createsess(capsel_t dst, capsel_t srv, word_t ident);
+        Batch &creatergate(capsel_t dst, int order, int msgorder);
+        Batch &createsgate(capsel_t dst, capsel_t rgate, label_t label, word_t credits);
+        Batch &createmgate(capsel_t dst, goff_t addr, size_t size, int perms);
+        Batch &createmap(capsel_t dst, capsel_t vpe, capsel_t mgate, capsel_t first,
+                         capsel_t pages, int perms);
+        Batch &activate(capsel_t ep, capsel_t gate, goff_t addr);
+        Batch &derivemem(capsel_t dst, capsel_t src, goff_t offset, size_t size, int perms);
+        Batch &exchange(capsel_t vpe, const KIF::CapRngDesc &own, capsel_t other, bool obtain);
+        Batch &revoke(capsel_t vpe, const KIF::CapRngDesc &crd, bool own = true);
+        Batch &noop();
+
+    private:
+        Batch &append(const void *req, size_t size);
+
+        size_t _size;
+        size_t _count;
+        bool _overflow;
+        size_t _executed;
+        xfer_t _msgs[ARRAY_SIZE(KIF::Syscall::Batch::msgs)];
+        xfer_t _errors[KIF::Syscall::MAX_BATCH];
+    };
+
     static Syscalls &get() {
         return _inst;
     }
@@ -77,6 +136,16 @@ public:
 
     Errors::Code noop();
 
+    /**
+     * Executes the calls in <b> in order with a single message to the kernel. Afterwards,
+     * b.executed() and b.error() tell how far the kernel got and the results of the calls.
+     *
+     * @param b the calls
+     * @param cont whether the remaining calls should be executed if one fails
+     * @return the first error or NO_SPACE if the calls did not fit into one message
+     */
+    Errors::Code batch(Batch &b, bool cont = false);
+
     void exit(int exitcode);
 
 private:
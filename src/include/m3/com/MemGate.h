@@ -50,6 +50,24 @@ public:
         CMD_NOPF = DTU::CmdFlags::NOPF,
     };
 
+    /**
+     * Identifies an asynchronous read or write (see read_async and write_async). Every ticket has
+     * to be passed to wait() to finish the operation.
+     */
+    class Ticket {
+        friend class MemGate;
+
+    public:
+        explicit Ticket()
+            : _slot(DTU::NO_SLOT),
+              _res(Errors::NONE) {
+        }
+
+    private:
+        size_t _slot;
+        Errors::Code _res;
+    };
+
     /**
      * Creates a new memory gate for global memory. That is, it requests <size> bytes of global
      * memory with given permissions.
@@ -152,6 +170,76 @@ public:
      */
     Errors::Code read(void *data, size_t len, goff_t offset);
 
+    /**
+     * Writes all <count> parts in <vecs>. That is, for each part, the bytes at <data> are written
+     * to <offset>. If supported, the DTU executes all parts with a single command.
+     *
+     * @param vecs the parts to write
+     * @param count the number of parts
+     * @return the error code or Errors::NONE
+     */
+    Errors::Code writev(const IOVec *vecs, size_t count);
+
+    /**
+     * Reads all <count> parts in <vecs>. That is, for each part, the bytes at <offset> are read
+     * into <data>. If supported, the DTU executes all parts with a single command.
+     *
+     * @param vecs the parts to read
+     * @param count the number of parts
+     * @return the error code or Errors::NONE
+     */
+    Errors::Code readv(const IOVec *vecs, size_t count);
+
+    /**
+     * Starts to write the <len> bytes at <data> to <offset>. The data must not be changed until
+     * the operation is finished.
+     *
+     * @param data the data to write
+     * @param len the number of bytes to write
+     * @param offset the start-offset
+     * @param ticket will be set to the ticket for the operation
+     * @return the error code or Errors::NONE
+     */
+    Errors::Code write_async(const void *data, size_t len, goff_t offset, Ticket &ticket);
+
+    /**
+     * Starts to read <len> bytes from <offset> into <data>. The data is only valid after the
+     * operation has been finished.
+     *
+     * Depending on the platform, multiple reads can be in flight at once. If this is not supported
+     * or all slots are in use, the read is done synchronously.
+     *
+     * @param data the buffer to write into
+     * @param len the number of bytes to read
+     * @param offset the start-offset
+     * @param ticket will be set to the ticket for the operation
+     * @return the error code or Errors::NONE
+     */
+    Errors::Code read_async(void *data, size_t len, goff_t offset, Ticket &ticket);
+
+    /**
+     * @param ticket the ticket
+     * @return true if the operation for <ticket> is finished
+     */
+    static bool is_done(const Ticket &ticket);
+
+    /**
+     * Waits until the operation for <ticket> is finished.
+     *
+     * @param ticket the ticket
+     * @return the error code or Errors::NONE
+     */
+    static Errors::Code wait(Ticket &ticket);
+
+    /**
+     * Waits until the operations for all <count> tickets in <tickets> are finished.
+     *
+     * @param tickets the tickets
+     * @param count the number of tickets
+     * @return the first error code or Errors::NONE
+     */
+    static Errors::Code wait_all(Ticket *tickets, size_t count);
+
 private:
     Errors::Code forward(void *&data, size_t &len, goff_t &offset, uint flags);
 
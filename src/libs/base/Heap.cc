@@ -37,7 +37,7 @@ void Heap::init() {
 
 void Heap::print(OStream &os) {
     HeapArea *a = heap_begin;
-    os << "Heap[free=" << free_memory() << "]\n";
+    print_stats(os);
     while(a < heap_end) {
         os << "  @ " << fmt((void*)a, "p") << " " << (is_used(a) ? "u" : "-");
         os << " next=" << (a->next & ~HEAP_USED_BITS);
@@ -46,15 +46,21 @@ void Heap::print(OStream &os) {
     }
 }
 
+void Heap::print_stats(OStream &os) {
+    HeapStats st;
+    stats(&st);
+    // the external fragmentation is the part of the free memory that is not in the largest area
+    size_t frag = st.free ? 100 - (st.largest * 100) / st.free : 0;
+    os << "Heap[used=" << st.used << ", free=" << st.free
+       << ", allocs=" << st.allocs << ", frees=" << st.frees << ", grown=" << st.grown
+       << ", areas=" << st.free_areas << ", largest=" << st.largest
+       << ", frag=" << frag << "%]\n";
+}
+
 size_t Heap::contiguous_mem() {
-    size_t max = 0;
-    HeapArea *a = heap_begin;
-    while(a < heap_end) {
-        if(!is_used(a) && a->next - sizeof(HeapArea) > max)
-            max = a->next - sizeof(HeapArea);
-        a = forward(a, a->next & ~HEAP_USED_BITS);
-    }
-    return max;
+    HeapStats st;
+    stats(&st);
+    return st.largest > sizeof(HeapArea) ? st.largest - sizeof(HeapArea) : 0;
 }
 
 void Heap::alloc_callback(void *p, size_t size) {
@@ -16,6 +16,7 @@
 
 #include <base/arch/host/HWInterrupts.h>
 #include <base/arch/host/DTUBackend.h>
+#include <base/arch/host/SharedMemory.h>
 #include <base/log/Lib.h>
 #include <base/util/Math.h>
 #include <base/DTU.h>
@@ -25,9 +26,9 @@
 #include <base/Panic.h>
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
-#include <signal.h>
 #include <unistd.h>
 
 namespace m3 {
@@ -39,13 +40,35 @@ DTU::DTU()
     : _run(true),
       _cmdregs(),
       _epregs(),
+      _unread(),
+      _occupied(),
+      _drops(),
+      _slots(),
+      _slot_errors(),
+      _resps(),
+      _spin_max(),
+      _spin_cur(),
+      _spin_hits(),
+      _sleeps(),
+      _cu_sleeping(),
+      _wakeups(),
+      _recv_msgs(),
+      _backend(),
+      _mem(),
       _tid() {
 }
 
 void DTU::start() {
-    _backend = new DTUBackend();
+    const char *spin = getenv("M3_DTU_SPIN");
+    _spin_max = spin ? strtoull(spin, nullptr, 0) : DEF_SPIN;
+    _spin_cur = _spin_max;
+
+    _backend = DTUBackend::create_backend();
     if(env()->is_kernel())
         _backend->create();
+    // the mapping survives VPE::run, so that we only need to join once
+    else if(!_mem && env()->mem_size() > 0)
+        _mem = new SharedMemory("mem", env()->mem_size(), SharedMemory::JOIN);
 
     int res = pthread_create(&_tid, nullptr, thread, this);
     if(res != 0)
@@ -54,7 +77,7 @@ void DTU::start() {
 
 void DTU::stop() {
     _run = false;
-    pthread_kill(_tid, SIGUSR1);
+    _backend->wakeup();
 }
 
 void DTU::reset() {
@@ -62,20 +85,75 @@ void DTU::reset() {
     // not inherited so that the child might want to reuse the EP for something else, which does
     // not work, because the cmpxchg fails.
     for(epid_t i = 0; i < EP_COUNT; ++i) {
-        if(get_ep(i, EP_BUF_ADDR) == 0)
+        if(get_ep(i, EP_BUF_ADDR) == 0) {
             memset(ep_regs() + i * EPS_RCNT, 0, EPS_RCNT * sizeof(word_t));
+            clear_slots(i);
+        }
     }
+    for(size_t i = 0; i < CMD_SLOTS; ++i)
+        _slots[i] = SLOT_FREE;
 
     delete _backend;
 }
 
+static inline void relax() {
+#if defined(__x86_64__)
+    asm volatile ("pause");
+#endif
+}
+
+template<typename F>
+bool DTU::spin(F done) const {
+    for(uint64_t i = 0; ; ++i) {
+        if(done()) {
+            // don't count it if we didn't need to wait at all
+            if(i > 0) {
+                _spin_hits++;
+                _spin_cur = Math::min(_spin_max, _spin_cur * 2);
+            }
+            return true;
+        }
+        if(i >= _spin_cur)
+            break;
+        relax();
+    }
+
+    _sleeps++;
+    _spin_cur = Math::min(_spin_max, Math::max(MIN_SPIN, _spin_cur / 2));
+    return false;
+}
+
+template<typename F>
+void DTU::wait_resp(F done) {
+    if(spin(done))
+        return;
+
+    // tell the DTU thread that we need a notification. afterwards, check again to not miss it
+    __atomic_store_n(&_cu_sleeping, 1, __ATOMIC_SEQ_CST);
+    // ignore signals here. notifications might also be stale, so check the state every time
+    while(!done())
+        _backend->wait(DTUBackend::Event::RESP);
+    __atomic_store_n(&_cu_sleeping, 0, __ATOMIC_SEQ_CST);
+}
+
+void DTU::notify_resp() {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&_cu_sleeping, __ATOMIC_SEQ_CST))
+        _backend->notify(DTUBackend::Event::RESP);
+}
+
 void DTU::try_sleep(bool, uint64_t) const {
     // check if there are unread messages. if there are, we don't want to wait but need to
     // handle the messages first
-    for(epid_t i = 0; i < EP_COUNT; ++i) {
-        if(get_ep(i, EP_BUF_MSGCNT) > 0)
-            return;
-    }
+    bool has_msgs = spin([this] {
+        for(epid_t i = 0; i < EP_COUNT; ++i) {
+            if(get_ep(i, EP_BUF_MSGCNT) > 0)
+                return true;
+        }
+        return false;
+    });
+    if(has_msgs)
+        return;
 
     _backend->wait(DTUBackend::Event::MSG);
 }
@@ -87,9 +165,42 @@ void DTU::configure_recv(epid_t ep, uintptr_t buf, uint order, uint msgorder) {
     set_ep(ep, EP_BUF_ROFF, 0);
     set_ep(ep, EP_BUF_WOFF, 0);
     set_ep(ep, EP_BUF_MSGCNT, 0);
-    set_ep(ep, EP_BUF_UNREAD, 0);
-    set_ep(ep, EP_BUF_OCCUPIED, 0);
-    assert((1UL << (order - msgorder)) <= sizeof(word_t) * 8);
+    clear_slots(ep);
+    assert((1UL << (order - msgorder)) <= MAX_MSGS);
+}
+
+void DTU::clear_slots(epid_t ep) {
+    for(size_t i = 0; i < ARRAY_SIZE(_unread[ep]); ++i) {
+        _unread[ep][i] = 0;
+        _occupied[ep][i] = 0;
+    }
+    _drops[ep] = 0;
+}
+
+static size_t scan_bits(const volatile word_t *bitmap, size_t from, size_t to, bool val) {
+    const size_t word_bits = sizeof(word_t) * 8;
+    while(from < to) {
+        size_t w = from / word_bits;
+        size_t end = Math::min(to, (w + 1) * word_bits);
+        word_t bits = val ? bitmap[w] : ~bitmap[w];
+        // ignore the bits before <from> and behind <end>
+        bits &= ~static_cast<word_t>(0) << (from % word_bits);
+        if(end % word_bits != 0)
+            bits &= (static_cast<word_t>(1) << (end % word_bits)) - 1;
+        if(bits)
+            return w * word_bits + static_cast<size_t>(__builtin_ctzl(bits));
+        from = end;
+    }
+    return to;
+}
+
+size_t DTU::find_bit(const volatile word_t *bitmap, size_t count, size_t start, bool val) {
+    // search from <start> to the end and wrap around
+    size_t i = scan_bits(bitmap, start, count, val);
+    if(i < count)
+        return i;
+    i = scan_bits(bitmap, 0, start, val);
+    return i < start ? i : count;
 }
 
 word_t DTU::check_cmd(epid_t ep, int op, word_t label, word_t credits, size_t offset, size_t length) {
@@ -109,6 +220,88 @@ word_t DTU::check_cmd(epid_t ep, int op, word_t label, word_t credits, size_t of
     return 0;
 }
 
+char *DTU::local_mem(epid_t ep, int op, size_t size, size_t off) {
+    // global memory is always located at the kernel PE
+    if(!_mem || get_ep(ep, EP_PEID) != 0)
+        return nullptr;
+
+    // let the DTU thread report errors
+    word_t label = get_ep(ep, EP_LABEL);
+    word_t credits = get_ep(ep, EP_CREDITS);
+    uint perms = label & KIF::Perm::RWX;
+    if(!(perms & (1U << (op - 1))) || off >= credits || off + size < off || off + size > credits)
+        return nullptr;
+
+    goff_t addr = (label & ~static_cast<word_t>(KIF::Perm::RWX)) + off;
+    goff_t base = env()->mem_base();
+    if(addr < base || addr + size > base + _mem->size())
+        return nullptr;
+
+    return static_cast<char*>(_mem->addr()) + (addr - base);
+}
+
+bool DTU::access_mem(epid_t ep, int op, void *data, size_t size, size_t off) {
+    char *local = local_mem(ep, op, size, off);
+    if(!local)
+        return false;
+
+    LLOG(DTU, "(" << (op == READ ? "read" : "write") << ") " << size << " bytes "
+        << (op == READ ? "from" : "to") << " #" << fmt(off, "x") << " via shared memory");
+    if(op == READ)
+        memcpy(data, local, size);
+    else
+        memcpy(local, data, size);
+    return true;
+}
+
+bool DTU::access_memv(epid_t ep, int op, const IOVec *vecs, size_t count) {
+    // either access all parts directly or none of them
+    for(size_t i = 0; i < count; ++i) {
+        if(!local_mem(ep, op, vecs[i].len, vecs[i].offset))
+            return false;
+    }
+
+    for(size_t i = 0; i < count; ++i)
+        access_mem(ep, op, vecs[i].data, vecs[i].len, vecs[i].offset);
+    return true;
+}
+
+Errors::Code DTU::read_async(epid_t ep, void *msg, size_t size, size_t off, uint flags,
+                             size_t *slot) {
+    *slot = NO_SLOT;
+    if(access_mem(ep, READ, msg, size, off))
+        return Errors::NONE;
+
+    for(size_t i = 0; i < CMD_SLOTS; ++i) {
+        if(_slots[i] == SLOT_FREE) {
+            _slots[i] = SLOT_BUSY;
+            // the reply label is passed back in the response and tells us the slot to finish.
+            // errors are reported via the slot as well
+            setup_command(ep, READ, msg, size, off, size, i + 1, 0);
+            exec_command();
+            *slot = i;
+            return Errors::NONE;
+        }
+    }
+
+    return read(ep, msg, size, off, flags);
+}
+
+Errors::Code DTU::wait_for(size_t slot) {
+    wait_resp([this, slot] {
+        return is_done(slot);
+    });
+    Errors::Code res = _slot_errors[slot];
+    _slots[slot] = SLOT_FREE;
+    return res;
+}
+
+void DTU::finish_slot(label_t slot, Errors::Code res) {
+    _slot_errors[slot - 1] = res;
+    __atomic_store_n(&_slots[slot - 1], SLOT_DONE, __ATOMIC_RELEASE);
+    notify_resp();
+}
+
 word_t DTU::prepare_reply(epid_t ep, peid_t &dstpe, epid_t &dstep) {
     const void *src = reinterpret_cast<const void*>(get_cmd(CMD_ADDR));
     const size_t size = get_cmd(CMD_SIZE);
@@ -140,6 +333,11 @@ word_t DTU::prepare_reply(epid_t ep, peid_t &dstpe, epid_t &dstep) {
     memcpy(_buf.data, src, size);
     // invalidate message for replying
     buf->has_replycap = false;
+
+    // ack the message now to make the slot available again before the reply arrives. otherwise
+    // the receiver might send the next message before the slot has been freed.
+    assert(is_occupied(ep, idx));
+    set_occupied(ep, idx, false);
     return 0;
 }
 
@@ -210,50 +408,78 @@ word_t DTU::prepare_ackmsg(epid_t ep) {
         return CTRL_ERROR;
     }
 
-    word_t occupied = get_ep(ep, EP_BUF_OCCUPIED);
-    assert(is_occupied(occupied, idx));
-    set_occupied(occupied, idx, false);
-    set_ep(ep, EP_BUF_OCCUPIED, occupied);
+    assert(is_occupied(ep, idx));
+    set_occupied(ep, idx, false);
 
     LLOG(DTU, "EP" << ep << ": acked message at index " << idx);
     return 0;
 }
 
+word_t DTU::prepare_vec(peid_t pe, epid_t ep, int op, word_t ctrl) {
+    const IOVec *vecs = reinterpret_cast<const IOVec*>(get_cmd(CMD_ADDR));
+    const size_t count = get_cmd(CMD_SIZE);
+    const word_t label = get_ep(ep, EP_LABEL);
+    const word_t credits = get_ep(ep, EP_CREDITS);
+
+    // check all parts first to execute either all or none of them
+    for(size_t i = 0; i < count; ++i) {
+        if(check_cmd(ep, op, label, credits, vecs[i].offset, vecs[i].len))
+            return CTRL_ERROR;
+    }
+
+    LLOG(DTU, "(" << (op == READ ? "readv" : "writev") << ") " << count << " parts");
+
+    // send one message per part, reusing the registers of the single commands
+    size_t failed = 0;
+    for(size_t i = 0; i < count; ++i) {
+        peid_t dstpe;
+        epid_t dstep;
+        set_cmd(CMD_ADDR, reinterpret_cast<word_t>(vecs[i].data));
+        set_cmd(CMD_SIZE, vecs[i].len);
+        set_cmd(CMD_OFFSET, vecs[i].offset);
+        set_cmd(CMD_LENGTH, vecs[i].len);
+        if(op == READ)
+            prepare_read(ep, dstpe, dstep);
+        else
+            prepare_write(ep, dstpe, dstep);
+
+        prepare_header(pe, ep, op, ctrl);
+        Errors::Code res = send_msg(ep, dstpe, dstep, false);
+        if(res != Errors::NONE) {
+            set_cmd(CMD_ERROR, res);
+            failed++;
+        }
+    }
+
+    // the command is finished as soon as all read responses have arrived
+    if(op == READ && count > failed) {
+        _resps = count - failed;
+        return ctrl & ~CTRL_START;
+    }
+    return failed > 0 ? CTRL_ERROR : 0;
+}
+
 word_t DTU::prepare_fetchmsg(epid_t ep) {
     word_t msgs = get_ep(ep, EP_BUF_MSGCNT);
     if(msgs == 0)
         return CTRL_ERROR;
 
     size_t roff = get_ep(ep, EP_BUF_ROFF);
-    word_t unread = get_ep(ep, EP_BUF_UNREAD);
     size_t ord = get_ep(ep, EP_BUF_ORDER);
     size_t msgord = get_ep(ep, EP_BUF_MSGORDER);
     size_t size = 1UL << (ord - msgord);
 
-    size_t i;
-    for(i = roff; i < size; ++i) {
-        if(is_unread(unread, i))
-            goto found;
-    }
-    for(i = 0; i < roff; ++i) {
-        if(is_unread(unread, i))
-            goto found;
-    }
-
-    // should not get here
-    assert(false);
+    size_t i = find_bit(_unread[ep], size, roff % size, true);
+    // should not happen, because the message count is not zero
+    assert(i < size);
+    assert(is_occupied(ep, i));
 
-found:
-    assert(is_occupied(get_ep(ep, EP_BUF_OCCUPIED), i));
-
-    set_unread(unread, i, false);
+    set_unread(ep, i, false);
     msgs--;
     roff = i + 1;
-    assert(Math::bits_set(unread) == msgs);
 
     LLOG(DTU, "EP" << ep << ": fetched message at index " << i << " (count=" << msgs << ")");
 
-    set_ep(ep, EP_BUF_UNREAD, unread);
     set_ep(ep, EP_BUF_ROFF, roff);
     set_ep(ep, EP_BUF_MSGCNT, msgs);
 
@@ -267,13 +493,14 @@ void DTU::handle_command(peid_t pe) {
     word_t newctrl = 0;
     peid_t dstpe;
     epid_t dstep;
+    Errors::Code res;
 
     // clear error
     set_cmd(CMD_CTRL, get_cmd(CMD_CTRL) & ~CTRL_ERROR);
+    set_cmd(CMD_ERROR, Errors::NONE);
 
     // get regs
     const epid_t ep = get_cmd(CMD_EPID);
-    const epid_t reply_ep = get_cmd(CMD_REPLY_EPID);
     const word_t ctrl = get_cmd(CMD_CTRL);
     int op = (ctrl >> OPCODE_SHIFT) & 0xF;
     if(ep >= EP_COUNT) {
@@ -293,9 +520,16 @@ void DTU::handle_command(peid_t pe) {
             break;
         case READ:
             newctrl |= prepare_read(ep, dstpe, dstep);
-            // we report the completion of the read later
-            if(~newctrl & CTRL_ERROR)
+            // we report the completion of the read later, either via the command register or via
+            // the command slot, if there is any
+            if(get_cmd(CMD_REPLYLBL) != 0) {
+                if(newctrl & CTRL_ERROR)
+                    finish_slot(get_cmd(CMD_REPLYLBL), Errors::INV_ARGS);
+            }
+            else if(~newctrl & CTRL_ERROR) {
+                _resps = 1;
                 newctrl |= (ctrl & ~CTRL_START);
+            }
             break;
         case WRITE:
             newctrl |= prepare_write(ep, dstpe, dstep);
@@ -308,36 +542,52 @@ void DTU::handle_command(peid_t pe) {
             newctrl |= prepare_ackmsg(ep);
             set_cmd(CMD_CTRL, newctrl);
             return;
+        case READV:
+        case WRITEV:
+            newctrl |= prepare_vec(pe, ep, op == READV ? READ : WRITE, ctrl);
+            set_cmd(CMD_CTRL, newctrl);
+            return;
     }
     if(newctrl & CTRL_ERROR)
         goto error;
 
+    prepare_header(pe, ep, op, ctrl);
+    res = send_msg(ep, dstpe, dstep, op == REPLY);
+    if(res != Errors::NONE) {
+        // the read response will never arrive
+        if(op == READ && get_cmd(CMD_REPLYLBL) != 0)
+            finish_slot(get_cmd(CMD_REPLYLBL), res);
+        _resps = 0;
+        set_cmd(CMD_ERROR, res);
+        newctrl = CTRL_ERROR;
+    }
+
+error:
+    set_cmd(CMD_CTRL, newctrl);
+}
+
+void DTU::prepare_header(peid_t pe, epid_t ep, int op, word_t ctrl) {
     // prepare message (add length and label)
     _buf.opcode = op;
     if(ctrl & CTRL_DEL_REPLY_CAP) {
         _buf.has_replycap = 1;
         _buf.pe = pe;
         _buf.snd_ep = ep;
-        _buf.rpl_ep = reply_ep;
+        _buf.rpl_ep = get_cmd(CMD_REPLY_EPID);
         _buf.replylabel = get_cmd(CMD_REPLYLBL);
     }
     else
         _buf.has_replycap = 0;
-
-    send_msg(ep, dstpe, dstep, op == REPLY);
-
-error:
-    set_cmd(CMD_CTRL, newctrl);
 }
 
-void DTU::send_msg(epid_t ep, peid_t dstpe, epid_t dstep, bool isreply) {
+Errors::Code DTU::send_msg(epid_t ep, peid_t dstpe, epid_t dstep, bool isreply) {
     LLOG(DTU, (isreply ? ">> " : "-> ") << fmt(_buf.length, 3) << "b"
             << " lbl=" << fmt(_buf.label, "#0x", sizeof(label_t) * 2)
             << " over " << ep << " to pe:ep=" << dstpe << ":" << dstep
             << " (crd=#" << fmt(get_ep(dstep, EP_CREDITS), "x")
             << " rep=" << _buf.rpl_ep << ")");
 
-    _backend->send(dstpe, dstep, &_buf);
+    return _backend->send(dstpe, dstep, &_buf);
 }
 
 void DTU::handle_read_cmd(epid_t ep) {
@@ -360,7 +610,13 @@ void DTU::handle_read_cmd(epid_t ep) {
     reinterpret_cast<word_t*>(_buf.data)[2] = 0;
     memcpy(_buf.data + _buf.length, reinterpret_cast<void*>(offset), length);
     _buf.length += length;
-    send_msg(ep, dstpe, dstep, true);
+    if(send_msg(ep, dstpe, dstep, true) != Errors::NONE) {
+        // let the reader know that the data won't arrive
+        _buf.length = sizeof(word_t) * 3;
+        reinterpret_cast<word_t*>(_buf.data)[1] = 0;
+        reinterpret_cast<word_t*>(_buf.data)[2] = CTRL_ERROR;
+        send_msg(ep, dstpe, dstep, true);
+    }
 }
 
 void DTU::handle_write_cmd(epid_t) {
@@ -371,6 +627,16 @@ void DTU::handle_write_cmd(epid_t) {
             << "+#" << fmt(offset - base, "x"));
     assert(length <= sizeof(_buf.data));
     memcpy(reinterpret_cast<void*>(offset), _buf.data + sizeof(word_t) * 2, length);
+
+    // the kernel configures our endpoints remotely; start with empty receive buffers in this case
+    word_t regs = reinterpret_cast<word_t>(_epregs);
+    if(length > 0 && offset < regs + sizeof(_epregs) && offset + length > regs) {
+        const size_t epsize = EPS_RCNT * sizeof(word_t);
+        size_t first = (Math::max(offset, regs) - regs) / epsize;
+        size_t last = (Math::min(offset + length, regs + sizeof(_epregs)) - 1 - regs) / epsize;
+        for(size_t ep = first; ep <= last; ++ep)
+            clear_slots(ep);
+    }
 }
 
 void DTU::handle_resp_cmd() {
@@ -383,52 +649,49 @@ void DTU::handle_resp_cmd() {
     assert(length <= sizeof(_buf.data));
     memcpy(reinterpret_cast<void*>(offset), _buf.data + sizeof(word_t) * 3, length);
     /* provide feedback to SW */
-    set_cmd(CMD_CTRL, resp);
-    _backend->notify(DTUBackend::Event::RESP);
+    if(_buf.replylabel != 0)
+        finish_slot(_buf.replylabel, (resp & CTRL_ERROR) ? Errors::INV_ARGS : Errors::NONE);
+    else {
+        if(resp & CTRL_ERROR)
+            set_cmd(CMD_ERROR, Errors::INV_ARGS);
+        if(--_resps == 0) {
+            set_cmd(CMD_CTRL, resp);
+            notify_resp();
+        }
+    }
 }
 
 void DTU::handle_msg(size_t len, epid_t ep) {
     const size_t msgord = get_ep(ep, EP_BUF_MSGORDER);
     const size_t msgsize = 1UL << msgord;
     if(len > msgsize) {
-        LLOG(DTUERR, "DMA-error: dropping message because space is not sufficient"
-                << " (required: " << len << ", available: " << msgsize << ")");
+        _drops[ep]++;
+        LLOG(DTUERR, "DMA-error: EP" << ep << ": dropping message because space is not sufficient"
+                << " (required: " << len << ", available: " << msgsize
+                << ", dropped: " << _drops[ep] << ")");
         return;
     }
 
-    word_t occupied = get_ep(ep, EP_BUF_OCCUPIED);
-    word_t unread = get_ep(ep, EP_BUF_UNREAD);
     word_t msgs = get_ep(ep, EP_BUF_MSGCNT);
     size_t woff = get_ep(ep, EP_BUF_WOFF);
     size_t ord = get_ep(ep, EP_BUF_ORDER);
     size_t size = 1UL << (ord - msgord);
 
-    size_t i;
-    for (i = woff; i < size; ++i)
-    {
-        if (!is_occupied(occupied, i))
-            goto found;
-    }
-    for (i = 0; i < woff; ++i)
-    {
-        if (!is_occupied(occupied, i))
-            goto found;
+    size_t i = find_bit(_occupied[ep], size, woff % size, false);
+    if(i == size) {
+        _drops[ep]++;
+        LLOG(DTUERR, "EP" << ep << ": dropping message because no slot is free"
+                << " (dropped: " << _drops[ep] << ")");
+        return;
     }
 
-    LLOG(DTUERR, "EP" << ep << ": dropping message because no slot is free");
-    return;
-
-found:
-    set_occupied(occupied, i, true);
-    set_unread(unread, i, true);
+    set_occupied(ep, i, true);
+    set_unread(ep, i, true);
     msgs++;
     woff = i + 1;
-    assert(Math::bits_set(unread) == msgs);
 
     LLOG(DTU, "EP" << ep << ": put message at index " << i << " (count=" << msgs << ")");
 
-    set_ep(ep, EP_BUF_OCCUPIED, occupied);
-    set_ep(ep, EP_BUF_UNREAD, unread);
     set_ep(ep, EP_BUF_MSGCNT, msgs);
     set_ep(ep, EP_BUF_WOFF, woff);
 
@@ -438,10 +701,10 @@ found:
     _backend->notify(DTUBackend::Event::MSG);
 }
 
-void DTU::handle_receive(epid_t ep) {
+bool DTU::handle_receive(epid_t ep) {
     ssize_t res = _backend->recv(ep, &_buf);
     if(res < 0)
-        return;
+        return false;
 
     const int op = _buf.opcode;
     switch(op) {
@@ -478,43 +741,48 @@ void DTU::handle_receive(epid_t ep) {
            << " ep=" << ep
            << " (cnt=#" << fmt(get_ep(ep, EP_BUF_MSGCNT), "x") << ","
            << "crd=#" << fmt(get_ep(ep, EP_CREDITS), "x") << ")");
+    return true;
 }
 
 Errors::Code DTU::exec_command() {
     _backend->notify(DTUBackend::Event::REQ);
-    // ignore signals here
-    while(!_backend->wait(DTUBackend::Event::RESP))
-        ;
-    // TODO report errors here
-    return Errors::NONE;
-}
-
-static void sigstop(int) {
+    wait_resp([this] {
+        return is_ready();
+    });
+    // TODO report the other errors here as well
+    return static_cast<Errors::Code>(get_cmd(CMD_ERROR));
 }
 
 void *DTU::thread(void *arg) {
     DTU *dma = static_cast<DTU*>(arg);
     peid_t pe = env()->pe;
 
-    signal(SIGUSR1, sigstop);
-
     while(dma->_run) {
+        dma->_backend->wait_for_work();
+
+        // check _run again, because stop() wakes us up
+        if(!dma->_run)
+            break;
+        dma->_wakeups++;
+
         // should we send something?
         if(dma->_backend->has_command()) {
             dma->handle_command(pe);
             if(dma->is_ready())
-                dma->_backend->notify(DTUBackend::Event::RESP);
+                dma->notify_resp();
         }
 
-        // check _run again. TODO we might still miss the signal
-        if(dma->_run) {
-            // have we received a message?
-            epid_t ep = dma->_backend->has_msg();
-            if(ep != EP_COUNT)
-                dma->handle_receive(ep);
+        // receive all messages that are available
+        epid_t ep;
+        while((ep = dma->_backend->has_msg()) != EP_COUNT) {
+            if(dma->handle_receive(ep))
+                dma->_recv_msgs++;
         }
     }
 
+    LLOG(DTU, "Received " << dma->_recv_msgs << " messages in " << dma->_wakeups << " wakeups; "
+        << "CU waits: " << dma->_spin_hits << " by spinning, " << dma->_sleeps << " by sleeping");
+
     if(env()->is_kernel())
         dma->_backend->destroy();
     delete dma->_backend;
@@ -20,6 +20,7 @@
 #include <base/Panic.h>
 
 #include <sys/types.h>
+#include <sys/epoll.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
 #include <sys/socket.h>
@@ -27,6 +28,7 @@
 #include <fcntl.h>
 #include <poll.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 namespace m3 {
@@ -35,13 +37,26 @@ static const char *ev_names[] = {
     "REQ", "RESP", "MSG"
 };
 
-DTUBackend::DTUBackend()
+DTUBackend *DTUBackend::create_backend() {
+    const char *name = getenv("M3_DTU_BACKEND");
+    if(name && strcmp(name, "shm") == 0)
+        return new ShmBackend();
+    if(name && strcmp(name, "socket") != 0)
+        PANIC("Unknown DTU backend '" << name << "'");
+    return new SocketBackend();
+}
+
+SocketBackend::SocketBackend()
     : _sock(socket(AF_UNIX, SOCK_DGRAM, 0)),
-      _pending(),
+      _epfd(epoll_create1(EPOLL_CLOEXEC)),
+      _ready(),
+      _next(),
       _localsocks(),
       _endpoints() {
     if(_sock == -1)
         PANIC("Unable to open socket: " << strerror(errno));
+    if(_epfd == -1)
+        PANIC("Unable to create epoll instance: " << strerror(errno));
 
     // build socket names for all endpoints on all PEs
     for(peid_t pe = 0; pe < PE_COUNT; ++pe) {
@@ -69,68 +84,93 @@ DTUBackend::DTUBackend()
             PANIC("Binding socket for ep " << ep << " failed: " << strerror(errno));
     }
 
-    for(size_t i = 0; i < ARRAY_SIZE(_fds); ++i) {
-        _fds[i].fd = _localsocks[i];
-        _fds[i].events = POLLIN | POLLERR;
-        _fds[i].revents = 0;
+    // the DTU thread waits for the endpoints and REQ; the index is stored as the event data
+    for(size_t i = 0; i <= EP_COUNT + static_cast<size_t>(Event::REQ); ++i) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        if(epoll_ctl(_epfd, EPOLL_CTL_ADD, _localsocks[i], &ev) == -1)
+            PANIC("Adding socket " << i << " to epoll failed: " << strerror(errno));
     }
 }
 
-DTUBackend::~DTUBackend() {
+SocketBackend::~SocketBackend() {
+    close(_epfd);
     for(epid_t ep = 0; ep < ARRAY_SIZE(_localsocks); ++ep)
         close(_localsocks[ep]);
 }
 
-void DTUBackend::poll() {
-    _pending = ::ppoll(_fds, ARRAY_SIZE(_fds), nullptr, nullptr);
-    if(_pending < 0 && errno != EINTR)
-        LLOG(DTUERR, "Polling for notifications failed: " << strerror(errno));
+void SocketBackend::wait_for_work() {
+    // if there is still something left from the last wakeup, handle that first
+    if(_ready != 0)
+        return;
+
+    struct epoll_event evs[EP_COUNT + 1];
+    int res = epoll_wait(_epfd, evs, ARRAY_SIZE(evs), -1);
+    if(res == -1) {
+        if(errno != EINTR)
+            LLOG(DTUERR, "Waiting for notifications failed: " << strerror(errno));
+        return;
+    }
+
+    for(int i = 0; i < res; ++i)
+        _ready |= static_cast<word_t>(1) << evs[i].data.u64;
+}
+
+void SocketBackend::wakeup() {
+    // the notification stays in the socket, so that epoll_wait does not block anymore
+    notify(Event::REQ);
 }
 
-bool DTUBackend::has_command() {
-    if(_pending <= 0)
-        poll();
+bool SocketBackend::has_command() {
+    size_t idx = EP_COUNT + static_cast<size_t>(Event::REQ);
+    word_t bit = static_cast<word_t>(1) << idx;
+    if(!(_ready & bit))
+        return false;
 
-    size_t fdidx = EP_COUNT + static_cast<size_t>(Event::REQ);
-    if(_fds[fdidx].revents != 0) {
-        uint8_t dummy = 0;
-        if(recvfrom(_fds[fdidx].fd, &dummy, sizeof(dummy), 0, nullptr, nullptr) <= 0) {
+    _ready &= ~bit;
+    uint8_t dummy = 0;
+    if(recvfrom(_localsocks[idx], &dummy, sizeof(dummy), MSG_DONTWAIT, nullptr, nullptr) <= 0) {
+        if(errno != EAGAIN) {
             LLOG(DTUERR, "Receiving notification from " << ev_names[static_cast<size_t>(Event::REQ)]
                                                         << " failed: " << strerror(errno));
         }
-
-        _fds[fdidx].revents = 0;
-        _pending--;
-        return true;
+        return false;
     }
-    return false;
+    return true;
 }
 
-epid_t DTUBackend::has_msg() {
-    if(_pending <= 0)
-        poll();
+epid_t SocketBackend::has_msg() {
+    word_t eps = _ready & ((static_cast<word_t>(1) << EP_COUNT) - 1);
+    if(eps == 0)
+        return EP_COUNT;
 
+    // the bit stays set until the socket is drained (see recv)
     for(epid_t i = 0; i < EP_COUNT; ++i) {
-        if(_fds[i].revents != 0) {
-            _fds[i].revents = 0;
-            _pending--;
-            return i;
+        epid_t ep = (_next + i) % EP_COUNT;
+        if(eps & (static_cast<word_t>(1) << ep)) {
+            _next = (ep + 1) % EP_COUNT;
+            return ep;
         }
     }
     return EP_COUNT;
 }
 
-void DTUBackend::notify(Event ev) {
+void SocketBackend::notify(Event ev) {
     uint8_t dummy = 0;
     sockaddr_un *dstsock = _endpoints + env()->pe * (EP_COUNT + 3) + EP_COUNT + static_cast<size_t>(ev);
-    int res = sendto(_sock, &dummy, sizeof(dummy), 0, (struct sockaddr*)dstsock, sizeof(sockaddr_un));
-    if(res == -1) {
+    // MSG notifications are only consumed if the CU goes to sleep and RESP notifications for
+    // command slots are not consumed if the CU polls them. thus, they can pile up and we don't want
+    // to block in this case, because a wakeup is pending anyway.
+    int flags = ev != Event::REQ ? MSG_DONTWAIT : 0;
+    int res = sendto(_sock, &dummy, sizeof(dummy), flags, (struct sockaddr*)dstsock, sizeof(sockaddr_un));
+    if(res == -1 && (ev == Event::REQ || errno != EAGAIN)) {
         LLOG(DTUERR, "Sending notification to " << ev_names[static_cast<size_t>(ev)]
                                                 << " failed: " << strerror(errno));
     }
 }
 
-bool DTUBackend::wait(Event ev) {
+bool SocketBackend::wait(Event ev) {
     struct pollfd fds;
     fds.fd = _localsocks[EP_COUNT + static_cast<size_t>(ev)];
     fds.events = POLLIN;
@@ -151,17 +191,25 @@ bool DTUBackend::wait(Event ev) {
     return true;
 }
 
-void DTUBackend::send(peid_t pe, epid_t ep, const DTU::Buffer *buf) {
+Errors::Code SocketBackend::send(peid_t pe, epid_t ep, const DTU::Buffer *buf) {
     int res = sendto(_sock, buf, buf->length + DTU::HEADER_SIZE, 0,
                      (struct sockaddr*)(_endpoints + pe * (EP_COUNT + 3) + ep), sizeof(sockaddr_un));
-    if(res == -1)
+    if(res == -1) {
         LLOG(DTUERR, "Sending message to EP " << pe << ":" << ep << " failed: " << strerror(errno));
+        // the receiver might simply not exist (anymore); as before, the message is lost then
+        if(errno == EMSGSIZE)
+            return Errors::INV_ARGS;
+    }
+    return Errors::NONE;
 }
 
-ssize_t DTUBackend::recv(epid_t ep, DTU::Buffer *buf) {
-    ssize_t res = recvfrom(_localsocks[ep], buf, sizeof(*buf), 0, nullptr, nullptr);
-    if(res <= 0)
+ssize_t SocketBackend::recv(epid_t ep, DTU::Buffer *buf) {
+    ssize_t res = recvfrom(_localsocks[ep], buf, sizeof(*buf), MSG_DONTWAIT, nullptr, nullptr);
+    if(res <= 0) {
+        // drained; epoll will tell us if there is more
+        _ready &= ~(static_cast<word_t>(1) << ep);
         return -1;
+    }
     return res;
 }
 
@@ -73,6 +73,12 @@ static void load_params(Env *e) {
     in >> shm_prefix >> pe >> lbl >> ep >> credits;
 
     e->set_params(pe, shm_prefix, lbl, ep, credits);
+
+    // optional; leave the shared main memory unused if it's not present
+    goff_t mem_base = 0;
+    size_t mem_size = 0;
+    in >> mem_base >> mem_size;
+    e->set_mem(mem_base, mem_size);
 }
 
 EXTERN_C WEAK void init_env() {
@@ -144,6 +150,8 @@ Env::Env(EnvBackend *backend, int logfd)
       _sysc_label(),
       _sysc_epid(),
       _sysc_credits(),
+      _mem_base(),
+      _mem_size(),
       _log_mutex(PTHREAD_MUTEX_INITIALIZER) {
 }
 
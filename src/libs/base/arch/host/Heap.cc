@@ -51,17 +51,12 @@ USED void free(void *p) {
 namespace m3 {
 
 void Heap::init_arch() {
-    heap_begin = reinterpret_cast<HeapArea*>(mmap(0, HEAP_SIZE, PROT_READ | PROT_WRITE,
-                                                  MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
-    if(heap_begin == MAP_FAILED)
+    void *mem = mmap(0, HEAP_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if(mem == MAP_FAILED)
         PANIC("Unable to map heap");
 
-    heap_end = heap_begin + (HEAP_SIZE / sizeof(HeapArea)) - sizeof(HeapArea);
-    heap_end->next = 0;
-    heap_end->prev = static_cast<size_t>(heap_end - heap_begin) * sizeof(HeapArea);
-    HeapArea *a = heap_begin;
-    a->next = static_cast<size_t>(heap_end - heap_begin) * sizeof(HeapArea);
-    a->prev = 0;
+    uintptr_t begin = reinterpret_cast<uintptr_t>(mem);
+    heap_init(begin, begin + HEAP_SIZE);
 }
 
 }
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2016-2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+#include <base/arch/host/DTUBackend.h>
+#include <base/arch/host/SharedMemory.h>
+#include <base/log/Lib.h>
+#include <base/util/Math.h>
+#include <base/DTU.h>
+#include <base/Env.h>
+#include <base/Panic.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <climits>
+#include <unistd.h>
+
+namespace m3 {
+
+static long futex(uint32_t *addr, int op, uint32_t val) {
+    return syscall(SYS_futex, addr, op, val, nullptr, nullptr, 0);
+}
+
+ShmBackend::ShmBackend()
+    : _shm(),
+      _region(),
+      _cur(),
+      _next(),
+      _reqs(),
+      _stop(),
+      _events(),
+      _pending(),
+      _pending_count() {
+    // the kernel creates the shared memory in create()
+    if(!env()->is_kernel())
+        init_region(new SharedMemory("dtu", sizeof(Region), SharedMemory::JOIN));
+}
+
+ShmBackend::~ShmBackend() {
+    for(peid_t pe = 0; pe < PE_COUNT; ++pe) {
+        while(_pending[pe].length() > 0) {
+            Pending *p = _pending[pe].remove_first();
+            munmap(p, sizeof(*p) + p->size);
+        }
+    }
+    delete _shm;
+}
+
+void ShmBackend::create() {
+    init_region(new SharedMemory("dtu", sizeof(Region), SharedMemory::CREATE));
+}
+
+void ShmBackend::destroy() {
+    delete _shm;
+    _shm = nullptr;
+    _region = nullptr;
+}
+
+void ShmBackend::init_region(SharedMemory *shm) {
+    _shm = shm;
+    _region = reinterpret_cast<Region*>(shm->addr());
+
+    // drop messages that have been sent to a previous user of this PE. they would have been lost
+    // with sockets as well, because the socket would not have been bound.
+    peid_t pe = env()->pe;
+    for(peid_t src = 0; src < PE_COUNT; ++src) {
+        Ring &r = ring(pe, src);
+        __atomic_store_n(&r.tail, __atomic_load_n(&r.head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    }
+}
+
+void ShmBackend::ring_doorbell(peid_t pe) {
+    Doorbell &bell = _region->bells[pe];
+    __atomic_fetch_add(&bell.seq, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&bell.waiters, __ATOMIC_SEQ_CST) > 0)
+        futex(&bell.seq, FUTEX_WAKE, INT_MAX);
+}
+
+void ShmBackend::wait_doorbell() {
+    Doorbell &bell = _region->bells[env()->pe];
+    uint32_t seq = __atomic_load_n(&bell.seq, __ATOMIC_SEQ_CST);
+
+    // check for work after reading the sequence number to not miss a wakeup
+    if(__atomic_load_n(&_stop, __ATOMIC_SEQ_CST) || __atomic_load_n(&_reqs, __ATOMIC_SEQ_CST) > 0)
+        return;
+    for(peid_t src = 0; src < PE_COUNT; ++src) {
+        Ring &r = ring(env()->pe, src);
+        if(__atomic_load_n(&r.head, __ATOMIC_SEQ_CST) != r.tail)
+            return;
+    }
+    for(peid_t dst = 0; _pending_count > 0 && dst < PE_COUNT; ++dst) {
+        const Ring &r = ring(dst, env()->pe);
+        if(_pending[dst].length() > 0 && space(r) >= _pending[dst].begin()->total)
+            return;
+    }
+
+    __atomic_fetch_add(&bell.waiters, 1, __ATOMIC_SEQ_CST);
+    // returns immediately if the sequence number has already changed
+    futex(&bell.seq, FUTEX_WAIT, seq);
+    __atomic_fetch_sub(&bell.waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+void ShmBackend::wait_for_work() {
+    send_pending();
+    // if messages are still pending, the receivers ring our doorbell when they made room
+    wait_doorbell();
+}
+
+void ShmBackend::wakeup() {
+    __atomic_store_n(&_stop, true, __ATOMIC_SEQ_CST);
+    ring_doorbell(env()->pe);
+}
+
+bool ShmBackend::has_command() {
+    uint32_t reqs = __atomic_load_n(&_reqs, __ATOMIC_ACQUIRE);
+    while(reqs > 0) {
+        if(__atomic_compare_exchange_n(&_reqs, &reqs, reqs - 1, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return true;
+    }
+    return false;
+}
+
+epid_t ShmBackend::has_msg() {
+    peid_t pe = env()->pe;
+    for(peid_t i = 0; i < PE_COUNT; ++i) {
+        peid_t src = (_next + i) % PE_COUNT;
+        Ring &r = ring(pe, src);
+        if(__atomic_load_n(&r.head, __ATOMIC_ACQUIRE) != r.tail) {
+            RecordHeader hd;
+            copy_out(r, r.tail, &hd, sizeof(hd));
+            _cur = src;
+            _next = (src + 1) % PE_COUNT;
+            return hd.ep;
+        }
+    }
+    return EP_COUNT;
+}
+
+void ShmBackend::notify(Event ev) {
+    if(ev == Event::REQ) {
+        __atomic_fetch_add(&_reqs, 1, __ATOMIC_SEQ_CST);
+        ring_doorbell(env()->pe);
+    }
+    else {
+        uint32_t *cnt = &_events[static_cast<size_t>(ev)];
+        __atomic_fetch_add(cnt, 1, __ATOMIC_SEQ_CST);
+        futex(cnt, FUTEX_WAKE_PRIVATE, INT_MAX);
+    }
+}
+
+bool ShmBackend::wait(Event ev) {
+    uint32_t *cnt = &_events[static_cast<size_t>(ev)];
+    while(true) {
+        uint32_t val = __atomic_load_n(cnt, __ATOMIC_ACQUIRE);
+        if(val > 0) {
+            if(__atomic_compare_exchange_n(cnt, &val, val - 1, false,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return true;
+            continue;
+        }
+
+        if(futex(cnt, FUTEX_WAIT_PRIVATE, 0) == -1 && errno == EINTR)
+            return false;
+    }
+}
+
+void ShmBackend::copy_in(Ring &r, uint64_t pos, const void *src, size_t len) {
+    size_t off = static_cast<size_t>(pos % RING_SIZE);
+    size_t first = Math::min(len, RING_SIZE - off);
+    memcpy(r.data + off, src, first);
+    memcpy(r.data, static_cast<const char*>(src) + first, len - first);
+}
+
+void ShmBackend::copy_out(const Ring &r, uint64_t pos, void *dst, size_t len) {
+    size_t off = static_cast<size_t>(pos % RING_SIZE);
+    size_t first = Math::min(len, RING_SIZE - off);
+    memcpy(dst, r.data + off, first);
+    memcpy(static_cast<char*>(dst) + first, r.data, len - first);
+}
+
+size_t ShmBackend::space(const Ring &r) {
+    // sequentially consistent to not miss the doorbell of the consumer (see recv())
+    return RING_SIZE - static_cast<size_t>(r.head - __atomic_load_n(&r.tail, __ATOMIC_SEQ_CST));
+}
+
+Errors::Code ShmBackend::send(peid_t pe, epid_t ep, const DTU::Buffer *buf) {
+    RecordHeader hd;
+    hd.size = static_cast<uint32_t>(buf->length + DTU::HEADER_SIZE);
+    hd.ep = static_cast<uint32_t>(ep);
+    size_t total = Math::round_up(sizeof(hd) + hd.size, sizeof(uint64_t));
+    if(total > RING_SIZE) {
+        LLOG(DTUERR, "Sending message to EP " << pe << ":" << ep << " failed: message too large"
+            << " (" << hd.size << " bytes)");
+        return Errors::INV_ARGS;
+    }
+
+    // keep the order of the messages to <pe>
+    Ring &r = ring(pe, env()->pe);
+    if(_pending[pe].length() == 0 && space(r) >= total) {
+        uint64_t head = r.head;
+        copy_in(r, head, &hd, sizeof(hd));
+        copy_in(r, head + sizeof(hd), buf, hd.size);
+        __atomic_store_n(&r.head, head + total, __ATOMIC_RELEASE);
+
+        ring_doorbell(pe);
+        return Errors::NONE;
+    }
+
+    // we can't wait for the receiver here, because it might wait for room in our ring at the
+    // same time. thus, keep the message until the receiver has made room and continue receiving.
+    size_t size = sizeof(hd) + hd.size;
+    void *mem = mmap(nullptr, sizeof(Pending) + size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED) {
+        LLOG(DTUERR, "Sending message to EP " << pe << ":" << ep << " failed: no ring space");
+        return Errors::NO_RING_SPACE;
+    }
+
+    Pending *p = static_cast<Pending*>(mem);
+    p->init();
+    p->size = size;
+    p->total = total;
+    memcpy(p->record(), &hd, sizeof(hd));
+    memcpy(p->record() + sizeof(hd), buf, hd.size);
+    _pending[pe].append(p);
+    _pending_count++;
+    __atomic_store_n(&r.blocked, 1, __ATOMIC_SEQ_CST);
+    return Errors::NONE;
+}
+
+void ShmBackend::send_pending() {
+    for(peid_t pe = 0; _pending_count > 0 && pe < PE_COUNT; ++pe) {
+        Ring &r = ring(pe, env()->pe);
+        bool sent = false;
+        while(_pending[pe].length() > 0 && space(r) >= _pending[pe].begin()->total) {
+            Pending *p = _pending[pe].remove_first();
+            uint64_t head = r.head;
+            copy_in(r, head, p->record(), p->size);
+            __atomic_store_n(&r.head, head + p->total, __ATOMIC_RELEASE);
+
+            munmap(p, sizeof(*p) + p->size);
+            _pending_count--;
+            sent = true;
+        }
+
+        if(sent) {
+            if(_pending[pe].length() == 0)
+                __atomic_store_n(&r.blocked, 0, __ATOMIC_RELAXED);
+            ring_doorbell(pe);
+        }
+    }
+}
+
+ssize_t ShmBackend::recv(epid_t, DTU::Buffer *buf) {
+    Ring &r = ring(env()->pe, _cur);
+    uint64_t tail = r.tail;
+    if(__atomic_load_n(&r.head, __ATOMIC_ACQUIRE) == tail)
+        return -1;
+
+    RecordHeader hd;
+    copy_out(r, tail, &hd, sizeof(hd));
+
+    copy_out(r, tail + sizeof(hd), buf, hd.size);
+    size_t total = Math::round_up(sizeof(hd) + hd.size, sizeof(uint64_t));
+    __atomic_store_n(&r.tail, tail + total, __ATOMIC_SEQ_CST);
+
+    // if the sender waits for room, tell it that we made some. it sets <blocked> before it
+    // checks the space, so that either it sees the new tail or we see the flag
+    if(__atomic_load_n(&r.blocked, __ATOMIC_SEQ_CST))
+        ring_doorbell(_cur);
+    return static_cast<ssize_t>(hd.size);
+}
+
+}
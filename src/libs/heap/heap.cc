@@ -20,6 +20,18 @@
 #include <heap/heap.h>
 #include <string.h>
 
+#if defined(__host__)
+#   include <pthread.h>
+
+// the kernel allocates memory from multiple threads on host
+static pthread_mutex_t heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+#   define LOCK()     pthread_mutex_lock(&heap_mutex)
+#   define UNLOCK()   pthread_mutex_unlock(&heap_mutex)
+#else
+#   define LOCK()
+#   define UNLOCK()
+#endif
+
 /*
  * The goal here is to reach a small code size, don't waste too much memory through internal or
  * external fragmentation and have a reasonably good allocate/free performance.
@@ -29,9 +41,20 @@
  * followed by the data. If the area is used, i.e. not free, the MSB in the next field is set.
  * If there is no previous, prev is 0 and if there is is no next, a + a->next will point beyond
  * HEAP_END.
+ *
+ * Additionally, the free areas are kept in segregated free lists, whose links are stored in the
+ * header of the free area. Small areas have a list per size, so that the first area of the list
+ * is an exact fit. Larger areas have a list per power of two. A bitmap of the non-empty lists
+ * allows to find the smallest list with areas that are large enough in constant time.
  */
 
 static const size_t ALIGN       = sizeof(HeapArea);
+// areas below SMALL_BINS * ALIGN bytes have a list per size
+static const size_t SMALL_BINS  = 32;
+static const size_t SMALL_LOG   = 5;
+static const size_t BINS        = 64;
+
+static_assert((1 << SMALL_LOG) == SMALL_BINS, "SMALL_LOG is wrong");
 
 static heap_alloc_func alloc_callback;
 static heap_free_func free_callback;
@@ -41,9 +64,16 @@ static heap_dblfree_func dblfree_callback;
 HeapArea *heap_begin;
 HeapArea *heap_end;
 
+static HeapArea *bins[BINS];
+static uint64_t bin_map;
+static HeapStats stats;
+
 static bool is_used(HeapArea *a) {
     return a->next & HEAP_USED_BITS;
 }
+static size_t area_size(HeapArea *a) {
+    return a->next & ~HEAP_USED_BITS;
+}
 static HeapArea *forward(HeapArea *a, size_t size) {
     return reinterpret_cast<HeapArea*>(reinterpret_cast<uintptr_t>(a) + size);
 }
@@ -51,6 +81,101 @@ static HeapArea *backwards(HeapArea *a, size_t size) {
     return reinterpret_cast<HeapArea*>(reinterpret_cast<uintptr_t>(a) - size);
 }
 
+static size_t bin_of(size_t size) {
+    size_t units = size / ALIGN;
+    if(units < SMALL_BINS)
+        return units;
+    size_t log = sizeof(unsigned long) * 8 - 1 - static_cast<size_t>(__builtin_clzl(units));
+    size_t bin = SMALL_BINS + log - SMALL_LOG;
+    return bin < BINS ? bin : BINS - 1;
+}
+
+static void insert_free(HeapArea *a) {
+    size_t bin = bin_of(a->next);
+    a->fprev = nullptr;
+    a->fnext = bins[bin];
+    if(a->fnext)
+        a->fnext->fprev = a;
+    bins[bin] = a;
+    bin_map |= static_cast<uint64_t>(1) << bin;
+    stats.free += a->next;
+    stats.free_areas++;
+}
+
+static void remove_free(HeapArea *a) {
+    size_t bin = bin_of(a->next);
+    if(a->fprev)
+        a->fprev->fnext = a->fnext;
+    else
+        bins[bin] = a->fnext;
+    if(a->fnext)
+        a->fnext->fprev = a->fprev;
+    if(!bins[bin])
+        bin_map &= ~(static_cast<uint64_t>(1) << bin);
+    stats.free -= a->next;
+    stats.free_areas--;
+}
+
+static HeapArea *find_fit(size_t size) {
+    size_t bin = bin_of(size);
+    // the small lists contain only areas of exactly this size
+    if(bin < SMALL_BINS && bins[bin])
+        return bins[bin];
+
+    // the first area of all larger lists is large enough
+    uint64_t larger = bin + 1 < BINS ? bin_map & (~static_cast<uint64_t>(0) << (bin + 1)) : 0;
+    if(larger)
+        return bins[__builtin_ctzll(larger)];
+
+    // the large lists cover a range of sizes, so that we might find a fitting one in there
+    if(bin >= SMALL_BINS) {
+        for(HeapArea *a = bins[bin]; a; a = a->fnext) {
+            if(a->next >= size)
+                return a;
+        }
+    }
+    return nullptr;
+}
+
+// splits the unused area <a> behind <size> bytes, if there is enough space left
+static void split(HeapArea *a, size_t size) {
+    // take care that we need space for an area behind it and that it actually makes sense to have
+    // this free, i.e. that it's >= the minimum size
+    if(a->next < size + ALIGN)
+        return;
+
+    HeapArea *n = forward(a, size);
+    n->next = a->next - size;
+    n->prev = size;
+    a->next = size;
+
+    // when shrinking an area, the next one might be free
+    HeapArea *nn = forward(n, n->next);
+    if(nn < heap_end && !is_used(nn)) {
+        remove_free(nn);
+        n->next += nn->next;
+        nn = forward(n, n->next);
+    }
+    nn->prev = n->next;
+    insert_free(n);
+}
+
+USED void heap_init(uintptr_t begin, uintptr_t end) {
+    heap_begin = reinterpret_cast<HeapArea*>(begin);
+    heap_end = reinterpret_cast<HeapArea*>(end) - 1;
+
+    heap_end->next = 0;
+    heap_end->prev = static_cast<size_t>(heap_end - heap_begin) * sizeof(HeapArea);
+    heap_begin->next = heap_end->prev;
+    heap_begin->prev = 0;
+
+    for(size_t i = 0; i < BINS; ++i)
+        bins[i] = nullptr;
+    bin_map = 0;
+    stats = HeapStats();
+    insert_free(heap_begin);
+}
+
 USED void heap_set_alloc_callback(heap_alloc_func callback) {
     alloc_callback = callback;
 }
@@ -64,48 +189,31 @@ USED void heap_set_dblfree_callback(heap_dblfree_func callback) {
     dblfree_callback = callback;
 }
 
-USED void *heap_alloc(size_t size) {
+static size_t round_size(size_t size) {
     static_assert(ALIGN >= DTU_PKG_SIZE, "ALIGN is wrong");
-    // assert(size < HEAP_USED_BITS);
-
     // align it to at least word-size (the fortran-runtime seems to expect that). 8 is even better
     // because the DTU requires that.
-    size = (size + sizeof(HeapArea) + ALIGN - 1) & ~(ALIGN - 1);
-
-    // find free area with enough space; start at the end, i.e. the large chunk of free memory
-    HeapArea *a = nullptr;
-    while(1) {
-        a = backwards(heap_end, heap_end->prev);
-        do {
-            if(!is_used(a) && a->next >= size)
-                break;
-            a = backwards(a, a->prev);
-        }
-        while(a->prev > 0);
+    return (size + sizeof(HeapArea) + ALIGN - 1) & ~(ALIGN - 1);
+}
 
-        // have we found a suitable area?
-        if(!is_used(a) && a->next >= size)
-            break;
+static void *do_alloc(size_t size) {
+    // assert(size < HEAP_USED_BITS);
+    size = round_size(size);
 
+    // find free area with enough space
+    HeapArea *a;
+    while((a = find_fit(size)) == nullptr) {
         // ok, try to extend the heap
         if(!oom_callback || !oom_callback(size))
             return nullptr;
     }
 
-    // is there space left? (take care that we need space for an area behind it and that it actually
-    // makes sense to have this free, i.e. that it's >= the minimum size)
-    if(a->next >= size + ALIGN) {
-        // put a new area behind us
-        HeapArea *n = forward(a, size);
-        n->next = a->next - size;
-        n->prev = static_cast<word_t>(n - a) * sizeof(HeapArea);
-        // adjust prev of next area, if there is any
-        HeapArea *nn = forward(n, n->next);
-        nn->prev = static_cast<word_t>(nn - n) * sizeof(HeapArea);
-        a->next = size;
-    }
+    remove_free(a);
+    split(a, size);
 
     // mark used
+    stats.allocs++;
+    stats.used += a->next;
     a->next |= HEAP_USED_BITS;
 
     if(alloc_callback)
@@ -114,6 +222,13 @@ USED void *heap_alloc(size_t size) {
     return a + 1;
 }
 
+USED void *heap_alloc(size_t size) {
+    LOCK();
+    void *res = do_alloc(size);
+    UNLOCK();
+    return res;
+}
+
 USED void *heap_calloc(size_t n, size_t size) {
     void *ptr = heap_alloc(n * size);
     if(ptr)
@@ -121,25 +236,51 @@ USED void *heap_calloc(size_t n, size_t size) {
     return ptr;
 }
 
+static bool do_resize(HeapArea *a, size_t size) {
+    size_t old = area_size(a);
+    HeapArea *n = forward(a, old);
+    if(size > old) {
+        // we can only grow in place if the following area is free and large enough
+        if(n >= heap_end || is_used(n) || old + n->next < size)
+            return false;
+        remove_free(n);
+        a->next += n->next;
+        forward(a, area_size(a))->prev = area_size(a);
+        stats.grown++;
+    }
+
+    // give the remaining space back
+    a->next &= ~HEAP_USED_BITS;
+    split(a, size);
+    stats.used = stats.used - old + a->next;
+    a->next |= HEAP_USED_BITS;
+    return true;
+}
+
 USED void *heap_realloc(void *p, size_t size) {
     if(!p)
         return heap_alloc(size);
 
+    HeapArea *a = backwards(reinterpret_cast<HeapArea*>(p), sizeof(HeapArea));
+    LOCK();
+    bool inplace = is_used(a) && do_resize(a, round_size(size));
+    UNLOCK();
+    if(inplace)
+        return p;
+
     /* allocate new area with requested size */
     void *newp = heap_alloc(size);
 
     /* copy old content over and free old area */
     if(newp) {
-        HeapArea *a = backwards(reinterpret_cast<HeapArea*>(p), sizeof(HeapArea));
-        memcpy(newp, p, (a->next & ~HEAP_USED_BITS) - sizeof(HeapArea));
+        size_t old = area_size(a) - sizeof(HeapArea);
+        memcpy(newp, p, old < size ? old : size);
         heap_free(p);
     }
     return newp;
 }
 
-USED void heap_free(void *p) {
-    if(p == nullptr)
-        return;
+static void do_free(void *p) {
 
     if(free_callback)
         free_callback(p);
@@ -152,12 +293,15 @@ USED void heap_free(void *p) {
         return;
     }
     a->next &= ~HEAP_USED_BITS;
+    stats.frees++;
+    stats.used -= a->next;
     HeapArea *n = forward(a, a->next);
 
     if(a->prev) {
         HeapArea *p = backwards(a, a->prev);
         // is prev already free? then merge it
         if(!is_used(p)) {
+            remove_free(p);
             p->next += a->next;
             // adjust prev of next area
             n->prev = p->next;
@@ -168,12 +312,24 @@ USED void heap_free(void *p) {
 
     // is there a next one and is it free?
     if(n < heap_end && !is_used(n)) {
+        remove_free(n);
         HeapArea *nn = forward(n, n->next);
         // so merge it
         a->next += n->next;
         // adjust prev of next area
         nn->prev = a->next;
     }
+
+    insert_free(a);
+}
+
+USED void heap_free(void *p) {
+    if(p == nullptr)
+        return;
+
+    LOCK();
+    do_free(p);
+    UNLOCK();
 }
 
 void heap_append(size_t pages) {
@@ -188,24 +344,20 @@ void heap_append(size_t pages) {
     if(is_used(prev)) {
         end->prev = static_cast<size_t>(end - heap_end) * sizeof(HeapArea);
         heap_end->next = end->prev;
+        insert_free(heap_end);
     }
     // otherwise, merge it into the last area
     else {
+        remove_free(prev);
         end->prev = heap_end->prev + size;
         prev->next += size;
+        insert_free(prev);
     }
     heap_end = end;
 }
 
 size_t heap_free_memory() {
-    size_t total = 0;
-    HeapArea *a = heap_begin;
-    while(a < heap_end) {
-        if(!is_used(a))
-            total += a->next;
-        a = forward(a, a->next & ~HEAP_USED_BITS);
-    }
-    return total;
+    return stats.free;
 }
 
 uintptr_t heap_used_end() {
@@ -220,3 +372,16 @@ uintptr_t heap_used_end() {
         return reinterpret_cast<uintptr_t>(heap_begin + 1);
     return reinterpret_cast<uintptr_t>(forward(last, last->next & ~HEAP_USED_BITS) + 1);
 }
+
+void heap_stats(HeapStats *res) {
+    LOCK();
+    *res = stats;
+    // the largest area is in the last non-empty list
+    res->largest = 0;
+    if(bin_map) {
+        size_t bin = 63 - static_cast<size_t>(__builtin_clzll(bin_map));
+        for(HeapArea *a = bins[bin]; a; a = a->fnext)
+            res->largest = a->next > res->largest ? a->next : res->largest;
+    }
+    UNLOCK();
+}
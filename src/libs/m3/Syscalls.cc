@@ -375,6 +375,148 @@ Errors::Code Syscalls::noop() {
     return send_receive_result(&req, sizeof(req));
 }
 
+Errors::Code Syscalls::batch(Batch &b, bool cont) {
+    LLOG(SYSC, "batch(count=" << b._count << ", cont=" << cont << ")");
+
+    b._executed = 0;
+    if(b._overflow)
+        return Errors::last = Errors::NO_SPACE;
+    if(b._count == 0)
+        return Errors::NONE;
+
+    KIF::Syscall::Batch req;
+    req.opcode = KIF::Syscall::BATCH;
+    req.flags = cont ? KIF::Syscall::Batch::CONTINUE : 0;
+    req.count = b._count;
+    memcpy(req.msgs, b._msgs, b._size * sizeof(xfer_t));
+
+    size_t msgsize = sizeof(req) - sizeof(req.msgs) + b._size * sizeof(xfer_t);
+    DTU::Message *msg = send_receive(&req, msgsize);
+    auto *reply = reinterpret_cast<KIF::Syscall::BatchReply*>(msg->data);
+
+    Errors::last = static_cast<Errors::Code>(reply->error);
+    if(reply->count <= b._count) {
+        b._executed = reply->count;
+        memcpy(b._errors, reply->errors, b._executed * sizeof(xfer_t));
+    }
+
+    DTU::get().mark_read(m3::DTU::SYSC_REP, reinterpret_cast<size_t>(reply));
+    return Errors::last;
+}
+
+Syscalls::Batch &Syscalls::Batch::append(const void *req, size_t size) {
+    size_t words = (size + sizeof(xfer_t) - 1) / sizeof(xfer_t);
+    if(_overflow || _count == KIF::Syscall::MAX_BATCH || _size + 1 + words > ARRAY_SIZE(_msgs)) {
+        _overflow = true;
+        return *this;
+    }
+
+    _msgs[_size] = size;
+    memcpy(_msgs + _size + 1, req, size);
+    _size += 1 + words;
+    _count++;
+    return *this;
+}
+
+Syscalls::Batch &Syscalls::Batch::createsess(capsel_t dst, capsel_t srv, word_t ident) {
+    KIF::Syscall::CreateSess req;
+    req.opcode = KIF::Syscall::CREATE_SESS;
+    req.dst_sel = dst;
+    req.srv_sel = srv;
+    req.ident = ident;
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::creatergate(capsel_t dst, int order, int msgorder) {
+    KIF::Syscall::CreateRGate req;
+    req.opcode = KIF::Syscall::CREATE_RGATE;
+    req.dst_sel = dst;
+    req.order = static_cast<xfer_t>(order);
+    req.msgorder = static_cast<xfer_t>(msgorder);
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::createsgate(capsel_t dst, capsel_t rgate, label_t label,
+                                              word_t credits) {
+    KIF::Syscall::CreateSGate req;
+    req.opcode = KIF::Syscall::CREATE_SGATE;
+    req.dst_sel = dst;
+    req.rgate_sel = rgate;
+    req.label = label;
+    req.credits = credits;
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::createmgate(capsel_t dst, goff_t addr, size_t size, int perms) {
+    KIF::Syscall::CreateMGate req;
+    req.opcode = KIF::Syscall::CREATE_MGATE;
+    req.dst_sel = dst;
+    req.addr = addr;
+    req.size = size;
+    req.perms = static_cast<xfer_t>(perms);
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::createmap(capsel_t dst, capsel_t vpe, capsel_t mgate,
+                                            capsel_t first, capsel_t pages, int perms) {
+    KIF::Syscall::CreateMap req;
+    req.opcode = KIF::Syscall::CREATE_MAP;
+    req.dst_sel = dst;
+    req.vpe_sel = vpe;
+    req.mgate_sel = mgate;
+    req.first = first;
+    req.pages = pages;
+    req.perms = static_cast<xfer_t>(perms);
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::activate(capsel_t ep, capsel_t gate, goff_t addr) {
+    KIF::Syscall::Activate req;
+    req.opcode = KIF::Syscall::ACTIVATE;
+    req.ep_sel = ep;
+    req.gate_sel = gate;
+    req.addr = addr;
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::derivemem(capsel_t dst, capsel_t src, goff_t offset,
+                                            size_t size, int perms) {
+    KIF::Syscall::DeriveMem req;
+    req.opcode = KIF::Syscall::DERIVE_MEM;
+    req.dst_sel = dst;
+    req.src_sel = src;
+    req.offset = offset;
+    req.size = size;
+    req.perms = static_cast<xfer_t>(perms);
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::exchange(capsel_t vpe, const KIF::CapRngDesc &own,
+                                           capsel_t other, bool obtain) {
+    KIF::Syscall::Exchange req;
+    req.opcode = KIF::Syscall::EXCHANGE;
+    req.vpe_sel = vpe;
+    req.own_crd = own.value();
+    req.other_sel = other;
+    req.obtain = obtain;
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::revoke(capsel_t vpe, const KIF::CapRngDesc &crd, bool own) {
+    KIF::Syscall::Revoke req;
+    req.opcode = KIF::Syscall::REVOKE;
+    req.vpe_sel = vpe;
+    req.crd = crd.value();
+    req.own = own;
+    return append(&req, sizeof(req));
+}
+
+Syscalls::Batch &Syscalls::Batch::noop() {
+    KIF::Syscall::Noop req;
+    req.opcode = KIF::Syscall::NOOP;
+    return append(&req, sizeof(req));
+}
+
 // the USED seems to be necessary, because the libc calls it and LTO removes it otherwise
 USED void Syscalls::exit(int exitcode) {
     LLOG(SYSC, "exit(code=" << exitcode << ")");
@@ -178,11 +178,20 @@ Errors::Code VPE::exec(int argc, const char **argv) {
 
 void VPE::clear_mem(char *buffer, size_t count, uintptr_t dest) {
     memset(buffer, 0, BUF_SIZE);
+
+    // write the zeroed buffer to multiple destinations at once
+    IOVec vecs[8];
     while(count > 0) {
-        size_t amount = std::min(count, BUF_SIZE);
-        _mem.write(buffer, Math::round_up(amount, DTU_PKG_SIZE), dest);
-        count -= amount;
-        dest += amount;
+        size_t num;
+        for(num = 0; num < ARRAY_SIZE(vecs) && count > 0; ++num) {
+            size_t amount = std::min(count, BUF_SIZE);
+            vecs[num].data = buffer;
+            vecs[num].len = Math::round_up(amount, DTU_PKG_SIZE);
+            vecs[num].offset = dest;
+            count -= amount;
+            dest += amount;
+        }
+        _mem.writev(vecs, num);
     }
 }
 
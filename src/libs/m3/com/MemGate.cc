@@ -105,4 +105,88 @@ retry:
     return res;
 }
 
+Errors::Code MemGate::writev(const IOVec *vecs, size_t count) {
+#if defined(__host__)
+    EVENT_TRACER_write();
+    ensure_activated();
+
+    return DTU::get().writev(ep(), vecs, count, _cmdflags);
+#else
+    for(size_t i = 0; i < count; ++i) {
+        Errors::Code res = write(vecs[i].data, vecs[i].len, vecs[i].offset);
+        if(res != Errors::NONE)
+            return res;
+    }
+    return Errors::NONE;
+#endif
+}
+
+Errors::Code MemGate::readv(const IOVec *vecs, size_t count) {
+#if defined(__host__)
+    EVENT_TRACER_read();
+    ensure_activated();
+
+    return DTU::get().readv(ep(), vecs, count, _cmdflags);
+#else
+    for(size_t i = 0; i < count; ++i) {
+        Errors::Code res = read(vecs[i].data, vecs[i].len, vecs[i].offset);
+        if(res != Errors::NONE)
+            return res;
+    }
+    return Errors::NONE;
+#endif
+}
+
+Errors::Code MemGate::write_async(const void *data, size_t len, goff_t offset, Ticket &ticket) {
+    // writes are finished as soon as the DTU has sent them
+    ticket._slot = DTU::NO_SLOT;
+    ticket._res = write(data, len, offset);
+    return ticket._res;
+}
+
+Errors::Code MemGate::read_async(void *data, size_t len, goff_t offset, Ticket &ticket) {
+    ticket._slot = DTU::NO_SLOT;
+#if defined(__host__)
+    EVENT_TRACER_read();
+    ensure_activated();
+
+    ticket._res = DTU::get().read_async(ep(), data, len, offset, _cmdflags, &ticket._slot);
+#else
+    ticket._res = read(data, len, offset);
+#endif
+    return ticket._res;
+}
+
+#if defined(__host__)
+bool MemGate::is_done(const Ticket &ticket) {
+    if(ticket._slot != DTU::NO_SLOT)
+        return DTU::get().is_done(ticket._slot);
+    return true;
+}
+#else
+bool MemGate::is_done(UNUSED const Ticket &ticket) {
+    return true;
+}
+#endif
+
+Errors::Code MemGate::wait(Ticket &ticket) {
+#if defined(__host__)
+    if(ticket._slot != DTU::NO_SLOT) {
+        ticket._res = DTU::get().wait_for(ticket._slot);
+        ticket._slot = DTU::NO_SLOT;
+    }
+#endif
+    return ticket._res;
+}
+
+Errors::Code MemGate::wait_all(Ticket *tickets, size_t count) {
+    Errors::Code res = Errors::NONE;
+    for(size_t i = 0; i < count; ++i) {
+        Errors::Code tres = wait(tickets[i]);
+        if(res == Errors::NONE)
+            res = tres;
+    }
+    return res;
+}
+
 }
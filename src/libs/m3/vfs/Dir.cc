@@ -19,24 +19,30 @@
 namespace m3 {
 
 bool Dir::readdir(Entry &e) {
-    // read header
-    DirEntry fse;
-    if(_f.read(&fse, sizeof(fse)) != sizeof(fse))
-        return false;
-
-    // read name
-    e.nodeno = fse.nodeno;
-    if(_f.read(e.name, fse.namelen) != fse.namelen)
-        return false;
-
-    // 0-termination
-    e.name[fse.namelen < Entry::MAX_NAME_LEN ? fse.namelen : Entry::MAX_NAME_LEN - 1] = '\0';
-
-    // move to next entry
-    size_t off = fse.next - (sizeof(fse) + fse.namelen);
-    if(off != 0)
-        _f.seek(off, M3FS_SEEK_CUR);
-    return true;
+    while(true) {
+        DirEntry fse;
+
+        // read header
+        if(_f.read(&fse, sizeof(fse)) != sizeof(fse))
+            return false;
+
+        // read name
+        e.nodeno = fse.nodeno;
+        if(_f.read(e.name, fse.namelen) != fse.namelen)
+            return false;
+
+        // 0-termination
+        e.name[fse.namelen < Entry::MAX_NAME_LEN ? fse.namelen : Entry::MAX_NAME_LEN - 1] = '\0';
+
+        // move to next entry
+        size_t off = fse.next - (sizeof(fse) + fse.namelen);
+        if(off != 0)
+            _f.seek(off, M3FS_SEEK_CUR);
+
+        // entries without name mark empty blocks
+        if(fse.namelen > 0)
+            return true;
+    }
 }
 
 }
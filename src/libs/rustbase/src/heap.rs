@@ -28,6 +28,7 @@ const HEAP_USED_BITS: usize = 0x5 << (8 * util::size_of::<usize>() - 3);
 pub struct HeapArea {
     pub next: usize,    /* HEAP_USED_BITS set = used */
     pub prev: usize,
+    /* the free list links of the C implementation follow here */
     _pad: [u8; 64 - util::size_of::<usize>() * 2],
 }
 
@@ -46,6 +47,8 @@ impl HeapArea {
 }
 
 extern {
+    fn heap_init(begin: usize, end: usize);
+
     fn heap_set_alloc_callback(cb: extern fn(p: *const u8, size: usize));
     fn heap_set_free_callback(cb: extern fn(p: *const u8));
     fn heap_set_oom_callback(cb: extern fn(size: usize) -> bool);
@@ -79,13 +82,12 @@ extern {
 }
 
 #[cfg(target_os = "none")]
-fn init_heap() {
+fn init_heap() -> (usize, usize) {
     use arch;
     use kif::PEDesc;
 
     unsafe {
         let begin = &_bss_end as *const u8;
-        heap_begin = util::round_up(begin as usize, util::size_of::<HeapArea>()) as *mut HeapArea;
 
         let env = arch::envdata::get();
         let end = if env.heap_size == 0 {
@@ -98,12 +100,12 @@ fn init_heap() {
             util::round_up(begin as usize, cfg::PAGE_SIZE) + env.heap_size as usize
         };
 
-        heap_end = (end as *mut HeapArea).offset(-1);
+        (util::round_up(begin as usize, util::size_of::<HeapArea>()), end)
     }
 }
 
 #[cfg(target_os = "linux")]
-fn init_heap() {
+fn init_heap() -> (usize, usize) {
     use core::ptr;
 
     unsafe {
@@ -116,25 +118,17 @@ fn init_heap() {
             0
         );
         assert!(addr != libc::MAP_FAILED);
-        heap_begin = addr as *mut HeapArea;
-        heap_end = ((addr as usize + cfg::APP_HEAP_SIZE) as *mut HeapArea).offset(-1);
+        (addr as usize, addr as usize + cfg::APP_HEAP_SIZE)
     }
 }
 
 pub fn init() {
-    init_heap();
+    let (begin, end) = init_heap();
 
     unsafe {
-        let num_areas = heap_end.offset_from(heap_begin) as isize;
-        let space = num_areas * util::size_of::<HeapArea>() as isize;
-
-        log!(HEAP, "Heap has {} bytes", space);
-
-        (*heap_end).next = 0;
-        (*heap_end).prev = space as usize;
+        heap_init(begin, end);
 
-        (*heap_begin).next = space as usize;
-        (*heap_begin).prev = 0;
+        log!(HEAP, "Heap has {} bytes", (*heap_begin).next);
 
         if io::log::HEAP {
             heap_set_alloc_callback(heap_alloc_callback);
@@ -59,30 +59,35 @@ impl iter::Iterator for ReadDir {
             next: u32,
         }
 
-        // read header
-        let entry: M3FSDirEntry = match read_object(&mut self.reader) {
-            Ok(obj) => obj,
-            Err(_)  => return None,
-        };
-
-        // read name
-        let res = DirEntry::new(
-            entry.inode,
-            match self.reader.read_string(entry.name_len as usize) {
-                Ok(s)   => s,
+        loop {
+            // read header
+            let entry: M3FSDirEntry = match read_object(&mut self.reader) {
+                Ok(obj) => obj,
                 Err(_)  => return None,
-            },
-        );
+            };
+
+            // read name
+            let res = DirEntry::new(
+                entry.inode,
+                match self.reader.read_string(entry.name_len as usize) {
+                    Ok(s)   => s,
+                    Err(_)  => return None,
+                },
+            );
 
-        // move to next entry
-        let off = entry.next as usize - (util::size_of::<M3FSDirEntry>() + entry.name_len as usize);
-        if off != 0 {
-            if self.reader.seek(off, SeekMode::CUR).is_err() {
-                return None
+            // move to next entry
+            let off = entry.next as usize - (util::size_of::<M3FSDirEntry>() + entry.name_len as usize);
+            if off != 0 {
+                if self.reader.seek(off, SeekMode::CUR).is_err() {
+                    return None
+                }
             }
-        }
 
-        Some(res)
+            // entries without name mark empty blocks
+            if entry.name_len > 0 {
+                return Some(res)
+            }
+        }
     }
 }
 
@@ -47,7 +47,7 @@ static void export_rec(const char *dest, m3::inodeno_t dirno, const char *src) {
             m3::DirEntry *end = reinterpret_cast<m3::DirEntry*>(buffer + sb.blocksize);
             m3::DirEntry *e = begin;
             while(e >= begin && e < end && e->next > 0) {
-                if(e->name + e->namelen <= reinterpret_cast<char*>(end)) {
+                if(e->namelen > 0 && e->name + e->namelen <= reinterpret_cast<char*>(end)) {
                     if((e->namelen != 1 || strncmp(e->name, ".", 1) != 0) &&
                         (e->namelen != 2 || strncmp(e->name, "..", 2) != 0)) {
                         char epath[128];
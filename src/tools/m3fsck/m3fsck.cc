@@ -36,6 +36,73 @@ static void set_block(m3::Bitmap &blocks, m3::blockno_t no) {
     blocks.set(no);
 }
 
+static void check_dir_index(m3::inodeno_t ino, const m3::INode &inode, uint32_t block_count) {
+    char *buffer = new char[sb.blocksize];
+    read_from_block(buffer, sb.blocksize, get_block_no(inode, 0));
+
+    m3::DirEntry *dot = reinterpret_cast<m3::DirEntry*>(buffer);
+    m3::DirEntry *dotdot = reinterpret_cast<m3::DirEntry*>(buffer + sizeof(m3::DirEntry) + 1);
+    if(dot->namelen != 1 || dot->next != sizeof(m3::DirEntry) + 1 || dot->name[0] != '.' ||
+       dotdot->namelen != 2 || strncmp(dotdot->name, "..", 2) != 0 ||
+       dotdot->next != sb.blocksize - (sizeof(m3::DirEntry) + 1))
+        errx(1, "Indexed directory %u does not start with . and .. spanning the first block", ino);
+
+    m3::DirIndex *idx = reinterpret_cast<m3::DirIndex*>(buffer + m3::DirIndex::OFFSET);
+    if(idx->magic != m3::DirIndex::MAGIC)
+        errx(1, "Directory %u is marked as indexed, but has no index", ino);
+    if(idx->depth > m3::DirIndex::max_depth(sb.blocksize))
+        errx(1, "Index of directory %u has an invalid depth of %u", ino, idx->depth);
+
+    m3::DirIndex *index = reinterpret_cast<m3::DirIndex*>(
+        new char[sizeof(m3::DirIndex) + idx->slots() * sizeof(m3::blockno_t)]);
+    memcpy(index, idx, sizeof(m3::DirIndex) + idx->slots() * sizeof(m3::blockno_t));
+
+    // all blocks but the first are buckets and all slots of a bucket agree in the lowest bits
+    for(uint32_t i = 1; i < block_count; ++i) {
+        m3::blockno_t block = get_block_no(inode, i);
+        size_t refs = 0, first = 0;
+        for(size_t s = 0; s < index->slots(); ++s) {
+            if(index->buckets[s] == block) {
+                if(refs++ == 0)
+                    first = s;
+            }
+        }
+        if(refs == 0 || (refs & (refs - 1)) != 0)
+            errx(1, "Block %u of directory %u has %zu slots in the index", block, ino, refs);
+
+        size_t bits = index->depth;
+        for(size_t r = refs; r > 1; r /= 2)
+            bits--;
+        size_t mask = (static_cast<size_t>(1) << bits) - 1;
+        for(size_t s = 0; s < index->slots(); ++s) {
+            if(index->buckets[s] == block && (s & mask) != (first & mask))
+                errx(1, "Slot %zu of directory %u refers to the wrong bucket %u", s, ino, block);
+        }
+
+        read_from_block(buffer, sb.blocksize, block);
+        m3::DirEntry *e = reinterpret_cast<m3::DirEntry*>(buffer);
+        m3::DirEntry *end = reinterpret_cast<m3::DirEntry*>(buffer + sb.blocksize);
+        while(e->next > 0 && e < end) {
+            if(e->namelen > 0) {
+                size_t slot = index->slot(m3::DirIndex::hash(e->name, e->namelen));
+                if(index->buckets[slot] != block) {
+                    errx(1, "Entry %.*s of directory %u is in block %u instead of %u",
+                            e->namelen, e->name, ino, block, index->buckets[slot]);
+                }
+            }
+            e = reinterpret_cast<m3::DirEntry*>(reinterpret_cast<char*>(e) + e->next);
+        }
+    }
+
+    for(size_t s = 0; s < index->slots(); ++s) {
+        if(index->buckets[s] == get_block_no(inode, 0))
+            errx(1, "Slot %zu of directory %u refers to the first block", s, ino);
+    }
+
+    delete[] reinterpret_cast<char*>(index);
+    delete[] buffer;
+}
+
 static void collect_blocks_and_inodes(m3::inodeno_t ino, m3::Bitmap &blocks, m3::Bitmap &inodes) {
     if(inodes.is_set(ino))
         return;
@@ -64,13 +131,17 @@ static void collect_blocks_and_inodes(m3::inodeno_t ino, m3::Bitmap &blocks, m3:
             m3::DirEntry *end = reinterpret_cast<m3::DirEntry*>(buffer + sb.blocksize);
             // actually next is not allowed to be 0. but to prevent endless looping here...
             while(e->next > 0 && e < end) {
-                if(!(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
+                if(e->namelen != 0 &&
+                    !(e->namelen == 1 && strncmp(e->name, ".", 1) == 0) &&
                     !(e->namelen == 2 && strncmp(e->name, "..", 2) == 0))
                     collect_blocks_and_inodes(e->nodeno, blocks, inodes);
                 e = reinterpret_cast<m3::DirEntry*>(reinterpret_cast<char*>(e) + e->next);
             }
         }
         delete[] buffer;
+
+        if(inode.flags & m3::INODE_INDEXED)
+            check_dir_index(ino, inode, block_count);
     }
     else {
         for(uint32_t i = 0; i < block_count; ++i) {
@@ -156,18 +227,88 @@ static void check_bitmap(const char *name, const m3::Bitmap &used, uint32_t tota
     compare_bitmaps(name, used, bm, total);
 }
 
+static void check_journal(bool replay) {
+    if(sb.journal_blocks == 0)
+        return;
+
+    size_t capacity = m3::JournalHeader::capacity(sb);
+    if(capacity == 0)
+        errx(1, "Journal with %u blocks is too small", sb.journal_blocks);
+    size_t copies = m3::JournalHeader::header_blocks(sb, capacity) * sb.blocksize;
+
+    size_t slotsize = sb.journal_slot_blocks() * sb.blocksize;
+    char *slots[2];
+    m3::JournalHeader *valid[2] = {nullptr, nullptr};
+    for(uint s = 0; s < 2; ++s) {
+        slots[s] = new char[slotsize];
+        read_from_block(slots[s], slotsize, sb.first_journal_block() + s * sb.journal_slot_blocks());
+
+        m3::JournalHeader *hd = reinterpret_cast<m3::JournalHeader*>(slots[s]);
+        if(hd->magic != m3::JournalHeader::MAGIC)
+            continue;
+        if(hd->count > capacity)
+            errx(1, "Journal slot %u has %u blocks, but only %zu fit", s, hd->count, capacity);
+        // an incomplete transaction has not been committed and is ignored
+        if(hd->checksum != hd->get_checksum(slots[s] + copies, sb.blocksize)) {
+            fprintf(stderr, "Warning: journal slot %u contains an incomplete transaction\n", s);
+            continue;
+        }
+        for(uint32_t i = 0; i < hd->count; ++i) {
+            if(hd->blocks[i] == 0 || hd->blocks[i] >= sb.total_blocks ||
+               (hd->blocks[i] >= sb.first_journal_block() && hd->blocks[i] < sb.first_data_block())) {
+                errx(1, "Journal slot %u contains block %u, which is invalid",
+                        s, hd->blocks[i]);
+            }
+        }
+        valid[s] = hd;
+    }
+
+    if(valid[0] || valid[1]) {
+        if(!replay)
+            errx(1, "Journal contains committed transactions; use -r to replay them");
+
+        // replay the older transaction first
+        uint first = (valid[0] && valid[1] && valid[1]->seq < valid[0]->seq) ? 1 : 0;
+        for(uint j = 0; j < 2; ++j) {
+            uint s = (first + j) % 2;
+            if(!valid[s])
+                continue;
+            printf("Replaying transaction %u with %u blocks\n", valid[s]->seq, valid[s]->count);
+            for(uint32_t i = 0; i < valid[s]->count; ++i) {
+                write_to_block(slots[s] + copies + i * sb.blocksize, sb.blocksize,
+                               valid[s]->blocks[i]);
+            }
+            sb = valid[s]->sb;
+        }
+
+        sb.checksum = sb.get_checksum();
+        write_to_block(&sb, sizeof(sb), 0);
+
+        // the journal is empty afterwards
+        memset(slots[0], 0, sb.blocksize);
+        for(uint s = 0; s < 2; ++s)
+            write_to_block(slots[0], sb.blocksize, sb.first_journal_block() + s * sb.journal_slot_blocks());
+    }
+
+    delete[] slots[0];
+    delete[] slots[1];
+}
+
 static void usage(const char *name) {
-    fprintf(stderr, "Usage: %s <image>\n", name);
+    fprintf(stderr, "Usage: %s [-r] <image>\n", name);
+    fprintf(stderr, "  -r: replay the journal, if necessary\n");
     exit(EXIT_FAILURE);
 }
 
 int main(int argc, char **argv) {
-    if(argc != 2)
+    bool replay = argc == 3 && strcmp(argv[1], "-r") == 0;
+    if(argc != 2 && !replay)
         usage(argv[0]);
 
-    file = fopen(argv[1], "r");
+    const char *image = argv[argc - 1];
+    file = fopen(image, replay ? "r+" : "r");
     if(!file)
-        err(1, "Unable to open %s for reading", argv[1]);
+        err(1, "Unable to open %s for %s", image, replay ? "reading and writing" : "reading");
 
     fread(&sb, sizeof(sb), 1, file);
 
@@ -188,10 +329,16 @@ int main(int argc, char **argv) {
     if(sb.free_inodes > sb.total_inodes)
         errx(1, "Free inodes is larger than total inodes");
 
+    if(sb.first_data_block() > sb.total_blocks)
+        errx(1, "Metadata and journal do not fit into the total blocks");
+
+    // the bitmaps and inodes are only consistent after the journal has been replayed
+    check_journal(replay);
+
     m3::Bitmap blocks(sb.total_blocks);
     m3::Bitmap inodes(sb.total_inodes);
 
-    // mark superblock, inode-bitmap and block-bitmap used
+    // mark superblock, inode-bitmap, block-bitmap, inodes and journal used
     for(m3::blockno_t bno = 0; bno < sb.first_data_block(); ++bno)
         blocks.set(bno);
 
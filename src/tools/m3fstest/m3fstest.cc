@@ -0,0 +1,461 @@
+/*
+ * Copyright (C) 2018, Nils Asmussen <nils@os.inf.tu-dresden.de>
+ * Economic rights: Technische Universitaet Dresden (Germany)
+ *
+ * This file is part of M3 (Microkernel-based SysteM for Heterogeneous Manycores).
+ *
+ * M3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * M3 is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License version 2 for more details.
+ */
+
+/*
+ * tests for the parts of m3fs that can run on the host without M3, i.e., on an image in memory
+ */
+
+#include <base/Common.h>
+
+#include <fs/internal.h>
+
+#include <err.h>
+
+#include "backend/Backend.h"
+#include "data/FreeExtents.h"
+#include "Journal.h"
+
+FILE *file;
+m3::SuperBlock sb;
+
+// a backend that only supports the metadata and journal accesses on an image in memory
+class ImageBackend : public Backend {
+public:
+    explicit ImageBackend(const m3::SuperBlock &sb)
+        : journal_writes(),
+          _sb(sb),
+          _image(new char[sb.total_blocks * sb.blocksize]()) {
+    }
+    ~ImageBackend() {
+        delete[] _image;
+    }
+
+    char *block(m3::blockno_t bno) {
+        return _image + bno * _sb.blocksize;
+    }
+    const m3::SuperBlock &stored_sb() const {
+        return _sb;
+    }
+
+    void load_meta(void *dst, size_t, m3::blockno_t bno, event_t) override {
+        memcpy(dst, block(bno), _sb.blocksize);
+    }
+    void load_data(m3::MemGate &, m3::blockno_t, size_t, bool, event_t) override {
+    }
+
+    void store_meta(const void *src, size_t, m3::blockno_t bno, event_t) override {
+        memcpy(block(bno), src, _sb.blocksize);
+    }
+    void store_meta_blocks(const void *const *srcs, m3::blockno_t bno, size_t blocks) override {
+        for(size_t i = 0; i < blocks; ++i)
+            memcpy(block(static_cast<m3::blockno_t>(bno + i)), srcs[i], _sb.blocksize);
+    }
+    void store_data(m3::blockno_t, m3::blockno_t, size_t, size_t, event_t) override {
+    }
+
+    void sync_meta(Request &, m3::blockno_t) override {
+    }
+
+    void load_journal(void *dst, m3::blockno_t bno, size_t blocks) override {
+        memcpy(dst, block(bno), blocks * _sb.blocksize);
+    }
+    void store_journal(const void *src, m3::blockno_t bno, size_t blocks) override {
+        journal_writes++;
+        memcpy(block(bno), src, blocks * _sb.blocksize);
+    }
+
+    size_t get_filedata(Request &, m3::Extent *, size_t, int, capsel_t, bool, bool,
+                        size_t) override {
+        return 0;
+    }
+    void prefetch_data(FSHandle &, m3::blockno_t, size_t) override {
+    }
+    void clear_extent(Request &, m3::Extent *, size_t) override {
+    }
+
+    void load_sb(m3::SuperBlock &sb) override {
+        sb = _sb;
+    }
+    void store_sb(m3::SuperBlock &sb) override {
+        sb.checksum = sb.get_checksum();
+        _sb = sb;
+    }
+
+    void shutdown() override {
+    }
+
+    size_t journal_writes;
+
+private:
+    m3::SuperBlock _sb;
+    char *_image;
+};
+
+static int failures = 0;
+
+#define CHECK(expr) do {                                                \
+        if(!(expr)) {                                                   \
+            warnx("%s:%d: check '%s' failed", __FILE__, __LINE__, #expr); \
+            failures++;                                                 \
+        }                                                               \
+    } while(0)
+
+static void fill_block(char *buf, char c) {
+    memset(buf, c, sb.blocksize);
+}
+
+static bool block_is(ImageBackend &disk, m3::blockno_t bno, char c) {
+    const char *blk = disk.block(bno);
+    for(size_t i = 0; i < sb.blocksize; ++i) {
+        if(blk[i] != c)
+            return false;
+    }
+    return true;
+}
+
+static void init_sb() {
+    sb.blocksize = 1024;
+    sb.total_inodes = 32;
+    sb.total_blocks = 64;
+    sb.free_inodes = sb.total_inodes;
+    sb.free_blocks = sb.total_blocks;
+    sb.journal_blocks = 8;
+    sb.checksum = sb.get_checksum();
+}
+
+// a crash is simulated by dropping the journal without checkpointing it
+static void journal_replay_twice() {
+    init_sb();
+
+    ImageBackend disk(sb);
+    char *buf = new char[sb.blocksize];
+    m3::blockno_t first = sb.first_data_block();
+
+    {
+        m3::SuperBlock cur = sb;
+        Journal journal(cur, &disk, 1);
+        journal.replay();
+
+        fill_block(buf, 'a');
+        journal.add(first + 0, buf);
+        journal.commit();
+
+        // the first transaction is checkpointed; the second one stays in its slot
+        fill_block(buf, 'b');
+        journal.add(first + 1, buf);
+        cur.free_blocks -= 2;
+        journal.commit();
+    }
+
+    CHECK(block_is(disk, first + 0, 'a'));
+    CHECK(block_is(disk, first + 1, 0));
+
+    {
+        m3::SuperBlock cur = disk.stored_sb();
+        Journal journal(cur, &disk, 1);
+        journal.replay();
+
+        CHECK(block_is(disk, first + 1, 'b'));
+        CHECK(disk.stored_sb().free_blocks == sb.free_blocks - 2);
+
+        // the replayed block is written in place afterwards, e.g., by an eviction
+        fill_block(disk.block(first + 1), 'c');
+
+        fill_block(buf, 'd');
+        journal.add(first + 2, buf);
+        journal.commit();
+    }
+
+    {
+        m3::SuperBlock cur = disk.stored_sb();
+        Journal journal(cur, &disk, 1);
+        journal.replay();
+
+        // the second transaction must not be replayed again
+        CHECK(block_is(disk, first + 0, 'a'));
+        CHECK(block_is(disk, first + 1, 'c'));
+        CHECK(block_is(disk, first + 2, 'd'));
+    }
+
+    delete[] buf;
+}
+
+static void journal_skip_written_back() {
+    init_sb();
+
+    ImageBackend disk(sb);
+    char *buf = new char[sb.blocksize];
+    m3::blockno_t first = sb.first_data_block();
+
+    m3::SuperBlock cur = sb;
+    Journal journal(cur, &disk, 1);
+    journal.replay();
+
+    fill_block(buf, 'a');
+    journal.add(first + 0, buf);
+    journal.commit();
+    CHECK(journal.pending(first + 0));
+
+    // the block is written in place by an eviction; mark it differently to notice another write
+    fill_block(disk.block(first + 0), 'x');
+    journal.written_back(first + 0);
+    CHECK(!journal.pending(first + 0));
+
+    // checkpoints the first transaction
+    fill_block(buf, 'b');
+    journal.add(first + 1, buf);
+    journal.commit();
+
+    CHECK(block_is(disk, first + 0, 'x'));
+
+    journal.checkpoint_all();
+    CHECK(block_is(disk, first + 1, 'b'));
+
+    delete[] buf;
+}
+
+static void journal_checkpoint_runs() {
+    init_sb();
+
+    ImageBackend disk(sb);
+    char *buf = new char[sb.blocksize];
+    m3::blockno_t first = sb.first_data_block();
+
+    m3::SuperBlock cur = sb;
+    Journal journal(cur, &disk, 1);
+    journal.replay();
+
+    // two adjacent blocks and a separate one
+    const m3::blockno_t blocks[] = {first + 0, first + 1, first + 3};
+    for(size_t i = 0; i < ARRAY_SIZE(blocks); ++i) {
+        fill_block(buf, static_cast<char>('a' + i));
+        journal.add(blocks[i], buf);
+    }
+    journal.commit();
+
+    size_t writes = disk.journal_writes;
+    journal.checkpoint_all();
+    // two runs and the headers of both slots
+    CHECK(disk.journal_writes - writes == 2 + 2);
+    CHECK(block_is(disk, first + 0, 'a'));
+    CHECK(block_is(disk, first + 1, 'b'));
+    CHECK(block_is(disk, first + 3, 'c'));
+
+    delete[] buf;
+}
+
+// a transaction with more blocks than fit into one header block is committed atomically
+static void journal_large_transaction() {
+    init_sb();
+    sb.total_blocks = 1024;
+    sb.free_blocks = sb.total_blocks;
+    sb.journal_blocks = 600;
+    sb.checksum = sb.get_checksum();
+
+    const size_t BLOCKS = 280;
+    size_t hdr_blocks = m3::JournalHeader::header_blocks(sb, m3::JournalHeader::capacity(sb));
+    CHECK(hdr_blocks > 1);
+    CHECK(m3::JournalHeader::capacity(sb) >= BLOCKS);
+
+    ImageBackend disk(sb);
+    char *buf = new char[sb.blocksize];
+    m3::blockno_t first = sb.first_data_block();
+
+    {
+        m3::SuperBlock cur = sb;
+        Journal journal(cur, &disk, BLOCKS);
+        CHECK(journal.enabled());
+        journal.replay();
+
+        for(size_t i = 0; i < BLOCKS; ++i) {
+            fill_block(buf, static_cast<char>('a' + i % 26));
+            journal.add(static_cast<m3::blockno_t>(first + i), buf);
+        }
+        journal.commit();
+    }
+
+    // tear the transaction by damaging the copy of the last block
+    m3::blockno_t slot = sb.first_journal_block();
+    size_t last = hdr_blocks + BLOCKS - 1;
+    char saved = disk.block(static_cast<m3::blockno_t>(slot + last))[0];
+    disk.block(static_cast<m3::blockno_t>(slot + last))[0] = 'X';
+
+    {
+        m3::SuperBlock cur = disk.stored_sb();
+        Journal journal(cur, &disk, BLOCKS);
+        journal.replay();
+
+        // a torn transaction must not be replayed, not even partially
+        for(size_t i = 0; i < BLOCKS; ++i)
+            CHECK(block_is(disk, static_cast<m3::blockno_t>(first + i), 0));
+    }
+
+    disk.block(static_cast<m3::blockno_t>(slot + last))[0] = saved;
+
+    {
+        m3::SuperBlock cur = disk.stored_sb();
+        Journal journal(cur, &disk, BLOCKS);
+        journal.replay();
+
+        for(size_t i = 0; i < BLOCKS; ++i) {
+            CHECK(block_is(disk, static_cast<m3::blockno_t>(first + i),
+                           static_cast<char>('a' + i % 26)));
+        }
+    }
+
+    {
+        // too small for the requested transactions; only used for replaying
+        m3::SuperBlock cur = disk.stored_sb();
+        Journal journal(cur, &disk, m3::JournalHeader::capacity(sb) + 1);
+        CHECK(!journal.enabled());
+    }
+
+    delete[] buf;
+}
+
+// determines the number of free ranges in <bm>, the size of the smallest one with at least <count>
+// numbers (0 if there is none) and the size of the largest one
+static size_t free_ranges(const m3::Bitmap &bm, uint32_t total, size_t count, size_t *best,
+                          size_t *largest) {
+    size_t ranges = 0;
+    *best = *largest = 0;
+    for(uint32_t i = bm.find(0, total, false); i < total; ) {
+        uint32_t used = bm.find(i, total, true);
+        size_t len = used - i;
+        if(len >= count && (*best == 0 || len < *best))
+            *best = len;
+        if(len > *largest)
+            *largest = len;
+        ranges++;
+        i = bm.find(used, total, false);
+    }
+    return ranges;
+}
+
+// builds an index from <bm> in parts of <part> bits, like Allocator::build, and checks that it
+// contains exactly the maximal free ranges of <bm>
+static void check_build(m3::Bitmap &bm, uint32_t total, uint32_t part, size_t ranges) {
+    FreeExtents built;
+    for(uint32_t base = 0; base < total; base += part) {
+        m3::Bitmap bits(bm.bytes() + base / m3::Bitmap::WORD_BITS);
+        built.add_free(bits, base, total - base < part ? total - base : part);
+    }
+    CHECK(built.extents() == ranges);
+    CHECK(built.first(total) == bm.find(0, total, false));
+
+    // taking more than available returns the largest range as a whole
+    size_t found = 0;
+    while(true) {
+        size_t count = total;
+        uint32_t start = built.take(&count);
+        if(count == 0)
+            break;
+        CHECK(bm.find(start, total, true) == start + count);
+        CHECK(start == 0 || bm.is_set(start - 1));
+        found++;
+    }
+    CHECK(found == ranges);
+}
+
+// allocates and frees random ranges and compares the index with a plain bitmap
+static void free_extents_aging() {
+    // not a multiple of the part size to have a partial last bitmap block
+    const uint32_t TOTAL        = 5000;
+    const uint32_t PART         = 1024;
+    const size_t ROUNDS         = 20000;
+    const size_t CHECK_INTERVAL = 500;
+    const size_t MAX_ALLOCS     = 1024;
+
+    m3::Bitmap bm(TOTAL);
+    FreeExtents index;
+    index.add(0, TOTAL);
+
+    uint32_t alloc_start[MAX_ALLOCS];
+    size_t alloc_count[MAX_ALLOCS];
+    size_t allocs = 0;
+    size_t used = 0;
+    size_t partial = 0;
+
+    srand(1);
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        // allocate more often while less is used to stay at about 90% usage
+        bool alloc = static_cast<size_t>(rand()) % TOTAL + used < TOTAL * 7 / 5;
+        if(allocs == 0 || (allocs < MAX_ALLOCS && alloc)) {
+            size_t req = 1 + static_cast<size_t>(rand()) % 64;
+            size_t best, largest;
+            free_ranges(bm, TOTAL, req, &best, &largest);
+
+            size_t count = req;
+            uint32_t start = index.take(&count);
+            if(count == 0) {
+                CHECK(largest == 0);
+                continue;
+            }
+
+            // best fit, or the largest range if none is large enough
+            CHECK(count == (best ? req : largest));
+            if(!best)
+                partial++;
+            CHECK(start == 0 || bm.is_set(start - 1));
+            CHECK(bm.find(start, TOTAL, true) - start == (best ? best : largest));
+            for(uint32_t i = start; i < start + count; ++i)
+                bm.set(i);
+            used += count;
+
+            alloc_start[allocs] = start;
+            alloc_count[allocs++] = count;
+        }
+        else {
+            size_t idx = static_cast<size_t>(rand()) % allocs;
+            for(uint32_t i = alloc_start[idx]; i < alloc_start[idx] + alloc_count[idx]; ++i)
+                bm.unset(i);
+            index.add(alloc_start[idx], alloc_count[idx]);
+            used -= alloc_count[idx];
+
+            alloc_start[idx] = alloc_start[--allocs];
+            alloc_count[idx] = alloc_count[allocs];
+        }
+
+        if(round % CHECK_INTERVAL == 0 || round == ROUNDS - 1) {
+            size_t best, largest;
+            size_t ranges = free_ranges(bm, TOTAL, 1, &best, &largest);
+            CHECK(index.extents() == ranges);
+            CHECK(index.first(TOTAL) == bm.find(0, TOTAL, false));
+            check_build(bm, TOTAL, PART, ranges);
+        }
+    }
+
+    printf("  %zu of %u numbers used in %zu free ranges after aging; %zu partial allocations\n",
+           used, TOTAL, index.extents(), partial);
+}
+
+#define RUN_TEST(name) do {                                             \
+        printf("Running %s...\n", #name);                               \
+        name();                                                         \
+    } while(0)
+
+int main() {
+    RUN_TEST(journal_replay_twice);
+    RUN_TEST(journal_skip_written_back);
+    RUN_TEST(journal_checkpoint_runs);
+    RUN_TEST(journal_large_transaction);
+    RUN_TEST(free_extents_aging);
+
+    if(failures > 0)
+        errx(1, "%d checks failed", failures);
+    printf("All tests passed\n");
+    return 0;
+}
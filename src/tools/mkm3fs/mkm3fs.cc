@@ -45,6 +45,9 @@
 enum {
     MAX_BLOCKS      = 1024 * 1024,
     MAX_INODES      = 4096,
+    // two slots for the metadata journal. m3fs commits its whole meta buffer (512 blocks) in one
+    // transaction, which needs 520 blocks per slot including the header with 1 KiB blocks
+    JOURNAL_BLOCKS  = 1040,
 };
 
 m3::SuperBlock sb;
@@ -182,6 +185,108 @@ static m3::DirEntry *write_dirent(m3::INode *dir, m3::DirEntry *prev, const char
     return entry;
 }
 
+struct Entry {
+    char *name;
+    m3::inodeno_t inode;
+};
+
+static bool write_index(const char *path, m3::INode *dir, m3::blockno_t first,
+                        const Entry *ents, size_t count) {
+    // determine the number of blocks the directory would need without index
+    size_t blocks = 1, off = 0;
+    for(size_t i = 0; i < count; ++i) {
+        size_t len = sizeof(m3::DirEntry) + strlen(ents[i].name);
+        if(off + len > sb.blocksize) {
+            blocks++;
+            off = 0;
+        }
+        off += len;
+    }
+    if(blocks <= m3::DirIndex::MIN_BLOCKS)
+        return false;
+
+    // find the smallest number of buckets that can hold all entries. the first two entries are
+    // "." and "..", which are stored in the first block.
+    uint32_t depth = 0;
+    while((static_cast<size_t>(1) << depth) < blocks)
+        depth++;
+    size_t *used = nullptr;
+    for(; depth <= m3::DirIndex::max_depth(sb.blocksize); ++depth) {
+        size_t mask = (static_cast<size_t>(1) << depth) - 1;
+        used = static_cast<size_t*>(calloc(mask + 1, sizeof(size_t)));
+        if(!used)
+            err(1, "calloc failed");
+        size_t i;
+        for(i = 2; i < count; ++i) {
+            size_t len = strlen(ents[i].name);
+            size_t slot = m3::DirIndex::hash(ents[i].name, len) & mask;
+            used[slot] += sizeof(m3::DirEntry) + len;
+            if(used[slot] > sb.blocksize)
+                break;
+        }
+        free(used);
+        if(i == count)
+            break;
+    }
+    if(depth > m3::DirIndex::max_depth(sb.blocksize))
+        return false;
+
+    size_t slots = static_cast<size_t>(1) << depth;
+    char *buffer = static_cast<char*>(calloc(1, sb.blocksize));
+    if(!buffer)
+        err(1, "calloc failed");
+
+    // the first block contains "." and "..", which spans the block, and the index behind it
+    m3::DirEntry *dot = reinterpret_cast<m3::DirEntry*>(buffer);
+    dot->nodeno = ents[0].inode;
+    dot->namelen = 1;
+    dot->next = sizeof(m3::DirEntry) + 1;
+    memcpy(dot->name, ".", 1);
+    m3::DirEntry *dotdot = reinterpret_cast<m3::DirEntry*>(buffer + dot->next);
+    dotdot->nodeno = ents[1].inode;
+    dotdot->namelen = 2;
+    dotdot->next = sb.blocksize - dot->next;
+    memcpy(dotdot->name, "..", 2);
+
+    m3::DirIndex *idx = reinterpret_cast<m3::DirIndex*>(buffer + m3::DirIndex::OFFSET);
+    idx->magic = m3::DirIndex::MAGIC;
+    idx->depth = depth;
+    for(size_t s = 0; s < slots; ++s) {
+        bool new_ext = blks_per_extent > 0 && ((dir->size / sb.blocksize) % blks_per_extent) == 0;
+        idx->buckets[s] = store_blockno(path, dir, alloc_block(new_ext), new_ext);
+    }
+    PRINT("Writing index of %s with %zu buckets to %u\n", path, slots, first);
+    write_to_block(buffer, sb.blocksize, first);
+
+    // write the buckets; an entry without name marks an empty one
+    m3::blockno_t *buckets = new m3::blockno_t[slots];
+    memcpy(buckets, idx->buckets, slots * sizeof(m3::blockno_t));
+    for(size_t s = 0; s < slots; ++s) {
+        memset(buffer, 0, sb.blocksize);
+        m3::DirEntry *last = reinterpret_cast<m3::DirEntry*>(buffer);
+        size_t off = 0;
+        for(size_t i = 2; i < count; ++i) {
+            size_t len = strlen(ents[i].name);
+            if((m3::DirIndex::hash(ents[i].name, len) & (slots - 1)) != s)
+                continue;
+
+            last = reinterpret_cast<m3::DirEntry*>(buffer + off);
+            last->nodeno = ents[i].inode;
+            last->namelen = len;
+            last->next = sizeof(m3::DirEntry) + len;
+            memcpy(last->name, ents[i].name, len);
+            off += last->next;
+        }
+        last->next += sb.blocksize - off;
+        write_to_block(buffer, sb.blocksize, buckets[s]);
+    }
+
+    dir->flags |= m3::INODE_INDEXED;
+    delete[] buckets;
+    free(buffer);
+    return true;
+}
+
 static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
     static char buffer[m3::MAX_BLOCK_SIZE];
     struct stat st;
@@ -201,6 +306,7 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
     ino.inode = next_ino++;
     // TODO don't copy the number of links
     ino.links = st.st_nlink;
+    ino.flags = 0;
     ino.mode = st.st_mode;
     ino.lastaccess = static_cast<m3::time_t>(st.st_atim.tv_sec);
     ino.lastmod = static_cast<m3::time_t>(st.st_mtim.tv_sec);
@@ -229,9 +335,6 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
         if(!d)
             err(1, "opendir of '%s' failed", path);
 
-        struct dirent *e;
-        size_t diroff = 0;
-        m3::DirEntry *prev = nullptr, *newent = nullptr;
         m3::blockno_t block = alloc_block(false);
         ino.size = sb.blocksize;
 
@@ -239,35 +342,61 @@ static m3::inodeno_t copy(const char *path, m3::inodeno_t parent, int level) {
         ino.direct[0].start = block;
         ino.direct[0].length = 1;
 
+        // "." and ".." come first, because indexed directories store the index behind them
+        size_t count = 2, size = 16;
+        Entry *ents = static_cast<Entry*>(malloc(size * sizeof(Entry)));
+        if(!ents)
+            err(1, "malloc failed");
+        ents[0].name = strdup(".");
+        ents[0].inode = ino.inode;
+        ents[1].name = strdup("..");
+        ents[1].inode = parent;
+
+        struct dirent *e;
         while((e = readdir(d))) {
-            if(newent) {
-                free(prev);
-                prev = newent;
+            if(strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+
+            char *epath = new char[strlen(path) + strlen(e->d_name) + 2];
+            sprintf(epath, "%s/%s", path, e->d_name);
+            m3::inodeno_t inode = copy(epath, ino.inode, level + 1);
+            delete[] epath;
+
+            if(count == size) {
+                size *= 2;
+                ents = static_cast<Entry*>(realloc(ents, size * sizeof(Entry)));
+                if(!ents)
+                    err(1, "realloc failed");
             }
+            ents[count].name = strdup(e->d_name);
+            ents[count].inode = inode;
+            count++;
+        }
+        closedir(d);
 
-            m3::inodeno_t inode;
-            if(strcmp(e->d_name, ".") == 0)
-                inode = ino.inode;
-            else if(strcmp(e->d_name, "..") == 0)
-                inode = parent;
-            else {
-                char *epath = new char[strlen(path) + strlen(e->d_name) + 2];
-                sprintf(epath, "%s/%s", path, e->d_name);
-                inode = copy(epath, ino.inode, level + 1);
-                delete[] epath;
+        if(!write_index(path, &ino, block, ents, count)) {
+            size_t diroff = 0;
+            m3::DirEntry *prev = nullptr, *newent = nullptr;
+            for(size_t i = 0; i < count; ++i) {
+                if(newent) {
+                    free(prev);
+                    prev = newent;
+                }
+                newent = write_dirent(&ino, prev, path, ents[i].name, ents[i].inode, diroff, block);
             }
 
-            newent = write_dirent(&ino, prev, path, e->d_name, inode, diroff, block);
-        }
+            // set next of last entry to the end of the block
+            size_t newentlen = newent->next;
+            newent->next += sb.blocksize - diroff;
+            write_to_block(newent, newentlen, block, diroff - newentlen);
 
-        // set next of last entry to the end of the block
-        size_t newentlen = newent->next;
-        newent->next += sb.blocksize - diroff;
-        write_to_block(newent, newentlen, block, diroff - newentlen);
+            free(newent);
+            free(prev);
+        }
 
-        free(newent);
-        free(prev);
-        closedir(d);
+        for(size_t i = 0; i < count; ++i)
+            free(ents[i].name);
+        free(ents);
     }
     else
         fprintf(stderr, "Warning: ignored file '%s' (no regular file or directory)\n", path);
@@ -301,6 +430,7 @@ int main(int argc,char **argv) {
     sb.total_inodes = strtoul(argv[4], nullptr, 0);
     sb.free_blocks = sb.total_blocks;
     sb.free_inodes = sb.total_inodes;
+    sb.journal_blocks = JOURNAL_BLOCKS;
     blks_per_extent = strtoul(argv[5], nullptr, 0);
     use_rand = argc == 7 && strcmp(argv[6], "-rand");
     last_block = sb.first_data_block() - 1;
@@ -319,10 +449,10 @@ int main(int argc,char **argv) {
     if(!file)
         err(1, "Unable to open '%s' for writing", argv[1]);
 
-    // first, init the fs-image with zeros
+    // first, init the fs-image with zeros, which leaves an empty journal behind
     ftruncate(fileno(file), static_cast<off_t>(sb.blocksize * sb.total_blocks));
 
-    // mark superblock, inode and block bitmap and inode blocks as occupied
+    // mark superblock, inode and block bitmap, inode blocks and journal as occupied
     for(m3::blockno_t i = 0; i < sb.first_data_block(); ++i)
         block_bitmap->set(i);
     sb.free_blocks -= sb.first_data_block();
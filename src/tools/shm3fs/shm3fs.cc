@@ -39,6 +39,7 @@ static void print_sb() {
     printf("  free_blocks: %u\n", sb.free_blocks);
     printf("  first_free_inode: %u\n", sb.first_free_inode);
     printf("  first_free_block: %u\n", sb.first_free_block);
+    printf("  journal_blocks: %u\n", sb.journal_blocks);
 }
 
 static void print_bitmap(uint32_t total, const m3::Bitmap &bitmap) {
@@ -99,6 +100,7 @@ static void print_inode(m3::inodeno_t ino, bool all) {
     printf("  inode: %u\n", inode.inode);
     printf("  mode: %#04o\n", inode.mode);
     printf("  links: %u\n", inode.links);
+    printf("  flags: %#x%s\n", inode.flags, (inode.flags & m3::INODE_INDEXED) ? " (indexed)" : "");
     printf("  size: %" PRIu64 "\n", inode.size);
     print_time(inode.lastaccess, "lastaccess");
     print_time(inode.lastmod, "lastmod");